@@ -0,0 +1,159 @@
+// Microbenchmark: GameObject::GetComponent<T>() cost for 1-16 components per object.
+// Compares the previous lookups (type_index hash cache and the const overload's
+// dynamic_cast scan) against the type-id bitmask + slot table.
+//
+// Usage: component_lookup_bench [objects]   (default 4096)
+#include "engine/component.h"
+#include "engine/game_object.h"
+#include "engine/scene.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <typeindex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+template <int I>
+struct BenchComponent : Component
+{
+    int value = I + 1;
+};
+
+// Replica of the lookup GameObject used before component type ids
+struct LegacyObject
+{
+    std::vector<std::unique_ptr<Component>> components;
+    std::unordered_map<std::type_index, Component *> cache;
+
+    template <typename T>
+    void Add()
+    {
+        components.push_back(std::make_unique<T>());
+        cache.emplace(std::type_index(typeid(T)), components.back().get());
+    }
+
+    template <typename T>
+    T *GetCached()
+    {
+        auto it = cache.find(std::type_index(typeid(T)));
+        return it != cache.end() ? static_cast<T *>(it->second) : nullptr;
+    }
+
+    template <typename T>
+    const T *GetScanned() const
+    {
+        for (const auto &c : components)
+        {
+            if (auto casted = dynamic_cast<const T *>(c.get()))
+            {
+                return casted;
+            }
+        }
+        return nullptr;
+    }
+};
+
+template <typename Fn>
+static double BestOfMs(int runs, Fn &&fn)
+{
+    double best = 1e30;
+    for (int r = 0; r < runs; ++r)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        fn();
+        const auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    return best;
+}
+
+template <size_t... I>
+static void AddAll(LegacyObject &legacy, GameObject &object, std::index_sequence<I...>)
+{
+    (legacy.Add<BenchComponent<I>>(), ...);
+    (object.AddComponent<BenchComponent<I>>(), ...);
+}
+
+// Each lookup function visits every component type of one object
+template <size_t... I>
+static int LookupCached(LegacyObject &o, std::index_sequence<I...>)
+{
+    return (o.GetCached<BenchComponent<I>>()->value + ...);
+}
+
+template <size_t... I>
+static int LookupScanned(const LegacyObject &o, std::index_sequence<I...>)
+{
+    return (o.GetScanned<BenchComponent<I>>()->value + ...);
+}
+
+template <size_t... I>
+static int LookupTypeId(const GameObject &o, std::index_sequence<I...>)
+{
+    return (o.GetComponent<BenchComponent<I>>()->value + ...);
+}
+
+template <size_t N>
+static void RunCase(size_t object_count, int runs)
+{
+    const auto types = std::make_index_sequence<N>{};
+    Scene scene;
+    std::vector<LegacyObject> legacy(object_count);
+    std::vector<GameObject *> objects(object_count);
+    for (size_t i = 0; i < object_count; ++i)
+    {
+        objects[i] = &scene.CreateObject();
+        AddAll(legacy[i], *objects[i], types);
+    }
+
+    volatile int sink = 0;
+    const double cached_ms = BestOfMs(runs, [&]()
+    {
+        int sum = 0;
+        for (LegacyObject &o : legacy)
+            sum += LookupCached(o, types);
+        sink = sink + sum;
+    });
+    const double scanned_ms = BestOfMs(runs, [&]()
+    {
+        int sum = 0;
+        for (const LegacyObject &o : legacy)
+            sum += LookupScanned(o, types);
+        sink = sink + sum;
+    });
+    const double type_id_ms = BestOfMs(runs, [&]()
+    {
+        int sum = 0;
+        for (const GameObject *o : objects)
+            sum += LookupTypeId(*o, types);
+        sink = sink + sum;
+    });
+
+    const double lookups = static_cast<double>(object_count * N);
+    std::printf("%3zu  %12.2f  %12.2f  %12.2f  %8.1fx  %8.1fx\n", N,
+                cached_ms * 1e6 / lookups, scanned_ms * 1e6 / lookups, type_id_ms * 1e6 / lookups,
+                cached_ms / type_id_ms, scanned_ms / type_id_ms);
+}
+
+template <size_t... N>
+static void RunCases(size_t object_count, int runs, std::index_sequence<N...>)
+{
+    (RunCase<N + 1>(object_count, runs), ...);
+}
+
+int main(int argc, char **argv)
+{
+    const size_t object_count = argc > 1 ? static_cast<size_t>(std::strtoul(argv[1], nullptr, 10)) : 4096;
+    const int runs = 20;
+#ifndef NDEBUG
+    std::printf("warning: built without NDEBUG; numbers are not representative\n");
+#endif
+
+    std::printf("%zu objects, best of %d runs, ns per GetComponent\n\n", object_count, runs);
+    std::printf("%3s  %12s  %12s  %12s  %9s  %9s\n", "N", "hash cache", "dynamic_cast", "type id", "vs hash", "vs cast");
+    RunCases(object_count, runs, std::make_index_sequence<GameObject::kMaxComponentsPerObject>{});
+    return 0;
+}
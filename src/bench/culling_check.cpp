@@ -0,0 +1,62 @@
+// Check: CullingSystem keeps drawing a renderer whose mesh has its own instance
+// buffer when the owner's bounds are outside the frustum, while a plain renderer
+// at the same place is culled. Meshes are default-constructed, so their bounds
+// are empty and the frustum rejects them wherever they are. Runs headless (no GL
+// context needed).
+//
+// Usage: culling_check
+#include "engine/culling_system.h"
+#include "engine/game_object.h"
+#include "engine/scene.h"
+#include "engine/transform.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+static GameObject &AddRenderer(Scene &scene, const std::shared_ptr<Mesh> &mesh)
+{
+    GameObject &object = scene.CreateObject();
+    // Far behind the camera
+    object.AddComponent<Transform>()->SetPosition(glm::vec3(0.0f, 0.0f, 1000.0f));
+    object.AddComponent<MeshRenderer>(mesh, std::shared_ptr<Shader>());
+    return object;
+}
+
+int main()
+{
+    Scene scene;
+    auto plain_mesh = std::make_shared<Mesh>();
+    auto instanced_mesh = std::make_shared<Mesh>();
+    instanced_mesh->instance_id = 1;
+    GameObject &plain = AddRenderer(scene, plain_mesh);
+    GameObject &instanced = AddRenderer(scene, instanced_mesh);
+
+    const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 1.0f, 0.1f, 100.0f);
+    const glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    ComponentStorage<MeshRenderer> &renderers = scene.GetComponentRegistry().Storage<MeshRenderer>();
+    CullingSystem culling;
+    bool ok = true;
+    // The first Cull builds the BVH, the second only refreshes it
+    for (int frame = 0; frame < 2; ++frame)
+    {
+        const std::vector<uint32_t> &visible = culling.Cull(renderers, projection * view);
+        auto drawn = [&](GameObject &object)
+        {
+            const uint32_t slot = object.GetComponent<MeshRenderer>()->StorageIndex();
+            return std::find(visible.begin(), visible.end(), slot) != visible.end();
+        };
+        const bool plain_drawn = drawn(plain);
+        const bool instanced_drawn = drawn(instanced);
+        std::printf("frame %d: plain %s, instanced %s\n", frame, plain_drawn ? "drawn" : "culled",
+                    instanced_drawn ? "drawn" : "culled");
+        ok = ok && !plain_drawn && instanced_drawn;
+    }
+    if (!ok)
+    {
+        std::printf("error: an instanced renderer was culled by its owner's bounds\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,122 @@
+// Microbenchmark: LOD chain generation and the triangles it saves. Simplifies a
+// bumpy UV sphere (with a UV seam, like most imported models) into a chain, then
+// counts the triangles the lotsacats scene (100x100 grid, same camera) would
+// submit after frustum culling, with and without LOD selection.
+// Runs headless (no GL context needed).
+//
+// Usage: lod_bench [rings]   (default 160; the sphere has 4 * rings^2 triangles)
+#include "engine/frustum.h"
+#include "engine/mesh_lod.h"
+#include "engine/mesh_simplifier.h"
+#include "engine/transform.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+static void BuildBumpySphere(int rings, std::vector<MeshVertex> &vertices, std::vector<unsigned int> &indices)
+{
+    const int segments = rings * 2;
+    const float pi = 3.14159265f;
+    for (int r = 0; r <= rings; ++r)
+    {
+        for (int s = 0; s <= segments; ++s)
+        {
+            const float theta = pi * r / rings;
+            const float phi = 2.0f * pi * s / segments;
+            const glm::vec3 dir(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+            const float bump = 1.0f + 0.05f * std::sin(5.0f * phi) * std::sin(7.0f * theta);
+            MeshVertex v{};
+            v.position = dir * 0.4f * bump;
+            v.normal = dir;
+            v.uv = glm::vec2(float(s) / segments, float(r) / rings);
+            vertices.push_back(v);
+        }
+    }
+    for (int r = 0; r < rings; ++r)
+    {
+        for (int s = 0; s < segments; ++s)
+        {
+            const unsigned int i = static_cast<unsigned int>(r * (segments + 1) + s);
+            const unsigned int next = i + static_cast<unsigned int>(segments + 1);
+            const unsigned int quad[] = {i, i + 1, next, i + 1, next + 1, next};
+            indices.insert(indices.end(), std::begin(quad), std::end(quad));
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const int rings = argc > 1 ? std::max(4, std::atoi(argv[1])) : 160;
+#ifndef NDEBUG
+    std::printf("warning: built without NDEBUG; numbers are not representative\n");
+#endif
+
+    std::vector<MeshVertex> vertices;
+    std::vector<unsigned int> indices;
+    BuildBumpySphere(rings, vertices, indices);
+
+    // Same chain LodGroup::Generate would build, kept on the CPU
+    const LodSettings settings;
+    LodGroup lods;
+    std::vector<size_t> level_triangles = {indices.size() / 3};
+    lods.AddLevel(MeshLod{nullptr, 0.0f, 0.0f});
+    std::printf("level  triangles  error   simplify ms\n");
+    std::printf("%5d  %9zu  %.4f  %11s\n", 0, level_triangles[0], 0.0f, "-");
+    for (int level = 1; level < settings.max_levels; ++level)
+    {
+        std::vector<MeshVertex> out_vertices;
+        std::vector<unsigned int> out_indices;
+        const size_t target = static_cast<size_t>(level_triangles.back() * settings.triangle_ratio);
+        const auto start = std::chrono::steady_clock::now();
+        const float error = MeshSimplifier::Simplify(vertices, indices, target * 3, settings.max_error, out_vertices,
+                                                     out_indices);
+        const auto end = std::chrono::steady_clock::now();
+        if (out_indices.size() / 3 > level_triangles.back() * (1.0f + settings.triangle_ratio) * 0.5f)
+            break;
+        std::printf("%5d  %9zu  %.4f  %11.1f\n", level, out_indices.size() / 3, error,
+                    std::chrono::duration<double, std::milli>(end - start).count());
+        level_triangles.push_back(out_indices.size() / 3);
+        lods.AddLevel(MeshLod{nullptr, 0.0f, error});
+    }
+    lods.AssignScreenSizes(settings.first_screen_size, settings.screen_size_ratio);
+
+    // lotsacats: cats on a 100x100 grid, camera at (0, 30, -30) pitched down 45 degrees
+    Transform camera;
+    camera.SetPosition(glm::vec3(0.0f, 30.0f, -30.0f));
+    camera.SetEulerAngles(glm::vec3(-45.0f, 180.0f, 0.0f));
+    const glm::mat4 view = glm::inverse(camera.LocalToWorld());
+    const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 1.0f, 0.1f, 2000.0f);
+    const Frustum frustum = Frustum::FromMatrix(projection * view);
+    const Aabb local_bounds = Mesh::ComputeBounds(vertices);
+
+    std::vector<size_t> per_level(lods.LevelCount(), 0);
+    size_t visible = 0;
+    size_t full_triangles = 0;
+    size_t lod_triangles = 0;
+    for (int i = 0; i < 100; ++i)
+    {
+        for (int j = 0; j < 100; ++j)
+        {
+            const glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(i - 50.0f, 0.0f, float(j)));
+            if (!frustum.Intersects(local_bounds.Transformed(model)))
+                continue;
+            ++visible;
+            const float size = LodGroup::ScreenSize(local_bounds, model, view, projection);
+            const size_t level = lods.Select(size, 0);
+            ++per_level[level];
+            full_triangles += level_triangles[0];
+            lod_triangles += level_triangles[level];
+        }
+    }
+
+    std::printf("\n%zu visible cats, per level:", visible);
+    for (size_t count : per_level)
+        std::printf(" %zu", count);
+    std::printf("\ntriangles submitted: %zu without LOD, %zu with LOD (%.1fx fewer)\n", full_triangles, lod_triangles,
+                lod_triangles ? double(full_triangles) / double(lod_triangles) : 0.0);
+    return 0;
+}
@@ -0,0 +1,153 @@
+// Microbenchmark: post-import mesh optimization. Builds a bumpy UV sphere,
+// shuffles its triangles and vertices (the worst case an exporter can hand
+// over), then runs MeshOptimizer and prints ACMR/ATVR, overdraw and overfetch
+// after each step, plus the time each step takes. The sphere's own ring order
+// is measured too, as a reference for an already reasonable layout. Last, a
+// mesh with degenerate triangles (as JoinIdenticalVertices can leave) is run
+// through every step to check no triangle is lost.
+// Runs headless (no GL context needed).
+//
+// Usage: mesh_optimizer_bench [rings]   (default 100; the sphere has 4 * rings^2 triangles)
+#include "engine/mesh_optimizer.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <numeric>
+#include <random>
+#include <vector>
+
+static void BuildBumpySphere(int rings, std::vector<MeshVertex> &vertices, std::vector<unsigned int> &indices)
+{
+    const int segments = rings * 2;
+    const float pi = 3.14159265f;
+    for (int r = 0; r <= rings; ++r)
+    {
+        for (int s = 0; s <= segments; ++s)
+        {
+            const float theta = pi * r / rings;
+            const float phi = 2.0f * pi * s / segments;
+            const glm::vec3 dir(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+            const float bump = 1.0f + 0.05f * std::sin(5.0f * phi) * std::sin(7.0f * theta);
+            MeshVertex v{};
+            v.position = dir * 0.4f * bump;
+            v.normal = dir;
+            v.uv = glm::vec2(float(s) / segments, float(r) / rings);
+            vertices.push_back(v);
+        }
+    }
+    for (int r = 0; r < rings; ++r)
+    {
+        for (int s = 0; s < segments; ++s)
+        {
+            const unsigned int i = static_cast<unsigned int>(r * (segments + 1) + s);
+            const unsigned int next = i + static_cast<unsigned int>(segments + 1);
+            // Counter-clockwise seen from outside
+            const unsigned int quad[] = {i, i + 1, next, i + 1, next + 1, next};
+            indices.insert(indices.end(), std::begin(quad), std::end(quad));
+        }
+    }
+}
+
+// Same triangles, in random order and with randomly numbered vertices
+static void Shuffle(std::vector<MeshVertex> &vertices, std::vector<unsigned int> &indices)
+{
+    std::mt19937 random(42);
+    std::vector<size_t> triangles(indices.size() / 3);
+    std::iota(triangles.begin(), triangles.end(), size_t(0));
+    std::shuffle(triangles.begin(), triangles.end(), random);
+    std::vector<unsigned int> remap(vertices.size());
+    std::iota(remap.begin(), remap.end(), 0u);
+    std::shuffle(remap.begin(), remap.end(), random);
+
+    std::vector<MeshVertex> shuffled_vertices(vertices.size());
+    for (size_t v = 0; v < vertices.size(); ++v)
+        shuffled_vertices[remap[v]] = vertices[v];
+    std::vector<unsigned int> shuffled_indices;
+    shuffled_indices.reserve(indices.size());
+    for (size_t t : triangles)
+    {
+        for (size_t k = 0; k < 3; ++k)
+            shuffled_indices.push_back(remap[indices[t * 3 + k]]);
+    }
+    vertices.swap(shuffled_vertices);
+    indices.swap(shuffled_indices);
+}
+
+template <typename Fn>
+static double Ms(Fn &&fn)
+{
+    const auto start = std::chrono::steady_clock::now();
+    fn();
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+static void PrintStats(const char *label, const MeshDrawStats &stats, double ms)
+{
+    std::printf("  %-14s acmr %.3f  atvr %.3f  overdraw %.3f  overfetch %.3f", label, stats.acmr, stats.atvr,
+                stats.overdraw, stats.overfetch);
+    if (ms >= 0.0)
+        std::printf("   %8.2f ms", ms);
+    std::printf("\n");
+}
+
+// Every step must keep every triangle, degenerate ones included
+static bool KeepsDegenerates()
+{
+    std::vector<MeshVertex> vertices(4);
+    for (size_t v = 0; v < vertices.size(); ++v)
+        vertices[v].position = glm::vec3(static_cast<float>(v & 1), static_cast<float>(v >> 1), 0.0f);
+    const std::vector<unsigned int> source = {0, 0, 1, 0, 1, 2, 1, 3, 2};
+    // The degenerate leading the order is the case that used to lose triangles
+    std::vector<unsigned int> direct = source;
+    MeshOptimizer::OptimizeOverdraw(direct, vertices);
+    std::printf("degenerate first, overdraw step alone: %zu indices -> %zu\n", source.size(), direct.size());
+
+    std::vector<unsigned int> indices = source;
+    MeshOptimizer::OptimizeVertexCache(indices, vertices.size());
+    const size_t after_cache = indices.size();
+    MeshOptimizer::OptimizeOverdraw(indices, vertices);
+    const size_t after_overdraw = indices.size();
+    MeshOptimizer::OptimizeVertexFetch(vertices, indices);
+    std::printf("degenerate first, every step: %zu indices -> %zu (cache) -> %zu (overdraw) -> %zu (fetch)\n", source.size(),
+                after_cache, after_overdraw, indices.size());
+    return direct.size() == source.size() && after_cache == source.size() && after_overdraw == source.size() && indices.size() == source.size();
+}
+
+int main(int argc, char **argv)
+{
+    const int rings = argc > 1 ? std::max(4, std::atoi(argv[1])) : 100;
+#ifndef NDEBUG
+    std::printf("warning: built without NDEBUG; numbers are not representative\n");
+#endif
+
+    std::vector<MeshVertex> vertices;
+    std::vector<unsigned int> indices;
+    BuildBumpySphere(rings, vertices, indices);
+    std::printf("sphere: %zu triangles, %zu vertices, FIFO cache of %u\n", indices.size() / 3, vertices.size(),
+                MeshOptimizer::kVertexCacheSize);
+    PrintStats("ring order", MeshOptimizer::Analyze(vertices, indices), -1.0);
+
+    Shuffle(vertices, indices);
+    PrintStats("shuffled", MeshOptimizer::Analyze(vertices, indices), -1.0);
+
+    const double cache_ms = Ms([&]() { MeshOptimizer::OptimizeVertexCache(indices, vertices.size()); });
+    PrintStats("vertex cache", MeshOptimizer::Analyze(vertices, indices), cache_ms);
+    const double overdraw_ms = Ms([&]() { MeshOptimizer::OptimizeOverdraw(indices, vertices); });
+    PrintStats("overdraw", MeshOptimizer::Analyze(vertices, indices), overdraw_ms);
+    const double fetch_ms = Ms([&]() { MeshOptimizer::OptimizeVertexFetch(vertices, indices); });
+    PrintStats("vertex fetch", MeshOptimizer::Analyze(vertices, indices), fetch_ms);
+
+    MeshDrawStats analyzed;
+    const double analyze_ms = Ms([&]() { analyzed = MeshOptimizer::Analyze(vertices, indices); });
+    std::printf("one Analyze: %.2f ms\n", analyze_ms);
+
+    if (!KeepsDegenerates())
+    {
+        std::printf("error: triangles lost\n");
+        return 1;
+    }
+    return 0;
+}
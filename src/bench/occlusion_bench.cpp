@@ -0,0 +1,148 @@
+// Microbenchmark: CPU occlusion buffer. Rasterizes a subdivided wall and tests a
+// field of boxes, half of them hidden behind it, with and without the job system.
+// Last, checks that a box showing through the uncovered part of a pixel on an
+// occluder's edge is not culled. Runs headless (no GL context needed).
+//
+// Usage: occlusion_bench [boxes] [wall_subdivisions]   (default 10000, 32)
+#include "engine/job_system.h"
+#include "engine/occlusion_buffer.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+template <typename Fn>
+static double BestOfMs(int runs, Fn &&fn)
+{
+    double best = 1e30;
+    for (int r = 0; r < runs; ++r)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        fn();
+        const auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    return best;
+}
+
+// Wall in the z = 0 plane covering [-10, 10] x [0, 10], split into n x n quads
+static void BuildWall(int n, std::vector<MeshVertex> &vertices, std::vector<unsigned int> &indices)
+{
+    for (int y = 0; y <= n; ++y)
+    {
+        for (int x = 0; x <= n; ++x)
+        {
+            MeshVertex v{};
+            v.position = glm::vec3(-10.0f + 20.0f * x / n, 10.0f * y / n, 0.0f);
+            vertices.push_back(v);
+        }
+    }
+    for (int y = 0; y < n; ++y)
+    {
+        for (int x = 0; x < n; ++x)
+        {
+            const unsigned int i = static_cast<unsigned int>(y * (n + 1) + x);
+            const unsigned int quad[] = {i, i + 1, i + n + 2, i, i + n + 2, i + n + 1};
+            indices.insert(indices.end(), std::begin(quad), std::end(quad));
+        }
+    }
+}
+
+// A quad whose right edge crosses pixel 40 of a 64x64 buffer three quarters of
+// the way in, drawn straight in clip space. A box behind it that only covers
+// the rest of that pixel must stay visible; one behind the middle of the quad
+// (across its diagonal) must be hidden.
+static bool KeepsEdgeBoxesVisible()
+{
+    OcclusionBuffer buffer(64, 64);
+    const float to_clip = 2.0f / static_cast<float>(buffer.Width());
+    const float edge = 40.75f * to_clip - 1.0f;
+    std::vector<MeshVertex> vertices(4);
+    vertices[0].position = glm::vec3(-1.0f, -1.0f, 0.0f);
+    vertices[1].position = glm::vec3(edge, -1.0f, 0.0f);
+    vertices[2].position = glm::vec3(edge, 1.0f, 0.0f);
+    vertices[3].position = glm::vec3(-1.0f, 1.0f, 0.0f);
+    const std::vector<unsigned int> indices = {0, 1, 2, 0, 2, 3};
+    OccluderMesh quad;
+    quad.vertices = vertices.data();
+    quad.indices = indices.data();
+    quad.index_count = indices.size();
+    buffer.Render(&quad, 1, glm::mat4(1.0f));
+
+    Aabb past_edge;
+    past_edge.min = glm::vec3(40.8f * to_clip - 1.0f, -0.2f, 0.4f);
+    past_edge.max = glm::vec3(40.95f * to_clip - 1.0f, 0.2f, 0.6f);
+    Aabb behind;
+    behind.min = glm::vec3(-0.5f, -0.2f, 0.4f);
+    behind.max = glm::vec3(-0.1f, 0.2f, 0.6f);
+    const bool past_edge_hidden = buffer.IsOccluded(past_edge);
+    const bool behind_hidden = buffer.IsOccluded(behind);
+    std::printf("\nbox just past an occluder edge: %s; box behind it: %s\n", past_edge_hidden ? "hidden" : "visible",
+                behind_hidden ? "hidden" : "visible");
+    return !past_edge_hidden && behind_hidden;
+}
+
+int main(int argc, char **argv)
+{
+    const size_t box_count = argc > 1 ? static_cast<size_t>(std::strtoul(argv[1], nullptr, 10)) : 10000;
+    const int subdivisions = argc > 2 ? std::max(1, std::atoi(argv[2])) : 32;
+    const int runs = 20;
+#ifndef NDEBUG
+    std::printf("warning: built without NDEBUG; numbers are not representative\n");
+#endif
+
+    std::vector<MeshVertex> vertices;
+    std::vector<unsigned int> indices;
+    BuildWall(subdivisions, vertices, indices);
+    OccluderMesh wall;
+    wall.vertices = vertices.data();
+    wall.indices = indices.data();
+    wall.index_count = indices.size();
+
+    // Boxes on a grid, half in front of the wall and half behind it
+    std::vector<Aabb> boxes(box_count);
+    const size_t side = static_cast<size_t>(std::max(1.0, std::sqrt(static_cast<double>(box_count / 2))));
+    for (size_t i = 0; i < box_count; ++i)
+    {
+        const size_t cell = i / 2;
+        const glm::vec3 center(-8.0f + 16.0f * static_cast<float>(cell % side) / side, 0.5f + 8.0f * static_cast<float>((cell / side) % side) / side,
+                               i % 2 ? -5.0f : 5.0f);
+        boxes[i].min = center - glm::vec3(0.2f);
+        boxes[i].max = center + glm::vec3(0.2f);
+    }
+    std::vector<uint8_t> occluded(box_count);
+
+    const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 200.0f);
+    const glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 5.0f, 20.0f), glm::vec3(0.0f, 5.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    const glm::mat4 view_projection = projection * view;
+
+    OcclusionBuffer buffer(320, 180);
+    JobSystem &jobs = JobSystem::GetInstance();
+    std::printf("%zu boxes, %zu occluder triangles, %dx%d buffer, %u workers, best of %d runs\n\n", box_count,
+                indices.size() / 3, buffer.Width(), buffer.Height(), jobs.WorkerCount(), runs);
+    std::printf("%-10s  %12s  %12s  %8s\n", "", "raster ms", "test ms", "hidden");
+
+    for (JobSystem *j : {static_cast<JobSystem *>(nullptr), &jobs})
+    {
+        const double raster_ms = BestOfMs(runs, [&]()
+        {
+            buffer.Render(&wall, 1, view_projection, j);
+        });
+        size_t hidden = 0;
+        const double test_ms = BestOfMs(runs, [&]()
+        {
+            hidden = buffer.TestBoxes(boxes.data(), boxes.size(), occluded.data(), j);
+        });
+        std::printf("%-10s  %12.3f  %12.3f  %8zu\n", j ? "jobs" : "serial", raster_ms, test_ms, hidden);
+    }
+
+    if (!KeepsEdgeBoxesVisible())
+    {
+        std::printf("error: edge coverage is not conservative\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,101 @@
+// Microbenchmark: Scene::Update with a component that opts into kParallelUpdate.
+// Every object turns its own Transform each frame; the scene is updated on the
+// calling thread alone and then with the job system, and the resulting world
+// matrices must match exactly. Runs headless (no GL context needed).
+//
+// Usage: parallel_update_bench [objects]   (default 100000)
+#include "engine/component.h"
+#include "engine/game_object.h"
+#include "engine/job_system.h"
+#include "engine/scene.h"
+#include "engine/transform.h"
+#include <glm/gtc/quaternion.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+// Some per-object math on top of the transform write, like a small animation
+struct Wobble : Component
+{
+    static constexpr bool kParallelUpdate = true;
+
+    float phase = 0.0f;
+    Transform *transform = nullptr;
+
+    void OnStart() override { transform = owner_->GetComponent<Transform>(); }
+
+    void OnUpdate(float time_seconds) override
+    {
+        const float t = time_seconds + phase;
+        const float angle = std::sin(t) * 0.5f + std::sin(t * 2.3f) * 0.25f;
+        transform->SetRotation(glm::angleAxis(angle, glm::vec3(0.0f, 1.0f, 0.0f)));
+        transform->SetScale(glm::vec3(1.0f + 0.1f * std::sin(t * 3.1f)));
+    }
+};
+
+static void Populate(Scene &scene, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        GameObject &object = scene.CreateObject();
+        object.AddComponent<Transform>()->SetPosition(glm::vec3(static_cast<float>(i % 1000), 0.0f, static_cast<float>(i / 1000)));
+        object.AddComponent<Wobble>()->phase = static_cast<float>(i) * 0.01f;
+    }
+}
+
+// Best frame time over `frames` updates, starting at time 0
+static double UpdateMs(Scene &scene, int frames)
+{
+    double best = 1e30;
+    for (int f = 0; f < frames; ++f)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        scene.Update(static_cast<float>(f) / 60.0f);
+        const auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    return best;
+}
+
+int main(int argc, char **argv)
+{
+    const size_t count = argc > 1 ? static_cast<size_t>(std::strtoul(argv[1], nullptr, 10)) : 100000;
+    const int frames = 20;
+#ifndef NDEBUG
+    std::printf("warning: built without NDEBUG; numbers are not representative\n");
+#endif
+
+    // At least one worker, so the parallel path runs even on a single core
+    JobSystem jobs(std::max(2u, std::thread::hardware_concurrency()) - 1u);
+    Scene serial;
+    Scene parallel;
+    parallel.SetJobSystem(&jobs);
+    Populate(serial, count);
+    Populate(parallel, count);
+
+    std::printf("%zu objects, %u workers, best of %d frames\n\n", count, jobs.WorkerCount(), frames);
+    const double serial_ms = UpdateMs(serial, frames);
+    const double parallel_ms = UpdateMs(parallel, frames);
+    std::printf("%-10s %9.3f ms\n", "serial", serial_ms);
+    std::printf("%-10s %9.3f ms  %6.2fx\n", "jobs", parallel_ms, serial_ms / parallel_ms);
+
+    // Both scenes ran the same frames, so every object must have ended up in the same place
+    const std::vector<GameObject *> &a = serial.GetGameObjects();
+    const std::vector<GameObject *> &b = parallel.GetGameObjects();
+    size_t mismatches = 0;
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+        if (a[i]->GetComponent<Transform>()->LocalToWorld() != b[i]->GetComponent<Transform>()->LocalToWorld())
+            ++mismatches;
+    }
+    if (mismatches > 0)
+    {
+        std::printf("error: %zu objects differ between serial and parallel updates\n", mismatches);
+        return 1;
+    }
+    return 0;
+}
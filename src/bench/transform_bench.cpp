@@ -0,0 +1,141 @@
+// Microbenchmark: world-matrix composition for many transforms.
+// Compares the legacy per-object glm::translate/rotate/scale chain, the cached
+// Transform::LocalToWorld path, and the batched TransformKernel paths.
+//
+// Usage: transform_bench [count]   (default 100000)
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include "engine/transform.h"
+#include "engine/transform_kernel.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+template <typename Fn>
+static double BestOfMs(int runs, Fn &&fn)
+{
+    double best = 1e30;
+    for (int r = 0; r < runs; ++r)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        fn();
+        const auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    return best;
+}
+
+static void Report(const char *name, double ms, size_t count, double baseline_ms)
+{
+    std::printf("%-28s %9.3f ms  %7.2f ns/transform  %6.2fx\n",
+                name, ms, ms * 1e6 / static_cast<double>(count), baseline_ms / ms);
+}
+
+int main(int argc, char **argv)
+{
+    const size_t count = argc > 1 ? static_cast<size_t>(std::strtoul(argv[1], nullptr, 10)) : 100000;
+    const int runs = 10;
+#ifndef NDEBUG
+    std::printf("warning: built without NDEBUG; numbers are not representative\n");
+#endif
+
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> pos(-50.0f, 50.0f);
+    std::uniform_real_distribution<float> ang(-180.0f, 180.0f);
+    std::uniform_real_distribution<float> scl(0.5f, 2.0f);
+
+    std::vector<glm::vec3> positions(count), eulers(count), scales(count);
+    std::vector<Transform> transforms(count);
+    std::vector<float> px(count), py(count), pz(count), qx(count), qy(count), qz(count), qw(count), sx(count), sy(count), sz(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        positions[i] = glm::vec3(pos(rng), pos(rng), pos(rng));
+        eulers[i] = glm::vec3(ang(rng), ang(rng), ang(rng));
+        scales[i] = glm::vec3(scl(rng), scl(rng), scl(rng));
+        Transform &t = transforms[i];
+        t.SetPosition(positions[i]);
+        t.SetEulerAngles(eulers[i]);
+        t.SetScale(scales[i]);
+        const glm::quat q = t.GetRotation();
+        px[i] = positions[i].x, py[i] = positions[i].y, pz[i] = positions[i].z;
+        qx[i] = q.x, qy[i] = q.y, qz[i] = q.z, qw[i] = q.w;
+        sx[i] = scales[i].x, sy[i] = scales[i].y, sz[i] = scales[i].z;
+    }
+    const TransformSoA soa{px.data(), py.data(), pz.data(), qx.data(), qy.data(), qz.data(), qw.data(),
+                           sx.data(), sy.data(), sz.data(), count};
+    std::vector<glm::mat4> out(count);
+    volatile float sink = 0.0f;
+
+    std::printf("%zu transforms, best of %d runs, kernel dispatch: %s\n\n", count, runs,
+                TransformKernel::PathName(TransformKernel::BestSupportedPath()));
+
+    // Pre-hierarchy Transform::LocalToWorld: Euler angles through glm::rotate every call
+    const double legacy_ms = BestOfMs(runs, [&]()
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            glm::mat4 m(1.0f);
+            m = glm::translate(m, positions[i]);
+            m = glm::rotate(m, glm::radians(eulers[i].y), glm::vec3(0, 1, 0));
+            m = glm::rotate(m, glm::radians(eulers[i].x), glm::vec3(1, 0, 0));
+            m = glm::rotate(m, glm::radians(eulers[i].z), glm::vec3(0, 0, 1));
+            m = glm::scale(m, scales[i]);
+            out[i] = m;
+        }
+        sink = sink + out[count / 2][3][0];
+    });
+    Report("legacy euler chain", legacy_ms, count, legacy_ms);
+
+    // Every transform dirtied each run so LocalToWorld has to recompute
+    float jitter = 0.0f;
+    const double cached_ms = BestOfMs(runs, [&]()
+    {
+        jitter += 1e-3f;
+        for (size_t i = 0; i < count; ++i)
+        {
+            transforms[i].SetPosition(positions[i] + glm::vec3(jitter));
+            out[i] = transforms[i].LocalToWorld();
+        }
+        sink = sink + out[count / 2][3][0];
+    });
+    Report("Transform (all dirty)", cached_ms, count, legacy_ms);
+
+    const double clean_ms = BestOfMs(runs, [&]()
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            out[i] = transforms[i].LocalToWorld();
+        }
+        sink = sink + out[count / 2][3][0];
+    });
+    Report("Transform (clean, cached)", clean_ms, count, legacy_ms);
+
+    std::vector<glm::mat4> reference(count);
+    TransformKernel::ComposeMatrices(soa, reference.data(), TransformKernel::Path::Scalar);
+
+    const TransformKernel::Path paths[] = {TransformKernel::Path::Scalar, TransformKernel::Path::SSE2, TransformKernel::Path::AVX2};
+    for (TransformKernel::Path path : paths)
+    {
+        if (path > TransformKernel::BestSupportedPath())
+            continue;
+        const double ms = BestOfMs(runs, [&]()
+        {
+            TransformKernel::ComposeMatrices(soa, out.data(), path);
+            sink = sink + out[count / 2][3][0];
+        });
+        float max_error = 0.0f;
+        for (size_t i = 0; i < count; ++i)
+            for (int c = 0; c < 4; ++c)
+                for (int r = 0; r < 4; ++r)
+                    max_error = std::max(max_error, std::fabs(out[i][c][r] - reference[i][c][r]));
+        char name[64];
+        std::snprintf(name, sizeof(name), "kernel %s (err %.1e)", TransformKernel::PathName(path), max_error);
+        Report(name, ms, count, legacy_ms);
+    }
+    return 0;
+}
@@ -0,0 +1,142 @@
+// Microbenchmark: uniform location lookup per draw. Replays the 13 by-name
+// uniform sets the lit path used to make per draw and compares the previous
+// lookup (a std::string built from the name, hashed into an unordered_map)
+// against the link-time UniformTable searched with a run-time hash, with names
+// hashed at compile time, and against handles resolved once up front. Runs
+// headless (the table is filled with stand-in locations, no GL context needed).
+//
+// Usage: uniform_lookup_bench [draws]   (default 10000)
+#include "engine/uniform_table.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+template <typename Fn>
+static double BestOfMs(int runs, Fn &&fn)
+{
+    double best = 1e30;
+    for (int r = 0; r < runs; ++r)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        fn();
+        const auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    return best;
+}
+
+// Every default-block uniform of the lit shaders before uniform blocks
+static const char *const kProgramUniforms[] = {
+    "uProjection", "uView", "uModel", "u_isInstanced", "uLightSpaceMatrix", "uShadowMap", "uLightCount",
+    "uLightDirs[0]", "uLightDirs[1]", "uLightDirs[2]", "uLightDirs[3]", "uLightColors[0]", "uLightColors[1]",
+    "uLightColors[2]", "uLightColors[3]", "uAmbient", "uAlbedo", "uUseTexture", "uColor", "uSmoothness",
+    "uCamPos", "uShadowBias", "uPCFSamples",
+};
+
+// What one draw set by name
+static const char *const kPerDraw[] = {
+    "uAlbedo", "uUseTexture", "uAmbient", "uLightSpaceMatrix", "uShadowMap", "uShadowBias", "uPCFSamples",
+    "uColor", "uSmoothness", "uModel", "uView", "uProjection", "u_isInstanced",
+};
+static constexpr size_t kPerDrawCount = sizeof(kPerDraw) / sizeof(kPerDraw[0]);
+
+static constexpr UniformName kPerDrawHashed[] = {
+    {"uAlbedo"}, {"uUseTexture"}, {"uAmbient"}, {"uLightSpaceMatrix"}, {"uShadowMap"}, {"uShadowBias"}, {"uPCFSamples"},
+    {"uColor"}, {"uSmoothness"}, {"uModel"}, {"uView"}, {"uProjection"}, {"u_isInstanced"},
+};
+static_assert(sizeof(kPerDrawHashed) / sizeof(kPerDrawHashed[0]) == kPerDrawCount, "name lists differ");
+
+int main(int argc, char **argv)
+{
+    const size_t draws = argc > 1 ? static_cast<size_t>(std::strtoul(argv[1], nullptr, 10)) : 10000;
+    const int runs = 20;
+#ifndef NDEBUG
+    std::printf("warning: built without NDEBUG; numbers are not representative\n");
+#endif
+
+    std::unordered_map<std::string, GLint> legacy;
+    std::vector<UniformInfo> infos;
+    GLint next_location = 0;
+    for (const char *name : kProgramUniforms)
+    {
+        legacy.emplace(name, next_location);
+        UniformInfo info;
+        info.hash = HashUniformName(name);
+        info.location = next_location++;
+        info.name = name;
+        infos.push_back(info);
+    }
+    UniformTable table;
+    table.Build(infos);
+
+    GLint handles[kPerDrawCount];
+    for (size_t i = 0; i < kPerDrawCount; ++i)
+        handles[i] = table.Find(kPerDraw[i])->location;
+
+    volatile GLint sink = 0;
+    const double string_ms = BestOfMs(runs, [&]()
+    {
+        GLint sum = 0;
+        for (size_t d = 0; d < draws; ++d)
+        {
+            for (const char *name : kPerDraw)
+            {
+                auto it = legacy.find(name);
+                sum += it != legacy.end() ? it->second : -1;
+            }
+        }
+        sink = sink + sum;
+    });
+    const double runtime_ms = BestOfMs(runs, [&]()
+    {
+        GLint sum = 0;
+        for (size_t d = 0; d < draws; ++d)
+        {
+            for (const char *name : kPerDraw)
+            {
+                const UniformInfo *info = table.Find(name);
+                sum += info ? info->location : -1;
+            }
+        }
+        sink = sink + sum;
+    });
+    const double constexpr_ms = BestOfMs(runs, [&]()
+    {
+        GLint sum = 0;
+        for (size_t d = 0; d < draws; ++d)
+        {
+            for (const UniformName &name : kPerDrawHashed)
+            {
+                const UniformInfo *info = table.Find(name);
+                sum += info ? info->location : -1;
+            }
+        }
+        sink = sink + sum;
+    });
+    const double handle_ms = BestOfMs(runs, [&]()
+    {
+        GLint sum = 0;
+        for (size_t d = 0; d < draws; ++d)
+        {
+            for (GLint location : handles)
+                sum += location;
+        }
+        sink = sink + sum;
+    });
+
+    const double lookups = static_cast<double>(draws * kPerDrawCount);
+    std::printf("%zu draws x %zu uniforms, %zu active in the program (best of %d)\n", draws, kPerDrawCount,
+                table.Entries().size(), runs);
+    std::printf("  %-34s %8.3f ms  %6.1f ns/lookup\n", "string + unordered_map (before)", string_ms,
+                string_ms * 1e6 / lookups);
+    std::printf("  %-34s %8.3f ms  %6.1f ns/lookup\n", "table, hashed at run time", runtime_ms,
+                runtime_ms * 1e6 / lookups);
+    std::printf("  %-34s %8.3f ms  %6.1f ns/lookup\n", "table, hashed at compile time", constexpr_ms,
+                constexpr_ms * 1e6 / lookups);
+    std::printf("  %-34s %8.3f ms  %6.1f ns/lookup\n", "resolved handles", handle_ms, handle_ms * 1e6 / lookups);
+    return 0;
+}
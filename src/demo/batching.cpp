@@ -32,69 +32,39 @@ public:
         InputManager::GetInstance().Initialize(win);
         scene_.SetWindow(win);
 
-        // Create cat object
-        GameObject &cat = scene_.CreateObject();
-        auto *catTransform_ = cat.AddComponent<Transform>();
-        // catTransform_->position = glm::vec3(0.0f, 0.0f, 0.0f);
-        // catTransform_->rotation_euler = glm::vec3(-90.0f, 180.0f, 0.0f);
-        Mesh mesh = ModelLoader::LoadFirstMeshFromFile("resources/cat/cat.fbx");
-        auto &cat_vertices = mesh.vertices;
-        auto &cat_indices = mesh.indices;
+        // 100 x 100 cats that never move. Flagged static, they are merged into a
+        // few meshes per spatial cell instead of being drawn one by one. Their
+        // vertices are packed to half the size, and so are the merged meshes.
+        Mesh mesh = ModelLoader::LoadFirstMeshFromFile("resources/cat/cat.fbx", false, VertexFormat::Packed);
         auto meshPtrCat = std::make_shared<Mesh>(std::move(mesh));
-        std::cout << cat_vertices.size() << " " << cat_indices.size() << std::endl;
-
-        std::vector<MeshVertex> combined_vertices;
-        std::vector<unsigned int> combined_indices;
-        unsigned int vertex_offset = 0;
-        combined_vertices.reserve(10000);
-        combined_indices.reserve(10000);
-
-        for (int i = 0; i < 100; i++)
-        {
-            for (int j = 0; j < 100; j++)
-            {
-                glm::mat4 model = glm::mat4(1.0f);
-                model = glm::rotate(model, glm::radians(180.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-                model = glm::rotate(model, glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-                model = glm::translate(model, glm::vec3(i - 50, j, 0.0f));
-
-                for (const auto vertex : cat_vertices)
-                {
-                    MeshVertex transformed_vertex = vertex;
-                    transformed_vertex.position = model * glm::vec4(vertex.position, 1.0f);
-                    transformed_vertex.normal = glm::mat3(glm::transpose(glm::inverse(model))) * vertex.normal;
-                    combined_vertices.push_back(transformed_vertex);
-                }
-
-                for (unsigned int index : cat_indices)
-                {
-                    combined_indices.push_back(index + vertex_offset);
-                }
-
-                vertex_offset += cat_vertices.size();
-            }
-        }
-
-        // for (const auto vertex : combined_vertices)
-        // {
-        //     std::cout << vertex.position.x << " " << vertex.position.y << " " << vertex.position.z << std::endl;
-        // }
-
-        auto batched_mesh_ptr = std::make_shared<Mesh>(combined_vertices, combined_indices);
+        const QuantizationError &error = meshPtrCat->GetQuantizationError();
+        std::cout << "cat packed: position error " << error.max_position << " max, " << error.rms_position
+                  << " rms; normal " << error.max_normal_degrees << " deg; uv " << error.max_uv << std::endl;
         auto cat_mat = std::make_shared<Material>();
         cat_mat->vertex_shader_path = "src/engine/shaders/lit.vert";
         cat_mat->fragment_shader_path = "src/engine/shaders/lit.frag";
         cat_mat->albedo_texture_path = "resources/cat/cattex.png";
         cat_mat->color = glm::vec3(1.0f, 1.0f, 1.0f);
         cat_mat->smoothness = 0.6f;
-        auto *cat_renderer = cat.AddComponent<MeshRenderer>(batched_mesh_ptr, cat_mat);
+
+        GameObject &cat = scene_.CreateObject();
+        auto *cat_transform = cat.AddComponent<Transform>();
+        cat_transform->SetPosition(glm::vec3(50.0f, 0.0f, 0.0f));
+        cat_transform->SetEulerAngles(glm::vec3(-90.0f, 180.0f, 0.0f));
+        cat.AddComponent<MeshRenderer>(meshPtrCat, cat_mat)->is_static = true;
+        scene_.InstantiateMany(cat, 100 * 100 - 1, [](GameObject &clone, size_t n)
+                               {
+                                   const int i = static_cast<int>((n + 1) / 100);
+                                   const int j = static_cast<int>((n + 1) % 100);
+                                   clone.GetComponent<Transform>()->SetPosition(glm::vec3(50.0f - i, 0.0f, static_cast<float>(j)));
+                               });
 
         // Create plane object
         GameObject &plane = scene_.CreateObject();
         auto *plane_transform = plane.AddComponent<Transform>();
-        plane_transform->position = glm::vec3(0.0f, 0.0f, 0.0f);
-        plane_transform->rotation_euler = glm::vec3(0.0f, 0.0f, 0.0f);
-        plane_transform->scale = glm::vec3(100.0f, 100.0f, 100.0f);
+        plane_transform->SetPosition(glm::vec3(0.0f, 0.0f, 0.0f));
+        plane_transform->SetEulerAngles(glm::vec3(0.0f, 0.0f, 0.0f));
+        plane_transform->SetScale(glm::vec3(100.0f, 100.0f, 100.0f));
         Mesh plane_mesh = MeshCreator::CreateUnitPlane();
         auto plane_mesh_ptr = std::make_shared<Mesh>(std::move(plane_mesh));
         auto plane_mat = std::make_shared<Material>();
@@ -107,8 +77,8 @@ public:
         // Create camera object (must exist to render)
         GameObject &cam_obj = scene_.CreateObject();
         auto *cam_transform = cam_obj.AddComponent<Transform>();
-        cam_transform->position = glm::vec3(0.0f, 30.0f, -30.0f);
-        cam_transform->rotation_euler = glm::vec3(-45.0f, 180.0f, 0.0f);
+        cam_transform->SetPosition(glm::vec3(0.0f, 30.0f, -30.0f));
+        cam_transform->SetEulerAngles(glm::vec3(-45.0f, 180.0f, 0.0f));
         auto *camera = cam_obj.AddComponent<Camera>();
         camera->field_of_view_degrees = 60.0f;
 
@@ -117,14 +87,18 @@ public:
         // Create a directional light object
         GameObject &light_obj = scene_.CreateObject();
         auto *light_transform = light_obj.AddComponent<Transform>();
-        light_transform->position = glm::vec3(0.0f, 3.0f, 0.0f);
-        light_transform->rotation_euler = glm::vec3(-45.0f, 60.0f, 0.0f);
+        light_transform->SetPosition(glm::vec3(0.0f, 3.0f, 0.0f));
+        light_transform->SetEulerAngles(glm::vec3(-45.0f, 60.0f, 0.0f));
         auto *light = light_obj.AddComponent<Light>();
         light->color = glm::vec3(1.0f, 0.9568627f, 0.8392157f);
         light->intensity = 1.0f;
 
         // Configure scene sky and ambient from equirectangular texture
         scene_.SetSkyFromEquirect("resources/cat/catsky.png");
+
+        scene_.BuildStaticBatches();
+        const StaticBatchStats &batches = scene_.GetStaticBatchStats();
+        std::cout << batches.objects << " static objects in " << batches.batches << " batches" << std::endl;
     }
 
 protected:
@@ -141,7 +115,9 @@ protected:
             {
                 max_fps_ = std::max(max_fps_, fps);
                 min_fps_ = std::min(min_fps_, fps);
-                std::cout << min_fps_ << " " << max_fps_ << " " << fps << std::endl;
+                const StaticBatchStats &batches = scene_.GetStaticBatchStats();
+                std::cout << min_fps_ << " " << max_fps_ << " " << fps << "  batch ranges " << batches.ranges
+                          << " cells culled " << batches.cells_culled << std::endl;
             }
             else
             {
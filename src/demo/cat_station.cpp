@@ -19,6 +19,7 @@
 #include "engine/light.h"
 #include <assimp/postprocess.h>
 #include <string>
+#include <algorithm>
 #include <iostream>
 
 // Accumulate mouse wheel scroll between frames
@@ -34,10 +35,12 @@ public:
         // Create cat object
         GameObject &cat = scene_.CreateObject();
         auto *transform = cat.AddComponent<Transform>();
-        transform->position = glm::vec3(0.0f, 0.0f, 0.0f);
-        transform->rotation_euler = glm::vec3(-90.0f, 0.0f, 0.0f);
+        transform->SetPosition(glm::vec3(0.0f, 0.0f, 0.0f));
+        transform->SetEulerAngles(glm::vec3(-90.0f, 0.0f, 0.0f));
         cat_transform_ = transform;
-        Mesh mesh = ModelLoader::LoadFirstMeshFromFile("resources/cat/cat.fbx");
+        MeshOptimizationReport catReport;
+        Mesh mesh = ModelLoader::LoadFirstMeshFromFile("resources/cat/cat.fbx", false, VertexFormat::Float, &catReport);
+        std::cout << "cat import: " << catReport.Format();
         auto meshPtrCat = std::make_shared<Mesh>(std::move(mesh));
         auto catMat = std::make_shared<Material>();
         catMat->vertex_shader_path = "src/engine/shaders/lit.vert";
@@ -50,33 +53,51 @@ public:
         // Create cat clone
         GameObject &catClone = scene_.Instantiate(cat);
         auto *cloneTransform = catClone.GetComponent<Transform>();
-        cloneTransform->position = glm::vec3(1.0f, 0.0f, -2.0f);
-        cloneTransform->rotation_euler = glm::vec3(-90.0f, 180.0f, 0.0f);
+        cloneTransform->SetPosition(glm::vec3(1.0f, 0.0f, -2.0f));
+        cloneTransform->SetEulerAngles(glm::vec3(-90.0f, 180.0f, 0.0f));
 
         // Create station
-        std::vector<Mesh> stationMeshes = ModelLoader::LoadAllMeshesFromFile("resources/station/station.fbx", true);
+        std::vector<Mesh> stationMeshes =
+            ModelLoader::LoadAllMeshesFromFile("resources/station/station.fbx", true, VertexFormat::Packed);
+        QuantizationError stationError;
+        for (const Mesh &m : stationMeshes)
+        {
+            const QuantizationError &error = m.GetQuantizationError();
+            stationError.max_position = std::max(stationError.max_position, error.max_position);
+            stationError.max_normal_degrees = std::max(stationError.max_normal_degrees, error.max_normal_degrees);
+            stationError.max_uv = std::max(stationError.max_uv, error.max_uv);
+        }
+        std::cout << "station packed (" << stationMeshes.size() << " parts): position error " << stationError.max_position
+                  << " max; normal " << stationError.max_normal_degrees << " deg; uv " << stationError.max_uv << std::endl;
         auto stationMat = std::make_shared<Material>();
         stationMat->vertex_shader_path = "src/engine/shaders/lit.vert";
         stationMat->fragment_shader_path = "src/engine/shaders/lit.frag";
         stationMat->albedo_texture_path = "resources/station/station.png";
         catMat->color = glm::vec3(1.0f, 1.0f, 1.0f);
         stationMat->smoothness = 0.5f;
+        // Parts hang off a single root so the whole station moves as one unit
+        GameObject &station_root = scene_.CreateObject();
+        auto *station_transform = station_root.AddComponent<Transform>();
+        station_transform->SetPosition(glm::vec3(-1.625f, 0.0f, -3.5f));
+        station_transform->SetEulerAngles(glm::vec3(0.0f, -90.0f, 0.0f));
+        station_transform->SetScale(glm::vec3(0.0175f));
         for (auto &m : stationMeshes)
         {
             GameObject &station_part = scene_.CreateObject();
             auto *transform = station_part.AddComponent<Transform>();
-            transform->position = glm::vec3(-1.625f, 0.0f, -3.5f);
-            transform->rotation_euler = glm::vec3(0.0f, -90.0f, 0.0f);
-            transform->scale *= 0.0175f;
+            transform->SetParent(station_transform);
             auto meshPtr = std::make_shared<Mesh>(std::move(m));
             auto *mr = station_part.AddComponent<MeshRenderer>(meshPtr, stationMat);
+            // The station's walls hide most of what stands behind it
+            mr->occluder = true;
         }
+        scene_.SetOcclusionCulling(true);
 
         // Create camera object (must exist to render)
         GameObject &camObj = scene_.CreateObject();
         auto *camTransform = camObj.AddComponent<Transform>();
-        camTransform->position = glm::vec3(0.0f, 4.0f, -8.0f);
-        camTransform->rotation_euler = glm::vec3(-7.0f, 180.0f, 0.0f);
+        camTransform->SetPosition(glm::vec3(0.0f, 4.0f, -8.0f));
+        camTransform->SetEulerAngles(glm::vec3(-7.0f, 180.0f, 0.0f));
         auto *camera = camObj.AddComponent<Camera>();
         camera->field_of_view_degrees = 60.0f;
         camera_ = camera;
@@ -91,8 +112,8 @@ public:
         // Create a directional light object
         GameObject &lightObj = scene_.CreateObject();
         auto *lightTransform = lightObj.AddComponent<Transform>();
-        lightTransform->position = glm::vec3(0.0f, 3.0f, 0.0f);
-        lightTransform->rotation_euler = glm::vec3(45.0f, -120.0f, 0.0f);
+        lightTransform->SetPosition(glm::vec3(0.0f, 3.0f, 0.0f));
+        lightTransform->SetEulerAngles(glm::vec3(45.0f, -120.0f, 0.0f));
         auto *light = lightObj.AddComponent<Light>();
         light->color = glm::vec3(1.0f, 0.9568627f, 0.8392157f);
         light->intensity = 1.0f;
@@ -136,16 +157,18 @@ protected:
         // --- CAMERA ROTATION WITH EULER ANGLES ---
         if (right_down)
         {
-            // Directly modify the euler angles
-            camera_transform_->rotation_euler.y += static_cast<float>(dx) * rotate_sensitivity;
-            camera_transform_->rotation_euler.x += static_cast<float>(dy) * rotate_sensitivity;
+            // Modify the euler angles
+            glm::vec3 euler = camera_transform_->GetEulerAngles();
+            euler.y += static_cast<float>(dx) * rotate_sensitivity;
+            euler.x += static_cast<float>(dy) * rotate_sensitivity;
 
             // Clamp pitch to prevent flipping
-            camera_transform_->rotation_euler.x = glm::clamp(camera_transform_->rotation_euler.x, -89.0f, 89.0f);
+            euler.x = glm::clamp(euler.x, -89.0f, 89.0f);
+            camera_transform_->SetEulerAngles(euler);
         }
 
         // Get the final orientation for panning and zooming
-        glm::quat current_orientation = glm::quat(glm::radians(camera_transform_->rotation_euler));
+        glm::quat current_orientation = camera_transform_->GetRotation();
 
         // Middle mouse: pan along camera right/up.
         if (middle_down)
@@ -154,7 +177,7 @@ protected:
             const glm::vec3 cam_right = glm::normalize(rot * glm::vec3(1, 0, 0));
             const glm::vec3 cam_up = glm::normalize(rot * glm::vec3(0, 1, 0));
             const glm::vec3 pan_delta = cam_right * static_cast<float>(dx) * pan_sensitivity + cam_up * static_cast<float>(-dy) * pan_sensitivity;
-            camera_transform_->position += pan_delta;
+            camera_transform_->Translate(pan_delta);
         }
 
         // Scroll: dolly zoom along camera forward
@@ -162,11 +185,9 @@ protected:
         {
             const glm::mat3 rot = glm::mat3_cast(current_orientation);
             const glm::vec3 cam_forward = glm::normalize(rot * glm::vec3(0, 0, -1));
-            camera_transform_->position += cam_forward * static_cast<float>(g_scroll_y_) * zoom_speed;
+            camera_transform_->Translate(cam_forward * static_cast<float>(g_scroll_y_) * zoom_speed);
             g_scroll_y_ = 0.0;
         }
-
-        auto rot = camera_transform_->rotation_euler;
     }
 
     void OnRender() override
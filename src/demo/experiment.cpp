@@ -36,8 +36,8 @@ public:
         // Create cat object
         GameObject &cat = scene_.CreateObject();
         auto *catTransform_ = cat.AddComponent<Transform>();
-        catTransform_->position = glm::vec3(0.0f, 0.0f, 0.0f);
-        catTransform_->rotation_euler = glm::vec3(-90.0f, 180.0f, 0.0f);
+        catTransform_->SetPosition(glm::vec3(0.0f, 0.0f, 0.0f));
+        catTransform_->SetEulerAngles(glm::vec3(-90.0f, 180.0f, 0.0f));
         Mesh mesh = ModelLoader::LoadFirstMeshFromFile("resources/cat/cat.fbx");
         auto meshPtrCat = std::make_shared<Mesh>(std::move(mesh));
         auto catMat = std::make_shared<Material>();
@@ -50,14 +50,14 @@ public:
 
         GameObject &cat_clone = scene_.Instantiate(cat);
         auto *cat_clone_transform = cat_clone.GetComponent<Transform>();
-        cat_clone_transform->position = glm::vec3(1.0f, 0.0f, 0.0f);
+        cat_clone_transform->SetPosition(glm::vec3(1.0f, 0.0f, 0.0f));
 
         // Create plane object
         GameObject &plane = scene_.CreateObject();
         auto *plane_transform = plane.AddComponent<Transform>();
-        plane_transform->position = glm::vec3(0.0f, 0.0f, 0.0f);
-        plane_transform->rotation_euler = glm::vec3(0.0f, 0.0f, 0.0f);
-        plane_transform->scale = glm::vec3(100.0f, 100.0f, 100.0f);
+        plane_transform->SetPosition(glm::vec3(0.0f, 0.0f, 0.0f));
+        plane_transform->SetEulerAngles(glm::vec3(0.0f, 0.0f, 0.0f));
+        plane_transform->SetScale(glm::vec3(100.0f, 100.0f, 100.0f));
         Mesh plane_mesh = MeshCreator::CreateUnitPlane();
         auto plane_mesh_ptr = std::make_shared<Mesh>(std::move(plane_mesh));
         auto plane_mat = std::make_shared<Material>();
@@ -70,8 +70,8 @@ public:
         // Create camera object (must exist to render)
         GameObject &cam_obj = scene_.CreateObject();
         auto *cam_transform = cam_obj.AddComponent<Transform>();
-        cam_transform->position = glm::vec3(0.0f, 1.49f, -3.26f);
-        cam_transform->rotation_euler = glm::vec3(0.0f, 180.0f, 0.0f);
+        cam_transform->SetPosition(glm::vec3(0.0f, 1.49f, -3.26f));
+        cam_transform->SetEulerAngles(glm::vec3(0.0f, 180.0f, 0.0f));
         auto *camera = cam_obj.AddComponent<Camera>();
         camera->field_of_view_degrees = 60.0f;
 
@@ -80,8 +80,8 @@ public:
         // Create a directional light object
         GameObject &light_obj = scene_.CreateObject();
         auto *light_transform = light_obj.AddComponent<Transform>();
-        light_transform->position = glm::vec3(0.0f, 5.0f, 2.0f);          // Higher and more forward
-        light_transform->rotation_euler = glm::vec3(-60.0f, 30.0f, 0.0f); // Steeper angle
+        light_transform->SetPosition(glm::vec3(0.0f, 5.0f, 2.0f));          // Higher and more forward
+        light_transform->SetEulerAngles(glm::vec3(-60.0f, 30.0f, 0.0f)); // Steeper angle
         auto *light = light_obj.AddComponent<Light>();
         light->color = glm::vec3(1.0f, 0.9568627f, 0.8392157f);
         light->intensity = 1.0f;
@@ -130,13 +130,13 @@ protected:
                 if (meshRenderer)
                 {
                     auto transform = gameObject->GetComponent<Transform>();
-                    renderer.DrawMeshForDepth(*meshRenderer->GetMesh(), transform->LocalToWorld());
+                    renderer.DrawMeshForDepth(*meshRenderer->GetLodMesh(), transform->LocalToWorld());
                 }
             }
             renderer.EndShadowPass();
             int screenWidth, screenHeight;
             glfwGetFramebufferSize(window_->Handle(), &screenWidth, &screenHeight);
-            glViewport(0, 0, screenWidth, screenHeight);
+            renderer.SetViewport(screenWidth, screenHeight);
         }
 
         scene_.Render(renderer);
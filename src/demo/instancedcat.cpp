@@ -35,8 +35,8 @@ public:
         // Create cat object
         GameObject &cat = scene_.CreateObject();
         auto *catTransform_ = cat.AddComponent<Transform>();
-        catTransform_->position = glm::vec3(0.0f, 0.0f, 0.0f);
-        catTransform_->rotation_euler = glm::vec3(-90.0f, 180.0f, 0.0f);
+        catTransform_->SetPosition(glm::vec3(0.0f, 0.0f, 0.0f));
+        catTransform_->SetEulerAngles(glm::vec3(-90.0f, 180.0f, 0.0f));
         Mesh mesh = ModelLoader::LoadFirstMeshFromFile("resources/cat/cat.fbx");
         auto meshPtrCat = std::make_shared<Mesh>(std::move(mesh));
         meshPtrCat->instance_id = 1;
@@ -66,9 +66,9 @@ public:
         // Create plane object
         GameObject &plane = scene_.CreateObject();
         auto *plane_transform = plane.AddComponent<Transform>();
-        plane_transform->position = glm::vec3(0.0f, 0.0f, 0.0f);
-        plane_transform->rotation_euler = glm::vec3(0.0f, 0.0f, 0.0f);
-        plane_transform->scale = glm::vec3(100.0f, 100.0f, 100.0f);
+        plane_transform->SetPosition(glm::vec3(0.0f, 0.0f, 0.0f));
+        plane_transform->SetEulerAngles(glm::vec3(0.0f, 0.0f, 0.0f));
+        plane_transform->SetScale(glm::vec3(100.0f, 100.0f, 100.0f));
         Mesh plane_mesh = MeshCreator::CreateUnitPlane();
         auto plane_mesh_ptr = std::make_shared<Mesh>(std::move(plane_mesh));
         auto plane_mat = std::make_shared<Material>();
@@ -81,8 +81,8 @@ public:
         // Create camera object (must exist to render)
         GameObject &cam_obj = scene_.CreateObject();
         auto *cam_transform = cam_obj.AddComponent<Transform>();
-        cam_transform->position = glm::vec3(0.0f, 30.0f, -30.0f);
-        cam_transform->rotation_euler = glm::vec3(-45.0f, 180.0f, 0.0f);
+        cam_transform->SetPosition(glm::vec3(0.0f, 30.0f, -30.0f));
+        cam_transform->SetEulerAngles(glm::vec3(-45.0f, 180.0f, 0.0f));
         auto *camera = cam_obj.AddComponent<Camera>();
         camera->field_of_view_degrees = 60.0f;
 
@@ -91,8 +91,8 @@ public:
         // Create a directional light object
         GameObject &light_obj = scene_.CreateObject();
         auto *light_transform = light_obj.AddComponent<Transform>();
-        light_transform->position = glm::vec3(0.0f, 3.0f, 0.0f);
-        light_transform->rotation_euler = glm::vec3(-45.0f, 60.0f, 0.0f);
+        light_transform->SetPosition(glm::vec3(0.0f, 3.0f, 0.0f));
+        light_transform->SetEulerAngles(glm::vec3(-45.0f, 60.0f, 0.0f));
         auto *light = light_obj.AddComponent<Light>();
         light->color = glm::vec3(1.0f, 0.9568627f, 0.8392157f);
         light->intensity = 1.0f;
@@ -8,6 +8,7 @@
 #include "engine/application.h"
 #include "engine/window.h"
 #include "engine/renderer.h"
+#include "engine/stream_buffer.h"
 #include "engine/model_loader.h"
 #include "engine/shader.h"
 #include "engine/mesh_creator.h"
@@ -27,7 +28,12 @@ class ExperimentApp : public Application
 {
 public:
     std::vector<glm::mat4> cat_matrices;
+    std::vector<glm::vec3> cat_positions;
     std::shared_ptr<Shader> cat_shader;
+    Uniform<float> time_uniform_;
+    std::shared_ptr<Mesh> cat_mesh;
+    // Instance matrices change every frame, so they go through a streaming ring
+    StreamBuffer instance_stream;
     ExperimentApp() : Application(800, 800, "Cool GL")
     {
         GLFWwindow *win = window_->Handle();
@@ -37,8 +43,8 @@ public:
         // Create cat object
         GameObject &cat = scene_.CreateObject();
         auto *catTransform_ = cat.AddComponent<Transform>();
-        catTransform_->position = glm::vec3(0.0f, 0.0f, 0.0f);
-        catTransform_->rotation_euler = glm::vec3(-90.0f, 180.0f, 0.0f);
+        catTransform_->SetPosition(glm::vec3(0.0f, 0.0f, 0.0f));
+        catTransform_->SetEulerAngles(glm::vec3(-90.0f, 180.0f, 0.0f));
         Mesh mesh = ModelLoader::LoadFirstMeshFromFile("resources/cat/cat.fbx");
         auto meshPtrCat = std::make_shared<Mesh>(std::move(mesh));
         meshPtrCat->instance_id = 1;
@@ -53,9 +59,11 @@ public:
                 model = glm::rotate(model, glm::radians(180.0f), glm::vec3(0.0f, 0.0f, 1.0f));
 
                 cat_matrices.push_back(model);
+                cat_positions.push_back(glm::vec3(i - 50, 0.0f, j));
             }
         }
         meshPtrCat->CreateInstanceBuffer(cat_matrices);
+        cat_mesh = meshPtrCat;
         auto cat_mat = std::make_shared<Material>();
         cat_mat->vertex_shader_path = "src/engine/shaders/lit_wave.vert";
         cat_mat->fragment_shader_path = "src/engine/shaders/lit.frag";
@@ -66,14 +74,15 @@ public:
         cat_shader = cat_mat->GetShader();
         cat_shader->use();
         cat_shader->set_vec3("u_wave_params", glm::vec3(2.0f, 0.5f, 2.0f)); // amplitude, wavelength,frequency
+        time_uniform_ = cat_shader->uniform<float>("u_time");
         auto *cat_renderer = cat.AddComponent<MeshRenderer>(meshPtrCat, cat_mat);
 
         // Create plane object
         GameObject &plane = scene_.CreateObject();
         auto *plane_transform = plane.AddComponent<Transform>();
-        plane_transform->position = glm::vec3(0.0f, 0.0f, 0.0f);
-        plane_transform->rotation_euler = glm::vec3(0.0f, 0.0f, 0.0f);
-        plane_transform->scale = glm::vec3(100.0f, 100.0f, 100.0f);
+        plane_transform->SetPosition(glm::vec3(0.0f, 0.0f, 0.0f));
+        plane_transform->SetEulerAngles(glm::vec3(0.0f, 0.0f, 0.0f));
+        plane_transform->SetScale(glm::vec3(100.0f, 100.0f, 100.0f));
         Mesh plane_mesh = MeshCreator::CreateUnitPlane();
         auto plane_mesh_ptr = std::make_shared<Mesh>(std::move(plane_mesh));
         auto plane_mat = std::make_shared<Material>();
@@ -86,8 +95,8 @@ public:
         // Create camera object (must exist to render)
         GameObject &cam_obj = scene_.CreateObject();
         auto *cam_transform = cam_obj.AddComponent<Transform>();
-        cam_transform->position = glm::vec3(0.0f, 30.0f, -30.0f);
-        cam_transform->rotation_euler = glm::vec3(-45.0f, 180.0f, 0.0f);
+        cam_transform->SetPosition(glm::vec3(0.0f, 30.0f, -30.0f));
+        cam_transform->SetEulerAngles(glm::vec3(-45.0f, 180.0f, 0.0f));
         auto *camera = cam_obj.AddComponent<Camera>();
         camera->field_of_view_degrees = 60.0f;
 
@@ -96,8 +105,8 @@ public:
         // Create a directional light object
         GameObject &light_obj = scene_.CreateObject();
         auto *light_transform = light_obj.AddComponent<Transform>();
-        light_transform->position = glm::vec3(0.0f, 3.0f, 0.0f);
-        light_transform->rotation_euler = glm::vec3(-45.0f, 60.0f, 0.0f);
+        light_transform->SetPosition(glm::vec3(0.0f, 3.0f, 0.0f));
+        light_transform->SetEulerAngles(glm::vec3(-45.0f, 60.0f, 0.0f));
         auto *light = light_obj.AddComponent<Light>();
         light->color = glm::vec3(1.0f, 0.9568627f, 0.8392157f);
         light->intensity = 1.0f;
@@ -110,7 +119,18 @@ protected:
     void OnUpdate(float time_seconds) override
     {
         cat_shader->use();
-        cat_shader->set_float("u_time", time_seconds);
+        cat_shader->set(time_uniform_, time_seconds);
+
+        // Every cat slowly turns in place, animated on the CPU
+        const glm::mat4 upright = glm::rotate(glm::rotate(glm::mat4(1.0f), glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f)),
+                                              glm::radians(180.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+        const glm::mat4 turn = glm::rotate(glm::mat4(1.0f), time_seconds * 0.5f, glm::vec3(0.0f, 1.0f, 0.0f)) * upright;
+        for (size_t n = 0; n < cat_matrices.size(); ++n)
+        {
+            cat_matrices[n] = glm::translate(glm::mat4(1.0f), cat_positions[n]) * turn;
+        }
+        instance_stream.NextFrame();
+        cat_mesh->StreamInstances(instance_stream, cat_matrices.data(), cat_matrices.size());
         frame_count_++;
         float diff_time = time_seconds - last_time_;
         if (frame_count_ > fps_calc_interval_)
@@ -35,8 +35,8 @@ public:
         // Create camera object (must exist to render)
         GameObject &camObj = scene_.CreateObject();
         auto *camTransform = camObj.AddComponent<Transform>();
-        camTransform->position = glm::vec3(0.0f, 4.0f, -8.0f);
-        camTransform->rotation_euler = glm::vec3(-7.0f, 180.0f, 0.0f);
+        camTransform->SetPosition(glm::vec3(0.0f, 4.0f, -8.0f));
+        camTransform->SetEulerAngles(glm::vec3(-7.0f, 180.0f, 0.0f));
         auto *camera = camObj.AddComponent<Camera>();
         camera->field_of_view_degrees = 60.0f;
         camera_ = camera;
@@ -49,8 +49,8 @@ public:
         // Create a directional light object
         GameObject &lightObj = scene_.CreateObject();
         auto *lightTransform = lightObj.AddComponent<Transform>();
-        lightTransform->position = glm::vec3(0.0f, 3.0f, 0.0f);
-        lightTransform->rotation_euler = glm::vec3(45.0f, -120.0f, 0.0f);
+        lightTransform->SetPosition(glm::vec3(0.0f, 3.0f, 0.0f));
+        lightTransform->SetEulerAngles(glm::vec3(45.0f, -120.0f, 0.0f));
         auto *light = lightObj.AddComponent<Light>();
         light->color = glm::vec3(1.0f, 0.9568627f, 0.8392157f);
         light->intensity = 1.0f;
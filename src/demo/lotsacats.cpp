@@ -8,6 +8,7 @@
 #include "engine/application.h"
 #include "engine/window.h"
 #include "engine/renderer.h"
+#include "engine/gl_state_cache.h"
 #include "engine/model_loader.h"
 #include "engine/shader.h"
 #include "engine/mesh_creator.h"
@@ -23,6 +24,34 @@
 #include <string>
 #include <iostream>
 
+// Turns its object about the vertical axis. It touches nothing but its own
+// Transform (which has no children), so the scene updates it on worker threads.
+class Spin : public Component
+{
+public:
+    static constexpr bool kParallelUpdate = true;
+
+    explicit Spin(float radians_per_second) : radians_per_second_(radians_per_second) {}
+
+    void OnStart() override
+    {
+        transform_ = owner_->GetComponent<Transform>();
+        rest_ = transform_->GetRotation();
+    }
+
+    void OnUpdate(float time_seconds) override
+    {
+        transform_->SetRotation(glm::angleAxis(time_seconds * radians_per_second_, glm::vec3(0.0f, 1.0f, 0.0f)) * rest_);
+    }
+
+    std::unique_ptr<Component> Clone() const override { return std::make_unique<Spin>(radians_per_second_); }
+
+private:
+    float radians_per_second_;
+    Transform *transform_ = nullptr;
+    glm::quat rest_{1.0f, 0.0f, 0.0f, 0.0f};
+};
+
 class ExperimentApp : public Application
 {
 public:
@@ -35,38 +64,42 @@ public:
         // Create cat object
         GameObject &cat = scene_.CreateObject();
         auto *catTransform_ = cat.AddComponent<Transform>();
-        catTransform_->position = glm::vec3(0.0f, 0.0f, 0.0f);
-        catTransform_->rotation_euler = glm::vec3(-90.0f, 180.0f, 0.0f);
-        Mesh mesh = ModelLoader::LoadFirstMeshFromFile("resources/cat/cat.fbx");
-        auto meshPtrCat = std::make_shared<Mesh>(std::move(mesh));
+        catTransform_->SetPosition(glm::vec3(0.0f, 0.0f, 0.0f));
+        catTransform_->SetEulerAngles(glm::vec3(-90.0f, 180.0f, 0.0f));
+        // Distant cats are only a few pixels tall; draw them from a simplified chain
+        auto catLods = ModelLoader::LoadLodGroupFromFile("resources/cat/cat.fbx");
+        for (size_t i = 0; i < catLods->LevelCount(); ++i)
+        {
+            const MeshLod &lod = catLods->Level(i);
+            std::cout << "cat LOD " << i << ": " << lod.mesh->IndexCount() / 3 << " triangles, error "
+                      << lod.error << ", below screen size " << (i > 0 ? catLods->Level(i - 1).screen_size : 1.0f)
+                      << std::endl;
+        }
         auto catMat = std::make_shared<Material>();
         catMat->vertex_shader_path = "src/engine/shaders/lit.vert";
         catMat->fragment_shader_path = "src/engine/shaders/lit.frag";
         catMat->albedo_texture_path = "resources/cat/cattex.png";
         catMat->color = glm::vec3(1.0f, 1.0f, 1.0f);
         catMat->smoothness = 0.6f;
-        auto *cat_renderer = cat.AddComponent<MeshRenderer>(meshPtrCat, catMat);
+        auto *cat_renderer = cat.AddComponent<MeshRenderer>(catLods->Level(0).mesh, catMat);
+        cat_renderer->SetLodGroup(catLods);
+        cat.AddComponent<Spin>(catRotationSpeed_);
 
-        for (int i = 0; i < 100; i++)
+        // Fill a 100x100 grid; the original already occupies cell (50, 0)
+        scene_.InstantiateMany(cat, 100 * 100 - 1, [](GameObject &clone, size_t index)
         {
-            for (int j = 0; j < 100; j++)
-            {
-                if (i == 50 && j == 0)
-                {
-                    continue;
-                }
-                GameObject &clone = scene_.Instantiate(cat);
-                auto *clone_transform = clone.GetComponent<Transform>();
-                clone_transform->position = glm::vec3(i - 50, 0.0f, j);
-            }
-        }
+            const size_t cell = index < 50 * 100 ? index : index + 1;
+            const float i = static_cast<float>(cell / 100);
+            const float j = static_cast<float>(cell % 100);
+            clone.GetComponent<Transform>()->SetPosition(glm::vec3(i - 50, 0.0f, j));
+        }, true);
 
         // Create plane object
         GameObject &plane = scene_.CreateObject();
         auto *plane_transform = plane.AddComponent<Transform>();
-        plane_transform->position = glm::vec3(0.0f, 0.0f, 0.0f);
-        plane_transform->rotation_euler = glm::vec3(0.0f, 0.0f, 0.0f);
-        plane_transform->scale = glm::vec3(100.0f, 100.0f, 100.0f);
+        plane_transform->SetPosition(glm::vec3(0.0f, 0.0f, 0.0f));
+        plane_transform->SetEulerAngles(glm::vec3(0.0f, 0.0f, 0.0f));
+        plane_transform->SetScale(glm::vec3(100.0f, 100.0f, 100.0f));
         Mesh plane_mesh = MeshCreator::CreateUnitPlane();
         auto plane_mesh_ptr = std::make_shared<Mesh>(std::move(plane_mesh));
         auto plane_mat = std::make_shared<Material>();
@@ -79,8 +112,8 @@ public:
         // Create camera object (must exist to render)
         GameObject &cam_obj = scene_.CreateObject();
         auto *cam_transform = cam_obj.AddComponent<Transform>();
-        cam_transform->position = glm::vec3(0.0f, 30.0f, -30.0f);
-        cam_transform->rotation_euler = glm::vec3(-45.0f, 180.0f, 0.0f);
+        cam_transform->SetPosition(glm::vec3(0.0f, 30.0f, -30.0f));
+        cam_transform->SetEulerAngles(glm::vec3(-45.0f, 180.0f, 0.0f));
         auto *camera = cam_obj.AddComponent<Camera>();
         camera->field_of_view_degrees = 60.0f;
 
@@ -89,14 +122,21 @@ public:
         // Create a directional light object
         GameObject &light_obj = scene_.CreateObject();
         auto *light_transform = light_obj.AddComponent<Transform>();
-        light_transform->position = glm::vec3(0.0f, 3.0f, 0.0f);
-        light_transform->rotation_euler = glm::vec3(-45.0f, 60.0f, 0.0f);
+        light_transform->SetPosition(glm::vec3(0.0f, 3.0f, 0.0f));
+        light_transform->SetEulerAngles(glm::vec3(-45.0f, 60.0f, 0.0f));
         auto *light = light_obj.AddComponent<Light>();
         light->color = glm::vec3(1.0f, 0.9568627f, 0.8392157f);
         light->intensity = 1.0f;
 
         // Configure scene sky and ambient from equirectangular texture
         scene_.SetSkyFromEquirect("resources/cat/catsky.png");
+
+        const PoolStats objects = scene_.GetObjectPoolStats();
+        const CombinedPoolStats components = scene_.GetComponentPoolStats();
+        std::cout << "objects " << objects.live << "/" << objects.capacity
+                  << " (peak " << objects.high_water << "), components " << components.live << "/"
+                  << components.capacity << " (transform peak "
+                  << scene_.GetComponentPoolStats<Transform>().high_water << ")" << std::endl;
     }
 
 protected:
@@ -113,7 +153,16 @@ protected:
             {
                 max_fps_ = std::max(max_fps_, fps);
                 min_fps_ = std::min(min_fps_, fps);
-                std::cout << min_fps_ << " " << max_fps_ << " " << fps << std::endl;
+                const CullingStats &culling = scene_.GetCullingStats();
+                const Renderer::FrameStats &frame = renderer_.GetFrameStats();
+                const GLStateCache::Stats &state = GLStateCache::GetInstance().GetStats();
+                std::cout << min_fps_ << " " << max_fps_ << " " << fps << "  visible " << culling.visible
+                          << " culled " << culling.culled << "  triangles " << frame.triangles << " draws "
+                          << frame.draw_calls << " state changes " << frame.state_changes << " program switches "
+                          << frame.program_switches << " instanced " << frame.instanced_draws << "/"
+                          << frame.instances << " multi-draws " << frame.multi_draws << "/"
+                          << frame.indirect_commands << "  gl state calls " << state.issued << " (filtered "
+                          << state.filtered << ")" << std::endl;
             }
             else
             {
@@ -125,12 +174,12 @@ protected:
 
     void OnRender() override
     {
-        static Renderer renderer;
-        scene_.Render(renderer);
+        scene_.Render(renderer_);
     }
 
 private:
     Scene scene_{};
+    Renderer renderer_{};
     float catRotationSpeed_ = 1.0f;
 
     // Mouse state
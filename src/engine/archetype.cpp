@@ -0,0 +1,68 @@
+#include "archetype.h"
+
+#include <algorithm>
+#include <utility>
+
+Archetype::Archetype(std::vector<ComponentTypeId> signature)
+    : signature_(std::move(signature)), columns_(signature_.size())
+{
+    for (ComponentTypeId type : signature_)
+    {
+        mask_ |= ComponentBit(type);
+    }
+}
+
+size_t Archetype::AddRow(GameObject *object, Component *const *components)
+{
+    const size_t row = objects_.size();
+    objects_.push_back(object);
+    for (size_t c = 0; c < columns_.size(); ++c)
+    {
+        columns_[c].push_back(components[c]);
+    }
+    return row;
+}
+
+GameObject *Archetype::RemoveRow(size_t row)
+{
+    const size_t last = objects_.size() - 1;
+    GameObject *moved = nullptr;
+    if (row != last)
+    {
+        objects_[row] = objects_[last];
+        for (auto &column : columns_)
+        {
+            column[row] = column[last];
+        }
+        moved = objects_[row];
+    }
+    objects_.pop_back();
+    for (auto &column : columns_)
+    {
+        column.pop_back();
+    }
+    return moved;
+}
+
+void Archetype::Reserve(size_t additional_rows)
+{
+    const size_t rows = objects_.size() + additional_rows;
+    if (rows <= objects_.capacity())
+        return;
+    // Keep geometric growth so many small reservations stay amortized O(1)
+    const size_t capacity = std::max(rows, objects_.capacity() * 2);
+    objects_.reserve(capacity);
+    for (auto &column : columns_)
+    {
+        column.reserve(capacity);
+    }
+}
+
+void Archetype::Clear()
+{
+    objects_.clear();
+    for (auto &column : columns_)
+    {
+        column.clear();
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "component_type_id.h"
+
+class Component;
+class GameObject;
+
+// Groups every GameObject that has exactly the same set of component types.
+// Each component type is a column parallel to the object list, so a query such
+// as "all Transform+MeshRenderer" walks a few dense arrays instead of chasing
+// per-object lookups.
+//
+// Columns hold pointers into the per-type ComponentStorage, not the components
+// themselves: components keep their address for life (objects cache Transform*
+// and the like), and by-value columns would move them whenever an object gains
+// a component and changes archetype. A query therefore follows one pointer per
+// component; objects created together still land in neighbouring storage slots.
+class Archetype
+{
+public:
+    // `signature` must be sorted and free of duplicates
+    explicit Archetype(std::vector<ComponentTypeId> signature);
+
+    Archetype(const Archetype &) = delete;
+    Archetype &operator=(const Archetype &) = delete;
+
+    const std::vector<ComponentTypeId> &Signature() const { return signature_; }
+    ComponentMask Mask() const { return mask_; }
+    size_t Size() const { return objects_.size(); }
+
+    // Column index for a type, or -1 if the type is not part of this archetype.
+    // The signature is sorted by id, so the column is the type's rank in the mask.
+    int ColumnIndex(ComponentTypeId type) const
+    {
+        return Has(type) ? ComponentRank(mask_, type) : -1;
+    }
+    bool Has(ComponentTypeId type) const { return (mask_ & ComponentBit(type)) != 0; }
+
+    GameObject *const *Objects() const { return objects_.data(); }
+    Component *const *Column(size_t column) const { return columns_[column].data(); }
+    Component *Get(size_t column, size_t row) const { return columns_[column][row]; }
+
+    // `components` holds one entry per signature type, in signature order
+    size_t AddRow(GameObject *object, Component *const *components);
+    // Swap-removes `row`; returns the object moved into `row`, or nullptr if none moved
+    GameObject *RemoveRow(size_t row);
+    void Reserve(size_t additional_rows);
+    // Drops every row (the component pointers are not owned)
+    void Clear();
+
+    // Cached transitions to the archetype that additionally has `type`
+    Archetype *FindAddEdge(ComponentTypeId type) const { return add_edges_[type]; }
+    void SetAddEdge(ComponentTypeId type, Archetype *target) { add_edges_[type] = target; }
+
+private:
+    std::vector<ComponentTypeId> signature_;
+    ComponentMask mask_ = 0;
+    std::vector<GameObject *> objects_;
+    std::vector<std::vector<Component *>> columns_;
+    std::array<Archetype *, kMaxComponentTypes> add_edges_{};
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cfloat>
+#include <cmath>
+#include <glm/glm.hpp>
+
+// Axis-aligned bounding box. A default-constructed box is empty (min > max) and
+// becomes valid after the first Expand.
+struct Aabb
+{
+    glm::vec3 min{FLT_MAX, FLT_MAX, FLT_MAX};
+    glm::vec3 max{-FLT_MAX, -FLT_MAX, -FLT_MAX};
+
+    bool IsEmpty() const { return min.x > max.x || min.y > max.y || min.z > max.z; }
+    glm::vec3 Center() const { return (min + max) * 0.5f; }
+    glm::vec3 Extents() const { return (max - min) * 0.5f; }
+
+    void Expand(const glm::vec3 &point)
+    {
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+    }
+
+    void Expand(const Aabb &other)
+    {
+        min = glm::min(min, other.min);
+        max = glm::max(max, other.max);
+    }
+
+    bool Contains(const Aabb &other) const
+    {
+        return min.x <= other.min.x && min.y <= other.min.y && min.z <= other.min.z &&
+               max.x >= other.max.x && max.y >= other.max.y && max.z >= other.max.z;
+    }
+
+    bool Overlaps(const Aabb &other) const
+    {
+        return min.x <= other.max.x && min.y <= other.max.y && min.z <= other.max.z &&
+               max.x >= other.min.x && max.y >= other.min.y && max.z >= other.min.z;
+    }
+
+    // Half the surface area; only ratios matter for tree-quality heuristics
+    float HalfArea() const
+    {
+        if (IsEmpty())
+            return 0.0f;
+        const glm::vec3 d = max - min;
+        return d.x * d.y + d.y * d.z + d.z * d.x;
+    }
+
+    // Box enclosing this box after an affine transform (Arvo's method: the new
+    // extents are |M| applied to the old extents)
+    Aabb Transformed(const glm::mat4 &m) const
+    {
+        if (IsEmpty())
+            return *this;
+        const glm::vec3 c = glm::vec3(m * glm::vec4(Center(), 1.0f));
+        const glm::vec3 e = Extents();
+        const glm::vec3 r(std::abs(m[0][0]) * e.x + std::abs(m[1][0]) * e.y + std::abs(m[2][0]) * e.z,
+                          std::abs(m[0][1]) * e.x + std::abs(m[1][1]) * e.y + std::abs(m[2][1]) * e.z,
+                          std::abs(m[0][2]) * e.x + std::abs(m[1][2]) * e.y + std::abs(m[2][2]) * e.z);
+        Aabb out;
+        out.min = c - r;
+        out.max = c + r;
+        return out;
+    }
+};
@@ -1,5 +1,6 @@
 #include "camera.h"
 #include "game_object.h"
+#include "gl_state_cache.h"
 #include "scene.h"
 #include "transform.h"
 #include <glad/glad.h>
@@ -18,12 +19,9 @@ glm::mat4 Camera::ViewMatrix() const
         return glm::mat4(1.0f);
     }
 
-    // Build a view matrix from the transform's position and Euler rotation.
-    // We assume the Transform's LocalToWorld uses XYZ Euler rotations and scale.
     // The camera looks along -Z in its local space.
-    glm::mat4 world = t->LocalToWorld();
-    // View is inverse of world transform
-    return glm::inverse(world);
+    // View is inverse of the (cached) world transform
+    return glm::inverse(t->LocalToWorld());
 }
 
 glm::vec3 Camera::Position() const
@@ -32,7 +30,7 @@ glm::vec3 Camera::Position() const
     {
         cached_transform_ = Owner()->GetComponent<Transform>();
     }
-    return cached_transform_->position;
+    return cached_transform_ ? cached_transform_->GetWorldPosition() : glm::vec3(0.0f);
 }
 
 glm::mat4 Camera::ProjectionMatrix() const
@@ -40,10 +38,9 @@ glm::mat4 Camera::ProjectionMatrix() const
     float ar = aspect_ratio;
     if (sync_aspect_with_window)
     {
-        // Query current OpenGL viewport to derive aspect. This keeps cameras in sync with window size
-        // without tight coupling.
-        GLint vp[4] = {0, 0, 1, 1};
-        glGetIntegerv(GL_VIEWPORT, vp);
+        // Derive aspect from the current viewport (as last set through the state cache). This keeps
+        // cameras in sync with window size without tight coupling or a driver query per call.
+        const GLint *vp = GLStateCache::GetInstance().Viewport();
         const float w = static_cast<float>(vp[2]);
         const float h = static_cast<float>(vp[3]);
         if (w > 0.0f && h > 0.0f)
@@ -2,6 +2,7 @@
 
 #include <glm/glm.hpp>
 #include <memory>
+#include "component_type_id.h"
 
 class GameObject;
 class Renderer;
@@ -11,9 +12,18 @@ class Component
 public:
     virtual ~Component() = default;
 
+    // Derived types whose OnUpdate touches nothing but their own object may set
+    // this to true so the scene updates them on worker threads. That rules out
+    // creating objects/components, GL calls and moving a Transform with children.
+    static constexpr bool kParallelUpdate = false;
+
     void SetOwner(GameObject* owner) { owner_ = owner; }
     GameObject* Owner() const { return owner_; }
 
+    // Dense id of the concrete type; assigned when the registry stores the component
+    ComponentTypeId TypeId() const { return type_id_; }
+    uint32_t StorageIndex() const { return storage_index_; }
+
     // Lifecycle helpers for performance and correctness
     bool IsStarted() const { return started_; }
     void MarkStarted() { started_ = true; }
@@ -31,6 +41,13 @@ public:
 protected:
     GameObject* owner_ = nullptr;
     bool started_ = false;
+
+private:
+    template <typename T>
+    friend class ComponentStorage;
+
+    ComponentTypeId type_id_ = kInvalidComponentTypeId;
+    uint32_t storage_index_ = 0; // slot in the owning ComponentStorage
 };
 
 
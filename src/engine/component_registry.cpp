@@ -0,0 +1,234 @@
+#include "component_registry.h"
+#include "game_object.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+ComponentRegistry::ComponentRegistry()
+{
+    archetypes_.push_back(std::make_unique<Archetype>(std::vector<ComponentTypeId>{}));
+    empty_archetype_ = archetypes_.back().get();
+}
+
+void ComponentRegistry::Register(GameObject &object)
+{
+    object.archetype_ = empty_archetype_;
+    object.archetype_row_ = empty_archetype_->AddRow(&object, nullptr);
+}
+
+void ComponentRegistry::CloneInto(const GameObject &source, GameObject *const *targets, size_t count)
+{
+    clone_batches_.clear();
+    clone_scratch_.clear();
+    if (count == 0)
+    {
+        return;
+    }
+
+    // One batch of `count` copies per cloneable component of `source`, in attach order
+    ComponentMask mask = 0;
+    for (size_t i = 0; i < source.component_count_; ++i)
+    {
+        const Component *c = source.components_[i];
+        const ComponentTypeId type = c->TypeId();
+        ComponentStorageBase *storage = type != kInvalidComponentTypeId ? storage_by_type_[type] : nullptr;
+        if (!storage)
+            continue;
+        const size_t offset = clone_scratch_.size();
+        clone_scratch_.resize(offset + count);
+        if (!storage->EmplaceCopies(*c, count, clone_scratch_.data() + offset))
+        {
+            clone_scratch_.resize(offset);
+            continue;
+        }
+        // Like Attach, only the first component of a type gets a lookup slot
+        const bool first_of_type = (mask & ComponentBit(type)) == 0;
+        mask |= ComponentBit(type);
+        clone_batches_.push_back(CloneBatch{storage, offset, type, first_of_type});
+    }
+
+    // Every clone ends up with the same component set, so slots and archetype are shared
+    Archetype &archetype = ArchetypeWithMask(mask);
+    archetype.Reserve(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        GameObject &target = *targets[i];
+        for (const CloneBatch &batch : clone_batches_)
+        {
+            Component *copy = clone_scratch_[batch.offset + i];
+            copy->SetOwner(&target);
+            target.components_[target.component_count_++] = copy;
+            if (batch.first_of_type)
+            {
+                target.component_slots_[ComponentRank(mask, batch.type)] = copy;
+            }
+        }
+        target.component_mask_ = mask;
+        target.archetype_ = &archetype;
+        target.archetype_row_ = archetype.AddRow(&target, target.component_slots_.data());
+    }
+
+    for (const CloneBatch &batch : clone_batches_)
+    {
+        batch.storage->AttachAll(clone_scratch_.data() + batch.offset, count);
+    }
+}
+
+void ComponentRegistry::CheckSlotAvailable(const GameObject &owner) const
+{
+    if (owner.component_count_ >= GameObject::kMaxComponentsPerObject)
+    {
+        throw std::runtime_error("GameObject already has the maximum number of components (16)");
+    }
+}
+
+void ComponentRegistry::DestroyComponents(GameObject &object)
+{
+    // Detach everything first so OnDetach can still reach sibling components
+    for (size_t i = 0; i < object.component_count_; ++i)
+    {
+        object.components_[i]->OnDetach();
+    }
+    if (object.archetype_)
+    {
+        if (GameObject *moved = object.archetype_->RemoveRow(object.archetype_row_))
+        {
+            moved->archetype_row_ = object.archetype_row_;
+        }
+        object.archetype_ = nullptr;
+    }
+    for (size_t i = 0; i < object.component_count_; ++i)
+    {
+        const Component *c = object.components_[i];
+        storage_by_type_[c->TypeId()]->Remove(c->StorageIndex());
+    }
+    object.component_count_ = 0;
+    object.component_mask_ = 0;
+}
+
+void ComponentRegistry::Attach(GameObject &owner, Component *component)
+{
+    const ComponentTypeId type = component->TypeId();
+    const ComponentMask bit = ComponentBit(type);
+    // Objects keep only the first component of a given type in their lookup slots
+    // and archetype row; duplicates are still updated/rendered through their storage.
+    if (owner.component_mask_ & bit)
+    {
+        return;
+    }
+
+    // Slots are ordered by type id so GetComponent can index them by mask rank
+    const int rank = ComponentRank(owner.component_mask_, type);
+    const int count = PopCount(owner.component_mask_);
+    for (int i = count; i > rank; --i)
+    {
+        owner.component_slots_[i] = owner.component_slots_[i - 1];
+    }
+    owner.component_slots_[rank] = component;
+    owner.component_mask_ |= bit;
+
+    Archetype *from = owner.archetype_;
+    if (!from)
+    {
+        return;
+    }
+
+    // The slots are in signature order already, so they double as the new row
+    Archetype &to = ArchetypeWith(*from, type);
+    if (GameObject *moved = from->RemoveRow(owner.archetype_row_))
+    {
+        moved->archetype_row_ = owner.archetype_row_;
+    }
+    owner.archetype_ = &to;
+    owner.archetype_row_ = to.AddRow(&owner, owner.component_slots_.data());
+}
+
+Archetype &ComponentRegistry::ArchetypeWithMask(ComponentMask mask)
+{
+    // Walk add-edges from the empty archetype, one type at a time in id order
+    Archetype *archetype = empty_archetype_;
+    for (ComponentTypeId type = 0; mask != 0; ++type, mask >>= 1)
+    {
+        if (mask & 1)
+        {
+            archetype = &ArchetypeWith(*archetype, type);
+        }
+    }
+    return *archetype;
+}
+
+Archetype &ComponentRegistry::ArchetypeWith(Archetype &from, ComponentTypeId type)
+{
+    if (Archetype *cached = from.FindAddEdge(type))
+    {
+        return *cached;
+    }
+
+    const ComponentMask mask = from.Mask() | ComponentBit(type);
+    Archetype *target = nullptr;
+    for (auto &archetype : archetypes_)
+    {
+        if (archetype->Mask() == mask)
+        {
+            target = archetype.get();
+            break;
+        }
+    }
+    if (!target)
+    {
+        std::vector<ComponentTypeId> signature = from.Signature();
+        signature.insert(std::upper_bound(signature.begin(), signature.end(), type), type);
+        archetypes_.push_back(std::make_unique<Archetype>(std::move(signature)));
+        target = archetypes_.back().get();
+    }
+    from.SetAddEdge(type, target);
+    return *target;
+}
+
+void ComponentRegistry::UpdateAll(float time_seconds, JobSystem *jobs)
+{
+    // Index-based so storages created by OnStart/OnUpdate are picked up safely
+    for (size_t i = 0; i < storages_.size(); ++i)
+    {
+        storages_[i]->UpdateAll(time_seconds, jobs);
+    }
+}
+
+void ComponentRegistry::RenderAll(Renderer &renderer, const glm::mat4 &projection, const glm::mat4 &view,
+                                  ComponentTypeId skip)
+{
+    ComponentStorageBase *skipped = skip < kMaxComponentTypes ? storage_by_type_[skip] : nullptr;
+    for (size_t i = 0; i < storages_.size(); ++i)
+    {
+        if (storages_[i].get() != skipped)
+        {
+            storages_[i]->RenderAll(renderer, projection, view);
+        }
+    }
+}
+
+CombinedPoolStats ComponentRegistry::Stats() const
+{
+    CombinedPoolStats total;
+    for (const auto &storage : storages_)
+    {
+        const PoolStats stats = storage->Stats();
+        total.live += stats.live;
+        total.capacity += stats.capacity;
+        total.chunks += stats.chunks;
+        total.high_water_sum += stats.high_water;
+    }
+    return total;
+}
+
+void ComponentRegistry::ReleaseAll()
+{
+    for (auto &storage : storages_)
+    {
+        storage->ReleaseAll();
+    }
+    for (auto &archetype : archetypes_)
+    {
+        archetype->Clear();
+    }
+}
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <array>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <glm/glm.hpp>
+#include "archetype.h"
+#include "component_storage.h"
+#include "handle.h"
+
+class GameObject;
+class Renderer;
+
+// Component pools added up. The pools peak at different times, so their
+// high-water marks do not add up to one; only their sum is reported.
+struct CombinedPoolStats
+{
+    size_t live = 0;
+    size_t capacity = 0;
+    size_t chunks = 0;
+    size_t high_water_sum = 0;   // sum of each pool's own high_water
+
+    float Occupancy() const { return capacity ? static_cast<float>(live) / static_cast<float>(capacity) : 0.0f; }
+};
+
+// Owns every component of a Scene. Components live in per-type chunked storages;
+// GameObjects are grouped into archetypes by their component set so that queries
+// over several component types iterate dense columns.
+class ComponentRegistry
+{
+public:
+    ComponentRegistry();
+    ComponentRegistry(const ComponentRegistry &) = delete;
+    ComponentRegistry &operator=(const ComponentRegistry &) = delete;
+
+    template <typename T>
+    ComponentStorage<T> &Storage()
+    {
+        const ComponentTypeId type = ComponentTypeIds::Of<T>();
+        if (ComponentStorageBase *existing = storage_by_type_[type])
+        {
+            return static_cast<ComponentStorage<T> &>(*existing);
+        }
+        auto storage = std::make_unique<ComponentStorage<T>>();
+        ComponentStorage<T> &ref = *storage;
+        storage_by_type_[type] = storage.get();
+        storages_.push_back(std::move(storage));
+        return ref;
+    }
+
+    template <typename T, typename... Args>
+    T *Emplace(GameObject &owner, Args &&...args)
+    {
+        CheckSlotAvailable(owner);
+        T *component = Storage<T>().Emplace(std::forward<Args>(args)...);
+        Attach(owner, component);
+        return component;
+    }
+
+    // Gives each of `targets` (new, unregistered objects) a copy of every cloneable
+    // component of `source`. Copies are made per type in bulk, objects go straight
+    // into their final archetype, and OnAttach runs once all copies are in place.
+    void CloneInto(const GameObject &source, GameObject *const *targets, size_t count);
+
+    // Places a freshly created GameObject into the empty archetype
+    void Register(GameObject &object);
+
+    // Runs OnDetach on all of `object`'s components, then removes them from the
+    // archetype and returns their pool slots. The object is left empty.
+    void DestroyComponents(GameObject &object);
+
+    // Generational handles to components (see handle.h)
+    template <typename T>
+    ComponentHandle<T> HandleOf(const T &component)
+    {
+        if (component.TypeId() != ComponentTypeIds::Of<T>())
+        {
+            return {};
+        }
+        const uint32_t index = component.StorageIndex();
+        return ComponentHandle<T>{index, Storage<T>().Generation(index)};
+    }
+
+    template <typename T>
+    T *Resolve(ComponentHandle<T> handle)
+    {
+        ComponentStorageBase *storage = handle.IsNull() ? nullptr : storage_by_type_[ComponentTypeIds::Of<T>()];
+        return storage ? static_cast<ComponentStorage<T> *>(storage)->TryGet(handle.index, handle.generation) : nullptr;
+    }
+
+    // Visits every object that has all of Ts, passing references to those components
+    template <typename... Ts, typename Fn>
+    void ForEach(Fn &&fn)
+    {
+        const ComponentTypeId types[] = {ComponentTypeIds::Of<Ts>()...};
+        ComponentMask required = 0;
+        for (ComponentTypeId type : types)
+        {
+            required |= ComponentBit(type);
+        }
+        for (auto &archetype : archetypes_)
+        {
+            if (archetype->Size() == 0 || (archetype->Mask() & required) != required)
+                continue;
+            int columns[sizeof...(Ts)];
+            for (size_t i = 0; i < sizeof...(Ts); ++i)
+            {
+                columns[i] = archetype->ColumnIndex(types[i]);
+            }
+            ForEachRow<Ts...>(*archetype, columns, fn, std::index_sequence_for<Ts...>{});
+        }
+    }
+
+    // Storages run one after another in creation order, i.e. the order in which
+    // each type was first added to the scene; `jobs` (optional) parallelizes
+    // within a storage
+    void UpdateAll(float time_seconds, JobSystem *jobs = nullptr);
+    // `skip` leaves one type out, for callers that render it themselves (e.g. culled)
+    void RenderAll(Renderer &renderer, const glm::mat4 &projection, const glm::mat4 &view,
+                   ComponentTypeId skip = kInvalidComponentTypeId);
+
+    const std::vector<std::unique_ptr<Archetype>> &GetArchetypes() const { return archetypes_; }
+
+    // Every component pool added up; per-type figures come from Storage<T>().Stats()
+    CombinedPoolStats Stats() const;
+
+    // Destroys all components and returns their pool memory in one pass per type.
+    // Objects must not be used afterwards.
+    void ReleaseAll();
+
+private:
+    // Throws before anything is stored if `owner` cannot take another component
+    void CheckSlotAvailable(const GameObject &owner) const;
+    void Attach(GameObject &owner, Component *component);
+    Archetype &ArchetypeWith(Archetype &from, ComponentTypeId type);
+    Archetype &ArchetypeWithMask(ComponentMask mask);
+
+    template <typename... Ts, typename Fn, size_t... I>
+    static void ForEachRow(const Archetype &archetype, const int *columns, Fn &fn, std::index_sequence<I...>)
+    {
+        Component *const *data[] = {archetype.Column(static_cast<size_t>(columns[I]))...};
+        const size_t rows = archetype.Size();
+        for (size_t row = 0; row < rows; ++row)
+        {
+            fn(*static_cast<Ts *>(data[I][row])...);
+        }
+    }
+
+    // Creation order (drives update/render order) plus a dense by-id lookup
+    std::vector<std::unique_ptr<ComponentStorageBase>> storages_;
+    std::array<ComponentStorageBase *, kMaxComponentTypes> storage_by_type_{};
+    std::vector<std::unique_ptr<Archetype>> archetypes_;
+    Archetype *empty_archetype_ = nullptr;
+
+    // Scratch reused across CloneInto calls
+    struct CloneBatch
+    {
+        ComponentStorageBase *storage;
+        size_t offset; // into clone_scratch_
+        ComponentTypeId type;
+        bool first_of_type;
+    };
+    std::vector<CloneBatch> clone_batches_;
+    std::vector<Component *> clone_scratch_;
+};
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <glm/glm.hpp>
+#include "component.h"
+#include "job_system.h"
+#include "object_pool.h"
+
+class Renderer;
+
+// Type-erased view of a ComponentStorage<T>. The registry keeps one storage per
+// component type and drives lifecycle callbacks through this interface, so the
+// per-frame loops walk each type's components contiguously.
+class ComponentStorageBase
+{
+public:
+    virtual ~ComponentStorageBase() = default;
+
+    // Slots are [0, SlotCount()); freed slots stay as holes until reused
+    virtual size_t SlotCount() const = 0;
+    virtual bool IsAlive(size_t index) const = 0;
+    virtual Component &Get(size_t index) = 0;
+
+    // Destroys the component in `index` and returns the slot to the free list
+    virtual void Remove(size_t index) = 0;
+    // Destroys every component and frees all chunk memory
+    virtual void ReleaseAll() = 0;
+    virtual PoolStats Stats() const = 0;
+
+    // Runs OnStart (once) and OnUpdate for every stored component. With a job
+    // system, types that declare kParallelUpdate spread OnUpdate across workers.
+    virtual void UpdateAll(float time_seconds, JobSystem *jobs) = 0;
+    virtual void RenderAll(Renderer &renderer, const glm::mat4 &projection, const glm::mat4 &view) = 0;
+
+    // Makes room for `count` more components
+    virtual void Reserve(size_t count) = 0;
+
+    // Stores `count` copies of `source` (which must be of this storage's type) and
+    // writes them to `out`. Component::Clone runs once to make a prototype; the
+    // copies are then made with T's copy constructor. Returns false, storing
+    // nothing, if the component is not cloneable.
+    virtual bool EmplaceCopies(const Component &source, size_t count, Component **out) = 0;
+
+    // Calls OnAttach on each of `components` without going through the vtable
+    virtual void AttachAll(Component *const *components, size_t count) = 0;
+};
+
+// Pooled storage for all components of one type. Components live in fixed-size
+// chunks that are never reallocated, so addresses stay stable (components cache
+// raw Transform* etc.); removed slots are recycled through a free list.
+template <typename T>
+class ComponentStorage : public ComponentStorageBase
+{
+public:
+    // Smallest batch worth handing to another thread
+    static constexpr size_t kParallelMinGrain = 64;
+
+    ComponentStorage() = default;
+    ComponentStorage(const ComponentStorage &) = delete;
+    ComponentStorage &operator=(const ComponentStorage &) = delete;
+
+    template <typename... Args>
+    T *Emplace(Args &&...args)
+    {
+        const size_t index = pool_.Emplace(std::forward<Args>(args)...);
+        T &component = pool_.At(index);
+        component.type_id_ = ComponentTypeIds::Of<T>();
+        component.storage_index_ = static_cast<uint32_t>(index);
+        return &component;
+    }
+
+    T &At(size_t index) { return pool_.At(index); }
+    uint32_t Generation(size_t index) const { return pool_.Generation(index); }
+    T *TryGet(size_t index, uint32_t generation) { return pool_.TryGet(index, generation); }
+
+    // Visits live components in slot order. Safe against components added during the walk.
+    template <typename Fn>
+    void ForEach(Fn &&fn) { pool_.ForEach(std::forward<Fn>(fn)); }
+
+    size_t SlotCount() const override { return pool_.SlotCount(); }
+    bool IsAlive(size_t index) const override { return pool_.IsAlive(index); }
+    Component &Get(size_t index) override { return pool_.At(index); }
+
+    void Remove(size_t index) override { pool_.Free(index); }
+    void ReleaseAll() override { pool_.ReleaseAll(); }
+    PoolStats Stats() const override { return pool_.Stats(); }
+
+    void UpdateAll(float time_seconds, JobSystem *jobs) override
+    {
+        if constexpr (T::kParallelUpdate)
+        {
+            if (jobs && jobs->WorkerCount() > 0 && pool_.Live() > kParallelMinGrain)
+            {
+                // OnStart may touch the scene, so it always runs on the calling thread
+                for (size_t i = 0; i < pool_.SlotCount(); ++i)
+                {
+                    if (pool_.IsAlive(i))
+                    {
+                        Start(pool_.At(i));
+                    }
+                }
+                auto update_range = [this, time_seconds](size_t begin, size_t end)
+                {
+                    for (size_t i = begin; i < end; ++i)
+                    {
+                        if (pool_.IsAlive(i))
+                        {
+                            pool_.At(i).OnUpdate(time_seconds);
+                        }
+                    }
+                };
+                jobs->ParallelFor(pool_.SlotCount(), kParallelMinGrain, update_range);
+                return;
+            }
+        }
+
+        for (size_t i = 0; i < pool_.SlotCount(); ++i)
+        {
+            if (!pool_.IsAlive(i))
+                continue;
+            T &c = pool_.At(i);
+            Start(c);
+            c.OnUpdate(time_seconds);
+        }
+    }
+
+    void RenderAll(Renderer &renderer, const glm::mat4 &projection, const glm::mat4 &view) override
+    {
+        for (size_t i = 0; i < pool_.SlotCount(); ++i)
+        {
+            if (pool_.IsAlive(i))
+            {
+                pool_.At(i).OnRender(renderer, projection, view);
+            }
+        }
+    }
+
+    void Reserve(size_t count) override { pool_.Reserve(count); }
+
+    bool EmplaceCopies(const Component &source, size_t count, Component **out) override
+    {
+        std::unique_ptr<Component> cloned = source.Clone();
+        T *prototype = dynamic_cast<T *>(cloned.get());
+        if (!prototype)
+        {
+            return false;
+        }
+        pool_.Reserve(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            if constexpr (std::is_copy_constructible<T>::value)
+            {
+                out[i] = Emplace(static_cast<const T &>(*prototype));
+            }
+            else
+            {
+                // Move-only types need a fresh prototype per copy
+                out[i] = Emplace(std::move(*prototype));
+                if (i + 1 < count)
+                {
+                    cloned = source.Clone();
+                    prototype = static_cast<T *>(cloned.get());
+                }
+            }
+        }
+        return true;
+    }
+
+    void AttachAll(Component *const *components, size_t count) override
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            static_cast<T *>(components[i])->T::OnAttach();
+        }
+    }
+
+private:
+    static void Start(T &c)
+    {
+        if (!c.IsStarted())
+        {
+            c.OnStart();
+            c.MarkStarted();
+        }
+    }
+
+    ObjectPool<T> pool_;
+};
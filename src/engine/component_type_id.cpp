@@ -0,0 +1,22 @@
+#include "component_type_id.h"
+
+#include <atomic>
+#include <stdexcept>
+
+static std::atomic<ComponentTypeId> g_next_component_type_id{0};
+
+ComponentTypeId ComponentTypeIds::Next()
+{
+    const ComponentTypeId id = g_next_component_type_id.fetch_add(1);
+    if (id >= kMaxComponentTypes)
+    {
+        throw std::runtime_error("Too many component types (limit is 64)");
+    }
+    return id;
+}
+
+size_t ComponentTypeIds::Count()
+{
+    const size_t count = g_next_component_type_id.load();
+    return count < kMaxComponentTypes ? count : kMaxComponentTypes;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+class Component;
+
+// Dense small-integer id per component type, used to index bitmasks and fixed
+// arrays instead of hashing std::type_index.
+using ComponentTypeId = uint32_t;
+using ComponentMask = uint64_t;
+
+constexpr size_t kMaxComponentTypes = 64; // one bit per type in a ComponentMask
+constexpr ComponentTypeId kInvalidComponentTypeId = ~ComponentTypeId(0);
+
+class ComponentTypeIds
+{
+public:
+    // Ids are handed out on first use, so they are stable for the run but not
+    // across builds. Throws if more than kMaxComponentTypes types are used.
+    template <typename T>
+    static ComponentTypeId Of()
+    {
+        static_assert(std::is_base_of<Component, T>::value, "T must inherit from Component");
+        static const ComponentTypeId id = Next();
+        return id;
+    }
+
+    static size_t Count();
+
+private:
+    static ComponentTypeId Next();
+};
+
+inline ComponentMask ComponentBit(ComponentTypeId id)
+{
+    return ComponentMask(1) << id;
+}
+
+inline int PopCount(ComponentMask mask)
+{
+#if defined(_MSC_VER)
+    return static_cast<int>(__popcnt64(mask));
+#else
+    return __builtin_popcountll(mask);
+#endif
+}
+
+// Position of `id` among the set bits of `mask` (number of lower ids present)
+inline int ComponentRank(ComponentMask mask, ComponentTypeId id)
+{
+    return PopCount(mask & (ComponentBit(id) - 1));
+}
@@ -0,0 +1,205 @@
+#include "culling_system.h"
+#include "frustum.h"
+#include "game_object.h"
+#include "transform.h"
+
+#include <algorithm>
+
+// slot_proxy_ markers for slots that have no BVH proxy
+static constexpr uint32_t kEmptySlot = ~uint32_t(0);
+static constexpr uint32_t kUnculledSlot = ~uint32_t(0) - 1;
+
+const std::vector<uint32_t> &CullingSystem::Cull(ComponentStorage<MeshRenderer> &renderers, const glm::mat4 &view_projection,
+                                                 JobSystem *jobs)
+{
+    stats_ = CullingStats{};
+    if (!Refresh(renderers))
+    {
+        Rebuild(renderers);
+    }
+    else if (stats_.moved > 0)
+    {
+        bvh_.Refit();
+        if (bvh_.Cost() > bvh_.BuildCost() * kRebuildCostRatio)
+        {
+            bvh_.Build(proxy_boxes_.data(), proxy_boxes_.size());
+            stats_.rebuilt = true;
+        }
+    }
+
+    visible_ids_.clear();
+    stats_.nodes_tested = bvh_.Cull(Frustum::FromMatrix(view_projection), visible_ids_);
+    stats_.culled = proxies_.size() - visible_ids_.size();
+    if (occlusion_culling_)
+    {
+        Occlude(renderers, view_projection, jobs);
+    }
+
+    visible_slots_.clear();
+    for (uint32_t id : visible_ids_)
+    {
+        visible_slots_.push_back(proxies_[id].slot);
+    }
+    visible_slots_.insert(visible_slots_.end(), unculled_.begin(), unculled_.end());
+    // Storage order keeps draws walking memory forwards, like the unculled path
+    std::sort(visible_slots_.begin(), visible_slots_.end());
+
+    stats_.candidates = proxies_.size();
+    stats_.visible = visible_ids_.size();
+    stats_.unculled = unculled_.size();
+    return visible_slots_;
+}
+
+const Aabb *CullingSystem::SlotBounds(uint32_t slot) const
+{
+    if (slot >= slot_proxy_.size() || slot_proxy_[slot] >= proxies_.size())
+        return nullptr;
+    return &proxy_boxes_[slot_proxy_[slot]];
+}
+
+bool CullingSystem::Refresh(ComponentStorage<MeshRenderer> &renderers)
+{
+    if (slot_proxy_.size() != renderers.SlotCount())
+        return false;
+
+    for (size_t i = 0; i < slot_proxy_.size(); ++i)
+    {
+        const uint32_t proxy = slot_proxy_[i];
+        if (!renderers.IsAlive(i))
+        {
+            if (proxy != kEmptySlot)
+                return false;
+            continue;
+        }
+        if (slot_generation_[i] != renderers.Generation(i))
+            return false;
+
+        MeshRenderer &renderer = renderers.At(i);
+        // Statically batched renderers are culled with their batch and have no proxy
+        if ((proxy == kEmptySlot) != renderer.IsStaticBatched())
+            return false;
+        if (proxy == kEmptySlot)
+            continue;
+        const Aabb *local_bounds = renderer.LocalBounds();
+        if ((proxy == kUnculledSlot) != (local_bounds == nullptr))
+            return false;
+        if (proxy == kUnculledSlot)
+            continue;
+
+        Proxy &p = proxies_[proxy];
+        bool stale = p.local_bounds != local_bounds;
+        if (p.transform)
+        {
+            // Resolves a pending world matrix, which bumps the version if it moved
+            p.transform->LocalToWorld();
+            stale = stale || p.transform->WorldVersion() != p.world_version;
+        }
+        else
+        {
+            stale = stale || (renderer.Owner() && renderer.Owner()->GetComponent<Transform>());
+        }
+        if (!stale)
+            continue;
+
+        p.local_bounds = local_bounds;
+        proxy_boxes_[proxy] = WorldBounds(renderer, p);
+        bvh_.Update(proxy, proxy_boxes_[proxy]);
+        ++stats_.moved;
+    }
+    return true;
+}
+
+void CullingSystem::Rebuild(ComponentStorage<MeshRenderer> &renderers)
+{
+    proxies_.clear();
+    proxy_boxes_.clear();
+    unculled_.clear();
+    slot_proxy_.assign(renderers.SlotCount(), kEmptySlot);
+    slot_generation_.assign(renderers.SlotCount(), 0);
+    for (size_t i = 0; i < renderers.SlotCount(); ++i)
+    {
+        if (!renderers.IsAlive(i))
+            continue;
+        MeshRenderer &renderer = renderers.At(i);
+        const uint32_t slot = static_cast<uint32_t>(i);
+        slot_generation_[i] = renderers.Generation(i);
+        if (renderer.IsStaticBatched())
+            continue;
+        const Aabb *local_bounds = renderer.LocalBounds();
+        if (!local_bounds)
+        {
+            slot_proxy_[i] = kUnculledSlot;
+            unculled_.push_back(slot);
+            continue;
+        }
+        slot_proxy_[i] = static_cast<uint32_t>(proxies_.size());
+        proxies_.push_back(Proxy{slot, local_bounds, nullptr, 0});
+        proxy_boxes_.push_back(WorldBounds(renderer, proxies_.back()));
+    }
+    bvh_.Build(proxy_boxes_.data(), proxy_boxes_.size());
+    stats_.rebuilt = true;
+}
+
+Aabb CullingSystem::WorldBounds(MeshRenderer &renderer, Proxy &proxy)
+{
+    // Looked up lazily: the Transform may be added after the renderer
+    if (!proxy.transform && renderer.Owner())
+    {
+        proxy.transform = renderer.Owner()->GetComponent<Transform>();
+    }
+    if (!proxy.transform)
+        return *proxy.local_bounds;
+    const glm::mat4 &model = proxy.transform->LocalToWorld();
+    proxy.world_version = proxy.transform->WorldVersion();
+    return proxy.local_bounds->Transformed(model);
+}
+
+void CullingSystem::Occlude(ComponentStorage<MeshRenderer> &renderers, const glm::mat4 &view_projection, JobSystem *jobs)
+{
+    occluder_meshes_.clear();
+    occludee_ids_.clear();
+    occludee_boxes_.clear();
+    for (uint32_t id : visible_ids_)
+    {
+        MeshRenderer &renderer = renderers.At(proxies_[id].slot);
+        const Mesh *mesh = renderer.GetMesh().get();
+        if (!renderer.occluder || mesh->indices.empty())
+        {
+            occludee_ids_.push_back(id);
+            occludee_boxes_.push_back(proxy_boxes_[id]);
+            continue;
+        }
+        // Occluders are drawn, never tested: they would only be compared with themselves
+        OccluderMesh occluder;
+        occluder.vertices = mesh->vertices.data();
+        occluder.indices = mesh->indices.data();
+        occluder.index_count = mesh->indices.size();
+        occluder.index_size = mesh->indices.IndexSize();
+        occluder.model = proxies_[id].transform ? proxies_[id].transform->LocalToWorld() : glm::mat4(1.0f);
+        occluder_meshes_.push_back(occluder);
+    }
+    stats_.occluders = occluder_meshes_.size();
+    if (occluder_meshes_.empty() || occludee_ids_.empty())
+        return;
+
+    occlusion_buffer_.Render(occluder_meshes_.data(), occluder_meshes_.size(), view_projection, jobs);
+    occludee_hidden_.resize(occludee_ids_.size());
+    stats_.occluded = occlusion_buffer_.TestBoxes(occludee_boxes_.data(), occludee_boxes_.size(), occludee_hidden_.data(), jobs);
+    if (stats_.occluded == 0)
+        return;
+
+    // occludee_ids_ is a subsequence of visible_ids_, so one cursor pairs them up
+    size_t kept = 0;
+    size_t occludee = 0;
+    for (size_t i = 0; i < visible_ids_.size(); ++i)
+    {
+        const uint32_t id = visible_ids_[i];
+        if (occludee < occludee_ids_.size() && occludee_ids_[occludee] == id)
+        {
+            if (occludee_hidden_[occludee++])
+                continue;
+        }
+        visible_ids_[kept++] = id;
+    }
+    visible_ids_.resize(kept);
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "component_storage.h"
+#include "mesh_renderer.h"
+#include "occlusion_buffer.h"
+#include "scene_bvh.h"
+
+class JobSystem;
+class Transform;
+
+// What the last CullingSystem::Cull did
+struct CullingStats
+{
+    size_t candidates = 0;     // renderers with bounds, tested against the frustum
+    size_t visible = 0;        // candidates that passed every test
+    size_t culled = 0;         // candidates outside the frustum
+    size_t unculled = 0;       // renderers drawn unconditionally (no mesh, skybox, instanced)
+    size_t occluders = 0;      // visible renderers rasterized into the occlusion buffer
+    size_t occluded = 0;       // frustum-visible candidates hidden behind occluders
+    size_t nodes_tested = 0;   // BVH nodes classified against the frustum
+    size_t moved = 0;          // renderers whose world bounds were refreshed
+    bool rebuilt = false;      // the BVH was rebuilt rather than refitted
+};
+
+// Frustum culling for MeshRenderers. Keeps a SceneBvh of world-space mesh bounds
+// in step with the renderer storage: adding or removing renderers rebuilds it,
+// moved objects (detected through Transform::WorldVersion) are refitted.
+// Renderers drawn through a static batch are left out; instanced meshes are
+// always drawn, since one renderer's bounds do not cover its instances.
+// Optionally, frustum-visible renderers flagged as occluders are then rasterized
+// into an OcclusionBuffer and the remaining candidates tested against it.
+class CullingSystem
+{
+public:
+    // Returns the storage slots of the renderers to draw this frame, ascending.
+    // `jobs` (optional) spreads the occlusion pass across workers.
+    const std::vector<uint32_t> &Cull(ComponentStorage<MeshRenderer> &renderers, const glm::mat4 &view_projection,
+                                      JobSystem *jobs = nullptr);
+
+    void SetOcclusionCulling(bool enabled) { occlusion_culling_ = enabled; }
+    bool GetOcclusionCulling() const { return occlusion_culling_; }
+    OcclusionBuffer &GetOcclusionBuffer() { return occlusion_buffer_; }
+
+    // World bounds the last Cull used for the renderer in `slot`, or nullptr if it is drawn unculled
+    const Aabb *SlotBounds(uint32_t slot) const;
+
+    const CullingStats &LastStats() const { return stats_; }
+    const SceneBvh &Bvh() const { return bvh_; }
+
+private:
+    // Rebuild once refits have made the tree this much more expensive to query
+    static constexpr float kRebuildCostRatio = 2.0f;
+
+    struct Proxy
+    {
+        uint32_t slot;
+        const Aabb *local_bounds;
+        const Transform *transform;
+        uint32_t world_version;
+    };
+
+    // Refits moved proxies; returns false if the renderer set changed and the BVH must be rebuilt
+    bool Refresh(ComponentStorage<MeshRenderer> &renderers);
+    void Rebuild(ComponentStorage<MeshRenderer> &renderers);
+    static Aabb WorldBounds(MeshRenderer &renderer, Proxy &proxy);
+    // Drops ids from visible_ids_ whose boxes are hidden behind the visible occluders
+    void Occlude(ComponentStorage<MeshRenderer> &renderers, const glm::mat4 &view_projection, JobSystem *jobs);
+
+    SceneBvh bvh_;
+    std::vector<Proxy> proxies_;
+    std::vector<Aabb> proxy_boxes_;
+    // Per storage slot: proxy id (or one of the markers below) and the generation it was seen with
+    std::vector<uint32_t> slot_proxy_;
+    std::vector<uint32_t> slot_generation_;
+    std::vector<uint32_t> unculled_;
+    std::vector<uint32_t> visible_ids_;
+    std::vector<uint32_t> visible_slots_;
+    bool occlusion_culling_ = false;
+    OcclusionBuffer occlusion_buffer_;
+    std::vector<OccluderMesh> occluder_meshes_;
+    std::vector<uint32_t> occludee_ids_;
+    std::vector<Aabb> occludee_boxes_;
+    std::vector<uint8_t> occludee_hidden_;
+    CullingStats stats_;
+};
@@ -104,20 +104,22 @@ void DebugCameraController::OnUpdate(float timeSeconds)
     // Camera Rotation
     if (right_down || right_arrow_down || left_arrow_down || up_arrow_down || down_arrow_down)
     {
-        cached_transform_->rotation_euler.y += static_cast<float>(dx + arrow_dx) * rotate_sensitivity;
-        cached_transform_->rotation_euler.x += static_cast<float>(dy + arrow_dy) * rotate_sensitivity;
-        cached_transform_->rotation_euler.x = glm::clamp(cached_transform_->rotation_euler.x, -89.0f, 89.0f);
+        glm::vec3 euler = cached_transform_->GetEulerAngles();
+        euler.y += static_cast<float>(dx + arrow_dx) * rotate_sensitivity;
+        euler.x += static_cast<float>(dy + arrow_dy) * rotate_sensitivity;
+        euler.x = glm::clamp(euler.x, -89.0f, 89.0f);
+        cached_transform_->SetEulerAngles(euler);
     }
 
     // Panning
-    glm::quat current_orientation = glm::quat(glm::radians(cached_transform_->rotation_euler));
+    glm::quat current_orientation = cached_transform_->GetRotation();
     if (left_down)
     {
         const glm::mat3 rot = glm::mat3_cast(current_orientation);
         const glm::vec3 cam_right = glm::normalize(rot * glm::vec3(1, 0, 0));
         const glm::vec3 cam_up = glm::normalize(rot * glm::vec3(0, 1, 0));
         const glm::vec3 pan_delta = cam_right * static_cast<float>(-dx) * pan_sensitivity + cam_up * static_cast<float>(dy) * pan_sensitivity;
-        cached_transform_->position += pan_delta;
+        cached_transform_->Translate(pan_delta);
     }
     if (wasd_forward != 0.0 || wasd_right != 0.0)
     {
@@ -125,8 +127,8 @@ void DebugCameraController::OnUpdate(float timeSeconds)
         const glm::vec3 cam_right = glm::normalize(rot * glm::vec3(1, 0, 0));
         // const glm::vec3 forward = glm::cross(cam_right, glm::vec3(0, 1, 0));
         const glm::vec3 forward = glm::normalize(rot * glm::vec3(0, 0, -1));
-        cached_transform_->position += forward * static_cast<float>(wasd_forward) * pan_sensitivity * 2.0f;
-        cached_transform_->position += cam_right * static_cast<float>(wasd_right) * pan_sensitivity * 2.0f;
+        cached_transform_->Translate(forward * static_cast<float>(wasd_forward) * pan_sensitivity * 2.0f +
+                                     cam_right * static_cast<float>(wasd_right) * pan_sensitivity * 2.0f);
     }
 
     // Zooming (using the value from OnScroll)
@@ -134,7 +136,7 @@ void DebugCameraController::OnUpdate(float timeSeconds)
     {
         const glm::mat3 rot = glm::mat3_cast(current_orientation);
         const glm::vec3 cam_forward = glm::normalize(rot * glm::vec3(0, 0, -1));
-        cached_transform_->position += cam_forward * static_cast<float>(scroll_y_) * zoom_speed;
+        cached_transform_->Translate(cam_forward * static_cast<float>(scroll_y_) * zoom_speed);
         scroll_y_ = 0.0;
     }
 }
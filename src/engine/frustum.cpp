@@ -0,0 +1,151 @@
+#include "frustum.h"
+
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define COOLGL_X86 1
+#include <immintrin.h>
+#endif
+
+static constexpr int kPlaneCount = 6;
+
+Frustum Frustum::FromMatrix(const glm::mat4 &view_projection)
+{
+    // Gribb/Hartmann: each plane is row 3 plus or minus row 0..2 (glm is [column][row])
+    const glm::mat4 &m = view_projection;
+    const glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    const glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    const glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    const glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+    const glm::vec4 planes[kPlaneCount] = {row3 + row0, row3 - row0, row3 + row1,
+                                           row3 - row1, row3 + row2, row3 - row2};
+
+    Frustum f;
+    for (int i = 0; i < kLanes; ++i)
+    {
+        glm::vec4 p(0.0f, 0.0f, 0.0f, 1.0f);
+        if (i < kPlaneCount)
+        {
+            const float length = glm::length(glm::vec3(planes[i]));
+            p = length > 0.0f ? planes[i] / length : planes[i];
+        }
+        f.nx_[i] = p.x;
+        f.ny_[i] = p.y;
+        f.nz_[i] = p.z;
+        f.d_[i] = p.w;
+        f.abs_nx_[i] = std::abs(p.x);
+        f.abs_ny_[i] = std::abs(p.y);
+        f.abs_nz_[i] = std::abs(p.z);
+    }
+    return f;
+}
+
+#if defined(COOLGL_X86)
+
+Frustum::Result Frustum::Classify(const Aabb &box) const
+{
+    if (box.IsEmpty())
+        return Result::Outside;
+    const glm::vec3 c = box.Center();
+    const glm::vec3 e = box.Extents();
+    const __m128 cx = _mm_set1_ps(c.x), cy = _mm_set1_ps(c.y), cz = _mm_set1_ps(c.z);
+    const __m128 ex = _mm_set1_ps(e.x), ey = _mm_set1_ps(e.y), ez = _mm_set1_ps(e.z);
+    int outside = 0;
+    int inside = 0;
+    for (int half = 0; half < kLanes; half += 4)
+    {
+        // Signed distance of the center and projected radius of the box, per plane
+        __m128 dist = _mm_load_ps(d_ + half);
+        dist = _mm_add_ps(dist, _mm_mul_ps(_mm_load_ps(nx_ + half), cx));
+        dist = _mm_add_ps(dist, _mm_mul_ps(_mm_load_ps(ny_ + half), cy));
+        dist = _mm_add_ps(dist, _mm_mul_ps(_mm_load_ps(nz_ + half), cz));
+        __m128 radius = _mm_mul_ps(_mm_load_ps(abs_nx_ + half), ex);
+        radius = _mm_add_ps(radius, _mm_mul_ps(_mm_load_ps(abs_ny_ + half), ey));
+        radius = _mm_add_ps(radius, _mm_mul_ps(_mm_load_ps(abs_nz_ + half), ez));
+        const __m128 neg_radius = _mm_sub_ps(_mm_setzero_ps(), radius);
+        outside |= _mm_movemask_ps(_mm_cmplt_ps(dist, neg_radius));
+        inside += _mm_movemask_ps(_mm_cmpge_ps(dist, radius)) == 0xF ? 4 : 0;
+    }
+    if (outside)
+        return Result::Outside;
+    return inside == kLanes ? Result::Inside : Result::Intersecting;
+}
+
+size_t Frustum::CullBoxes(const AabbSoA &boxes, size_t count, uint8_t *visible) const
+{
+    size_t visible_count = 0;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128 cx = _mm_loadu_ps(boxes.cx + i), cy = _mm_loadu_ps(boxes.cy + i), cz = _mm_loadu_ps(boxes.cz + i);
+        const __m128 ex = _mm_loadu_ps(boxes.ex + i), ey = _mm_loadu_ps(boxes.ey + i), ez = _mm_loadu_ps(boxes.ez + i);
+        __m128 outside = _mm_setzero_ps();
+        for (int p = 0; p < kPlaneCount; ++p)
+        {
+            __m128 dist = _mm_set1_ps(d_[p]);
+            dist = _mm_add_ps(dist, _mm_mul_ps(_mm_set1_ps(nx_[p]), cx));
+            dist = _mm_add_ps(dist, _mm_mul_ps(_mm_set1_ps(ny_[p]), cy));
+            dist = _mm_add_ps(dist, _mm_mul_ps(_mm_set1_ps(nz_[p]), cz));
+            __m128 radius = _mm_mul_ps(_mm_set1_ps(abs_nx_[p]), ex);
+            radius = _mm_add_ps(radius, _mm_mul_ps(_mm_set1_ps(abs_ny_[p]), ey));
+            radius = _mm_add_ps(radius, _mm_mul_ps(_mm_set1_ps(abs_nz_[p]), ez));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(dist, radius), _mm_setzero_ps()));
+        }
+        const int mask = _mm_movemask_ps(outside);
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            const uint8_t v = (mask >> lane) & 1 ? 0 : 1;
+            visible[i + lane] = v;
+            visible_count += v;
+        }
+    }
+    for (; i < count; ++i)
+    {
+        Aabb box;
+        box.min = glm::vec3(boxes.cx[i] - boxes.ex[i], boxes.cy[i] - boxes.ey[i], boxes.cz[i] - boxes.ez[i]);
+        box.max = glm::vec3(boxes.cx[i] + boxes.ex[i], boxes.cy[i] + boxes.ey[i], boxes.cz[i] + boxes.ez[i]);
+        visible[i] = Intersects(box) ? 1 : 0;
+        visible_count += visible[i];
+    }
+    return visible_count;
+}
+
+#else
+
+Frustum::Result Frustum::Classify(const Aabb &box) const
+{
+    if (box.IsEmpty())
+        return Result::Outside;
+    const glm::vec3 c = box.Center();
+    const glm::vec3 e = box.Extents();
+    bool inside = true;
+    for (int p = 0; p < kPlaneCount; ++p)
+    {
+        const float dist = nx_[p] * c.x + ny_[p] * c.y + nz_[p] * c.z + d_[p];
+        const float radius = abs_nx_[p] * e.x + abs_ny_[p] * e.y + abs_nz_[p] * e.z;
+        if (dist < -radius)
+            return Result::Outside;
+        inside = inside && dist >= radius;
+    }
+    return inside ? Result::Inside : Result::Intersecting;
+}
+
+size_t Frustum::CullBoxes(const AabbSoA &boxes, size_t count, uint8_t *visible) const
+{
+    size_t visible_count = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        uint8_t v = 1;
+        for (int p = 0; p < kPlaneCount && v; ++p)
+        {
+            const float dist = nx_[p] * boxes.cx[i] + ny_[p] * boxes.cy[i] + nz_[p] * boxes.cz[i] + d_[p];
+            const float radius = abs_nx_[p] * boxes.ex[i] + abs_ny_[p] * boxes.ey[i] + abs_nz_[p] * boxes.ez[i];
+            v = dist + radius < 0.0f ? 0 : 1;
+        }
+        visible[i] = v;
+        visible_count += v;
+    }
+    return visible_count;
+}
+
+#endif
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "bounds.h"
+
+// Structure-of-arrays view of a batch of boxes in center/half-extent form
+struct AabbSoA
+{
+    const float *cx = nullptr;
+    const float *cy = nullptr;
+    const float *cz = nullptr;
+    const float *ex = nullptr;
+    const float *ey = nullptr;
+    const float *ez = nullptr;
+};
+
+// The six clip planes of a view-projection matrix, stored plane-major so one box
+// is tested against all planes with two SSE registers (x86; scalar elsewhere).
+class Frustum
+{
+public:
+    enum class Result
+    {
+        Outside,
+        Intersecting,
+        Inside
+    };
+
+    // Planes of projection * view (OpenGL clip space, z in [-w, w]). Normals point inward.
+    static Frustum FromMatrix(const glm::mat4 &view_projection);
+
+    // Plane i as (normal, distance): left, right, bottom, top, near, far
+    glm::vec4 Plane(int i) const { return glm::vec4(nx_[i], ny_[i], nz_[i], d_[i]); }
+
+    // Conservative: a box just outside a corner of the frustum may still report
+    // Intersecting, never the reverse
+    Result Classify(const Aabb &box) const;
+    bool Intersects(const Aabb &box) const { return Classify(box) != Result::Outside; }
+
+    // Tests boxes[0, count) four at a time and writes 1 (visible) or 0 to `visible`.
+    // Returns the number of visible boxes.
+    size_t CullBoxes(const AabbSoA &boxes, size_t count, uint8_t *visible) const;
+
+private:
+    // Lanes 6 and 7 are padding planes that every box is inside
+    static constexpr int kLanes = 8;
+
+    alignas(16) float nx_[kLanes];
+    alignas(16) float ny_[kLanes];
+    alignas(16) float nz_[kLanes];
+    alignas(16) float d_[kLanes];
+    alignas(16) float abs_nx_[kLanes];
+    alignas(16) float abs_ny_[kLanes];
+    alignas(16) float abs_nz_[kLanes];
+};
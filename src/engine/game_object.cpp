@@ -1,18 +1,31 @@
 #include "game_object.h"
 #include "component.h"
+#include "scene.h"
+
+GameObject::GameObject(Scene *scene)
+    : scene_(scene)
+{
+}
 
 GameObject::~GameObject()
 {
-    for (auto& c : components_)
+    // Component memory is released by the owning Scene's registry
+    for (size_t i = 0; i < component_count_; ++i)
     {
-        c->OnDetach();
+        components_[i]->OnDetach();
     }
 }
 
+ComponentRegistry& GameObject::Registry()
+{
+    return scene_->GetComponentRegistry();
+}
+
 void GameObject::Update(float time_seconds)
 {
-    for (auto& c : components_)
+    for (size_t i = 0; i < component_count_; ++i)
     {
+        Component* c = components_[i];
         if (!c->IsStarted())
         {
             c->OnStart();
@@ -24,37 +37,8 @@ void GameObject::Update(float time_seconds)
 
 void GameObject::Render(Renderer& renderer, const glm::mat4& projection, const glm::mat4& view)
 {
-    for (auto& c : components_)
-    {
-        c->OnRender(renderer, projection, view);
-    }
-}
-
-void GameObject::AddExistingComponent(std::unique_ptr<Component> comp)
-{
-    if (!comp) return;
-    comp->SetOwner(this);
-    Component* raw = comp.get();
-    components_.push_back(std::move(comp));
-    const std::type_index typeId = std::type_index(typeid(*raw));
-    if (component_cache_.find(typeId) == component_cache_.end())
-    {
-        component_cache_[typeId] = raw;
-    }
-    raw->OnAttach();
-}
-
-void GameObject::CloneComponentsTo(GameObject& target) const
-{
-    for (const auto& c : components_)
+    for (size_t i = 0; i < component_count_; ++i)
     {
-        if (!c) continue;
-        std::unique_ptr<Component> cloned = c->Clone();
-        if (cloned)
-        {
-            target.AddExistingComponent(std::move(cloned));
-        }
+        components_[i]->OnRender(renderer, projection, view);
     }
 }
-
-
@@ -1,20 +1,29 @@
 #pragma once
 
-#include <vector>
-#include <memory>
+#include <array>
+#include <cstdint>
 #include <type_traits>
-#include <typeindex>
-#include <unordered_map>
 #include <glm/glm.hpp>
 #include "component.h"
+#include "component_type_id.h"
+#include "component_registry.h"
+#include "handle.h"
 
 class Renderer;
 class Scene;
+class Archetype;
 
+// Thin handle over components owned by the Scene's ComponentRegistry.
+// Components are stored per type in chunked storage; the GameObject only keeps
+// non-owning pointers in attach order, a per-type slot table for GetComponent
+// and its archetype location for queries.
 class GameObject
 {
 public:
-    GameObject() = default;
+    // Components one object can hold (kept inline, so objects never allocate)
+    static constexpr size_t kMaxComponentsPerObject = 16;
+
+    explicit GameObject(Scene *scene);
     ~GameObject();
 
     GameObject(const GameObject &) = delete;
@@ -24,16 +33,9 @@ public:
     T *AddComponent(Args &&...args)
     {
         static_assert(std::is_base_of<Component, T>::value, "T must inherit from Component");
-        auto comp = std::make_unique<T>(std::forward<Args>(args)...);
-        comp->SetOwner(this);
-        T *raw = comp.get();
-        components_.push_back(std::move(comp));
-        // Cache first component of a given type for fast lookup
-        const std::type_index typeId = std::type_index(typeid(T));
-        if (component_cache_.find(typeId) == component_cache_.end())
-        {
-            component_cache_[typeId] = raw;
-        }
+        T *raw = Registry().Emplace<T>(*this, std::forward<Args>(args)...);
+        raw->SetOwner(this);
+        components_[component_count_++] = raw;
         raw->OnAttach();
         return raw;
     }
@@ -41,31 +43,34 @@ public:
     template <typename T>
     T *GetComponent()
     {
-        const std::type_index typeId = std::type_index(typeid(T));
-        auto it = component_cache_.find(typeId);
-        if (it != component_cache_.end())
-        {
-            return static_cast<T *>(it->second);
-        }
-        // Fallback: scan and populate cache for next time
-        for (auto &c : components_)
+        return const_cast<T *>(static_cast<const GameObject *>(this)->GetComponent<T>());
+    }
+
+    // Exact-type lookup: one bit test, then the slot at the type's rank in the mask
+    template <typename T>
+    const T *GetComponent() const
+    {
+        const ComponentMask bit = ComponentBit(ComponentTypeIds::Of<T>());
+        if ((component_mask_ & bit) == 0)
         {
-            if (auto casted = dynamic_cast<T *>(c.get()))
-            {
-                component_cache_[typeId] = casted;
-                return casted;
-            }
+            return nullptr;
         }
-        return nullptr;
+        return static_cast<const T *>(component_slots_[PopCount(component_mask_ & (bit - 1))]);
     }
 
     template <typename T>
-    const T *GetComponent() const
+    T *GetComponentDerivedFrom()
     {
-        // Note: const overload does not populate the cache to preserve constness
-        for (const auto &c : components_)
+        return const_cast<T *>(static_cast<const GameObject *>(this)->GetComponentDerivedFrom<T>());
+    }
+
+    // First component that is a T or derives from it (RTTI scan; prefer GetComponent)
+    template <typename T>
+    const T *GetComponentDerivedFrom() const
+    {
+        for (size_t i = 0; i < component_count_; ++i)
         {
-            if (auto casted = dynamic_cast<const T *>(c.get()))
+            if (auto casted = dynamic_cast<const T *>(components_[i]))
             {
                 return casted;
             }
@@ -76,16 +81,33 @@ public:
     void Update(float time_seconds);
     void Render(Renderer &renderer, const glm::mat4 &projection, const glm::mat4 &view);
 
-    // Scene access
-    void SetScene(Scene *scene) { scene_ = scene; }
     Scene *GetScene() const { return scene_; }
 
-    // Internal helpers used by cloning logic
-    void AddExistingComponent(std::unique_ptr<Component> comp);
-    void CloneComponentsTo(GameObject &target) const;
+    // Weak reference that resolves through Scene::Resolve and goes stale on destroy
+    ObjectHandle GetHandle() const { return ObjectHandle{pool_index_, generation_}; }
+    // True once Scene::Destroy has queued this object for the end of the frame
+    bool IsPendingDestroy() const { return pending_destroy_; }
 
 private:
-    std::vector<std::unique_ptr<Component>> components_;
-    std::unordered_map<std::type_index, Component *> component_cache_;
+    friend class ComponentRegistry;
+    friend class Scene;
+
+    ComponentRegistry &Registry();
+
+    // Every component in attach order (including repeated types)
+    std::array<Component *, kMaxComponentsPerObject> components_{};
+    size_t component_count_ = 0;
+    // First component of each type, sorted by type id; component_mask_ has one
+    // bit per type present
+    ComponentMask component_mask_ = 0;
+    std::array<Component *, kMaxComponentsPerObject> component_slots_{};
     Scene *scene_ = nullptr;
+    Archetype *archetype_ = nullptr;
+    size_t archetype_row_ = 0;
+
+    // Location in the Scene's object pool and object list
+    uint32_t pool_index_ = ObjectHandle::kInvalidIndex;
+    uint32_t generation_ = 0;
+    size_t list_index_ = 0;
+    bool pending_destroy_ = false;
 };
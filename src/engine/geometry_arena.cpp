@@ -0,0 +1,196 @@
+#include "geometry_arena.h"
+
+#include "gl_state_cache.h"
+#include "mesh.h"
+
+#include <algorithm>
+#include <iterator>
+
+// Initial capacities, in elements (2 MB of vertices; 384 KB of 16-bit indices, 768 KB of 32-bit)
+static constexpr size_t kMinVertices = size_t(1) << 16;
+static constexpr size_t kMinIndices = size_t(3) << 16;
+
+GeometryArena &GeometryArena::GetInstance()
+{
+    // Never destroyed: meshes held by other statics release into it during exit
+    static GeometryArena *instance = new GeometryArena();
+    return *instance;
+}
+
+bool GeometryArena::FreeList::Allocate(size_t count, size_t &offset)
+{
+    if (count == 0)
+    {
+        offset = 0;
+        return true;
+    }
+    for (auto it = spans_.begin(); it != spans_.end(); ++it)
+    {
+        if (it->second < count)
+            continue;
+        offset = it->first;
+        const size_t remaining = it->second - count;
+        spans_.erase(it);
+        if (remaining > 0)
+            spans_.emplace(offset + count, remaining);
+        return true;
+    }
+    return false;
+}
+
+void GeometryArena::FreeList::Free(size_t offset, size_t count)
+{
+    if (count == 0)
+        return;
+    auto next = spans_.lower_bound(offset);
+    if (next != spans_.end() && offset + count == next->first)
+    {
+        count += next->second;
+        next = spans_.erase(next);
+    }
+    if (next != spans_.begin())
+    {
+        auto previous = std::prev(next);
+        if (previous->first + previous->second == offset)
+        {
+            previous->second += count;
+            return;
+        }
+    }
+    spans_.emplace(offset, count);
+}
+
+GeometryArena::Range GeometryArena::Place(const Mesh &mesh)
+{
+    const auto found = placed_.find(mesh.GeometryId());
+    if (found != placed_.end())
+        return found->second.range;
+
+    const GLenum index_type = mesh.IndexType();
+    const size_t vertex_count = mesh.vertices.size();
+    const size_t index_count = mesh.indices.size();
+    const size_t first_vertex = AllocateVertices(vertex_count);
+    const size_t first_index = AllocateIndices(index_type, index_count);
+
+    // Through the copy target, so no VAO's element binding is touched
+    if (vertex_count > 0)
+    {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, vbo_);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, first_vertex * sizeof(MeshVertex), vertex_count * sizeof(MeshVertex),
+                        mesh.vertices.data());
+    }
+    if (index_count > 0)
+    {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, Pool(index_type).ebo);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, first_index * mesh.indices.IndexSize(), mesh.indices.ByteSize(),
+                        mesh.indices.data());
+    }
+
+    Placement placement;
+    placement.range.first_index = static_cast<GLuint>(first_index);
+    placement.range.index_count = static_cast<GLuint>(index_count);
+    placement.range.base_vertex = static_cast<GLint>(first_vertex);
+    placement.range.index_type = index_type;
+    placement.vertex_count = vertex_count;
+    placed_.emplace(mesh.GeometryId(), placement);
+    ++stats_.meshes;
+    stats_.vertices += vertex_count;
+    stats_.indices += index_count;
+    stats_.index_bytes += mesh.indices.ByteSize();
+    return placement.range;
+}
+
+void GeometryArena::Release(uint64_t geometry_id)
+{
+    const auto found = placed_.find(geometry_id);
+    if (found == placed_.end())
+        return;
+    const Placement &placement = found->second;
+    free_vertices_.Free(static_cast<size_t>(placement.range.base_vertex), placement.vertex_count);
+    Pool(placement.range.index_type).free.Free(placement.range.first_index, placement.range.index_count);
+    --stats_.meshes;
+    stats_.vertices -= placement.vertex_count;
+    stats_.indices -= placement.range.index_count;
+    stats_.index_bytes -= placement.range.index_count * MeshIndices::TypeSize(placement.range.index_type);
+    placed_.erase(found);
+}
+
+void GeometryArena::Bind(GLenum index_type) const
+{
+    GLStateCache::GetInstance().BindVertexArray(Pool(index_type).vao);
+}
+
+void GeometryArena::BindInstances(GLenum index_type, GLuint buffer, size_t byte_offset) const
+{
+    Bind(index_type);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    Mesh::SetInstanceAttributes(byte_offset);
+}
+
+void GeometryArena::SetupPool(IndexPool &pool) const
+{
+    if (!pool.vao)
+        glGenVertexArrays(1, &pool.vao);
+    GLStateCache::GetInstance().BindVertexArray(pool.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+    Mesh::SetVertexAttributes();
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, pool.ebo);
+}
+
+size_t GeometryArena::AllocateVertices(size_t count)
+{
+    size_t offset = 0;
+    if (free_vertices_.Allocate(count, offset))
+        return offset;
+
+    const size_t old_capacity = stats_.vertex_capacity;
+    const size_t capacity = std::max({old_capacity * 2, old_capacity + count, kMinVertices});
+    vbo_ = Reallocate(vbo_, old_capacity * sizeof(MeshVertex), capacity * sizeof(MeshVertex));
+    // Both VAOs read the vertex buffer; a pool without one yet is set up on its first indices
+    for (IndexPool *pool : {&short_pool_, &int_pool_})
+    {
+        if (pool->vao)
+            SetupPool(*pool);
+    }
+    free_vertices_.Free(old_capacity, capacity - old_capacity);
+    stats_.vertex_capacity = capacity;
+    ++stats_.grows;
+    free_vertices_.Allocate(count, offset);
+    return offset;
+}
+
+size_t GeometryArena::AllocateIndices(GLenum index_type, size_t count)
+{
+    IndexPool &pool = Pool(index_type);
+    size_t offset = 0;
+    if (pool.free.Allocate(count, offset))
+        return offset;
+
+    const size_t index_size = MeshIndices::TypeSize(index_type);
+    const size_t old_capacity = pool.capacity;
+    const size_t capacity = std::max({old_capacity * 2, old_capacity + count, kMinIndices});
+    pool.ebo = Reallocate(pool.ebo, old_capacity * index_size, capacity * index_size);
+    SetupPool(pool);
+    pool.free.Free(old_capacity, capacity - old_capacity);
+    pool.capacity = capacity;
+    stats_.index_capacity_bytes += (capacity - old_capacity) * index_size;
+    ++stats_.grows;
+    pool.free.Allocate(count, offset);
+    return offset;
+}
+
+GLuint GeometryArena::Reallocate(GLuint buffer, size_t old_bytes, size_t new_bytes)
+{
+    GLuint replacement = 0;
+    glGenBuffers(1, &replacement);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, replacement);
+    glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(new_bytes), nullptr, GL_STATIC_DRAW);
+    if (buffer)
+    {
+        glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, static_cast<GLsizeiptr>(old_bytes));
+        // Draws already issued from it keep it alive until they complete
+        glDeleteBuffers(1, &buffer);
+    }
+    return replacement;
+}
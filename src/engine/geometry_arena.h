@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <glad/glad.h>
+
+class Mesh;
+
+// Layout of one command in a GL_DRAW_INDIRECT_BUFFER for glMultiDrawElementsIndirect
+struct DrawElementsIndirectCommand
+{
+    GLuint count;
+    GLuint instance_count;
+    GLuint first_index;
+    GLint base_vertex;
+    GLuint base_instance;
+};
+
+static_assert(sizeof(DrawElementsIndirectCommand) == 20, "indirect commands are five tightly packed 32-bit values");
+
+// One vertex buffer shared by every placed mesh, plus one index buffer per
+// index width, each with a VAO over the vertex buffer and itself (the
+// MeshVertex layout on attributes 0..2, so only VertexFormat::Float meshes
+// belong here). A mesh is copied in the first time Place sees it, its indices
+// into the pool of its own width, and is then drawn with its base vertex and
+// first index, so draws of meshes with the same index type need no VAO switch
+// and can go out together as one multi-draw.
+//
+// Space is handed out first-fit from a free list per buffer; when neither
+// fits, the buffer is replaced by one twice the size and its contents copied
+// over on the GPU. Meshes give their space back from their destructor.
+//
+// One per GL context; the engine has one, reached through GetInstance().
+class GeometryArena
+{
+public:
+    // Where a placed mesh lives, in elements. Indices are stored as the mesh
+    // has them, relative to its first vertex, hence the base vertex;
+    // first_index counts in `index_type` units within that type's pool.
+    struct Range
+    {
+        GLuint first_index = 0;
+        GLuint index_count = 0;
+        GLint base_vertex = 0;
+        GLenum index_type = GL_UNSIGNED_INT;
+    };
+
+    struct Stats
+    {
+        size_t meshes = 0;
+        size_t vertices = 0;   // in use
+        size_t indices = 0;            // both widths
+        size_t index_bytes = 0;
+        size_t vertex_capacity = 0;
+        size_t index_capacity_bytes = 0;
+        size_t grows = 0;      // buffer reallocations since start-up
+    };
+
+    static GeometryArena &GetInstance();
+
+    GeometryArena(const GeometryArena &) = delete;
+    GeometryArena &operator=(const GeometryArena &) = delete;
+
+    // Range of `mesh`, copying its vertices and indices in on first use
+    Range Place(const Mesh &mesh);
+    // Frees the space of a mesh's geometry. Makes no GL calls.
+    void Release(uint64_t geometry_id);
+
+    // Binds the VAO drawing `index_type` indices (through GLStateCache)
+    void Bind(GLenum index_type) const;
+    // Points that VAO's instance-matrix attributes at mat4s the caller streamed
+    // into `buffer` from `byte_offset` on. Leaves the VAO bound.
+    void BindInstances(GLenum index_type, GLuint buffer, size_t byte_offset) const;
+
+    const Stats &GetStats() const { return stats_; }
+
+private:
+    // Free spans of [0, capacity) elements, keyed by offset, adjacent spans merged
+    class FreeList
+    {
+    public:
+        bool Allocate(size_t count, size_t &offset);
+        void Free(size_t offset, size_t count);
+
+    private:
+        std::map<size_t, size_t> spans_;   // offset -> count
+    };
+
+    struct Placement
+    {
+        Range range;
+        size_t vertex_count;
+    };
+
+    // The index buffer of one width and the VAO drawing from it
+    struct IndexPool
+    {
+        GLuint vao = 0;
+        GLuint ebo = 0;
+        size_t capacity = 0;   // indices
+        FreeList free;
+    };
+
+    GeometryArena() = default;
+
+    IndexPool &Pool(GLenum index_type) { return index_type == GL_UNSIGNED_SHORT ? short_pool_ : int_pool_; }
+    const IndexPool &Pool(GLenum index_type) const
+    {
+        return index_type == GL_UNSIGNED_SHORT ? short_pool_ : int_pool_;
+    }
+    size_t AllocateVertices(size_t count);
+    size_t AllocateIndices(GLenum index_type, size_t count);
+    // Points a pool's VAO at the current vertex buffer and its index buffer
+    void SetupPool(IndexPool &pool) const;
+    // A new buffer of `new_bytes` holding the first `old_bytes` of `buffer`, which is deleted
+    static GLuint Reallocate(GLuint buffer, size_t old_bytes, size_t new_bytes);
+
+    GLuint vbo_ = 0;
+    FreeList free_vertices_;
+    IndexPool short_pool_;
+    IndexPool int_pool_;
+    std::unordered_map<uint64_t, Placement> placed_;
+    Stats stats_;
+};
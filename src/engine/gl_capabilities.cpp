@@ -0,0 +1,21 @@
+#include "gl_capabilities.h"
+
+#include <cstring>
+
+bool GLCapabilities::VersionAtLeast(int major, int minor)
+{
+    return GLVersion.major > major || (GLVersion.major == major && GLVersion.minor >= minor);
+}
+
+bool GLCapabilities::HasExtension(const char *name)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; ++i)
+    {
+        const GLubyte *extension = glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i));
+        if (extension && std::strcmp(reinterpret_cast<const char *>(extension), name) == 0)
+            return true;
+    }
+    return false;
+}
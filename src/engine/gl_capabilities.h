@@ -0,0 +1,15 @@
+#pragma once
+
+#include <glad/glad.h>
+
+// What the current context offers beyond the GL 4.1 core the loader targets.
+// Call with the context current; newer entry points are then loaded through
+// glfwGetProcAddress by the code that uses them.
+class GLCapabilities
+{
+public:
+    // Context version reported by glad at load time
+    static bool VersionAtLeast(int major, int minor);
+    // Whether `name` (e.g. "GL_ARB_buffer_storage") is in the extension list
+    static bool HasExtension(const char *name);
+};
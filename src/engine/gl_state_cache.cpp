@@ -0,0 +1,173 @@
+#include "gl_state_cache.h"
+
+#include <algorithm>
+#include <iterator>
+
+GLStateCache &GLStateCache::GetInstance()
+{
+    // Never destroyed: GL objects held by other statics (g_unitCube, ...) call Forget* during exit
+    static GLStateCache *instance = new GLStateCache();
+    return *instance;
+}
+
+void GLStateCache::Invalidate()
+{
+    program_ = kUnknown;
+    vao_ = kUnknown;
+    active_unit_ = kUnknown;
+    std::fill(std::begin(textures_), std::end(textures_), kUnknown);
+    depth_test_ = -1;
+    depth_write_ = -1;
+    cull_face_ = -1;
+    blend_ = -1;
+    color_write_ = -1;
+    depth_func_ = kUnknown;
+    cull_mode_ = kUnknown;
+    front_face_ = kUnknown;
+    blend_source_ = kUnknown;
+    blend_destination_ = kUnknown;
+    std::fill(std::begin(viewport_), std::end(viewport_), 0);
+    viewport_known_ = false;
+}
+
+void GLStateCache::UseProgram(GLuint program)
+{
+    if (Update(program_, program))
+        glUseProgram(program);
+}
+
+void GLStateCache::BindVertexArray(GLuint vao)
+{
+    if (Update(vao_, vao))
+        glBindVertexArray(vao);
+}
+
+void GLStateCache::ActiveTexture(GLuint unit)
+{
+    if (Update(active_unit_, unit))
+        glActiveTexture(GL_TEXTURE0 + unit);
+}
+
+void GLStateCache::BindTexture(GLuint unit, GLenum target, GLuint texture)
+{
+    if (target == GL_TEXTURE_2D && unit < kTextureUnits)
+    {
+        if (textures_[unit] == texture)
+        {
+            ++stats_.filtered;
+            return;
+        }
+        textures_[unit] = texture;
+    }
+    ActiveTexture(unit);
+    glBindTexture(target, texture);
+    ++stats_.issued;
+}
+
+void GLStateCache::SetCapability(int &cached, GLenum capability, bool enabled)
+{
+    if (!Update(cached, enabled ? 1 : 0))
+        return;
+    if (enabled)
+        glEnable(capability);
+    else
+        glDisable(capability);
+}
+
+void GLStateCache::SetDepthTest(bool enabled)
+{
+    SetCapability(depth_test_, GL_DEPTH_TEST, enabled);
+}
+
+void GLStateCache::SetCullFace(bool enabled)
+{
+    SetCapability(cull_face_, GL_CULL_FACE, enabled);
+}
+
+void GLStateCache::SetBlend(bool enabled)
+{
+    SetCapability(blend_, GL_BLEND, enabled);
+}
+
+void GLStateCache::SetDepthWrite(bool enabled)
+{
+    if (Update(depth_write_, enabled ? 1 : 0))
+        glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+}
+
+void GLStateCache::SetColorWrite(bool enabled)
+{
+    if (Update(color_write_, enabled ? 1 : 0))
+    {
+        const GLboolean mask = enabled ? GL_TRUE : GL_FALSE;
+        glColorMask(mask, mask, mask, mask);
+    }
+}
+
+void GLStateCache::SetDepthFunc(GLenum func)
+{
+    if (Update(depth_func_, func))
+        glDepthFunc(func);
+}
+
+void GLStateCache::SetCullMode(GLenum mode)
+{
+    if (Update(cull_mode_, mode))
+        glCullFace(mode);
+}
+
+void GLStateCache::SetFrontFace(GLenum mode)
+{
+    if (Update(front_face_, mode))
+        glFrontFace(mode);
+}
+
+void GLStateCache::SetBlendFunc(GLenum source, GLenum destination)
+{
+    if (blend_source_ == source && blend_destination_ == destination)
+    {
+        ++stats_.filtered;
+        return;
+    }
+    blend_source_ = source;
+    blend_destination_ = destination;
+    glBlendFunc(source, destination);
+    ++stats_.issued;
+}
+
+void GLStateCache::SetViewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    if (viewport_known_ && viewport_[0] == x && viewport_[1] == y && viewport_[2] == width && viewport_[3] == height)
+    {
+        ++stats_.filtered;
+        return;
+    }
+    viewport_[0] = x;
+    viewport_[1] = y;
+    viewport_[2] = width;
+    viewport_[3] = height;
+    viewport_known_ = true;
+    glViewport(x, y, width, height);
+    ++stats_.issued;
+}
+
+void GLStateCache::ForgetProgram(GLuint program)
+{
+    if (program_ == program)
+        program_ = kUnknown;
+}
+
+void GLStateCache::ForgetVertexArray(GLuint vao)
+{
+    if (vao_ == vao)
+        vao_ = kUnknown;
+}
+
+void GLStateCache::ForgetTexture(GLuint texture)
+{
+    for (GLuint &bound : textures_)
+    {
+        if (bound == texture)
+            bound = kUnknown;
+    }
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstddef>
+#include <glad/glad.h>
+
+// Shadow copy of the GL state the engine changes: bound program, VAO and 2D
+// texture per unit, depth/cull/blend state, color writes and the viewport.
+// Setting a value that is already current costs a compare instead of a
+// driver call, and code that needs to know the current state reads it here
+// instead of querying the driver. Everything starts out unknown, so the first
+// call of each kind always reaches GL; Invalidate() goes back to that after GL
+// calls made behind the cache's back.
+//
+// One per GL context; the engine has one, reached through GetInstance().
+class GLStateCache
+{
+public:
+    static constexpr GLuint kTextureUnits = 16;
+
+    // Calls since the last ResetStats (Renderer::BeginFrame resets them)
+    struct Stats
+    {
+        size_t issued = 0;     // passed on to GL
+        size_t filtered = 0;   // dropped because the state was already current
+    };
+
+    static GLStateCache &GetInstance();
+
+    void UseProgram(GLuint program);
+    void BindVertexArray(GLuint vao);
+    // Switches the active unit only when the binding actually changes. Targets
+    // other than GL_TEXTURE_2D are not tracked and always bind.
+    void BindTexture(GLuint unit, GLenum target, GLuint texture);
+    void ActiveTexture(GLuint unit);
+
+    void SetDepthTest(bool enabled);
+    void SetDepthWrite(bool enabled);
+    void SetDepthFunc(GLenum func);
+    void SetCullFace(bool enabled);
+    void SetCullMode(GLenum mode);
+    void SetFrontFace(GLenum mode);
+    void SetBlend(bool enabled);
+    void SetBlendFunc(GLenum source, GLenum destination);
+    void SetColorWrite(bool enabled);
+    void SetViewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+    // Last values set through the cache; GL's defaults while unknown
+    bool DepthTest() const { return depth_test_ == 1; }
+    bool DepthWrite() const { return depth_write_ != 0; }
+    GLenum DepthFunc() const { return depth_func_ == kUnknown ? GL_LESS : depth_func_; }
+    bool CullFace() const { return cull_face_ == 1; }
+    GLenum CullMode() const { return cull_mode_ == kUnknown ? GL_BACK : cull_mode_; }
+    bool Blend() const { return blend_ == 1; }
+    // x, y, width, height; all zero until SetViewport
+    const GLint *Viewport() const { return viewport_; }
+
+    // Call before deleting a GL object, so a recycled name is bound for real
+    void ForgetProgram(GLuint program);
+    void ForgetVertexArray(GLuint vao);
+    void ForgetTexture(GLuint texture);
+
+    void Invalidate();
+    const Stats &GetStats() const { return stats_; }
+    void ResetStats() { stats_ = Stats{}; }
+
+private:
+    static constexpr GLuint kUnknown = ~GLuint(0);
+
+    GLStateCache() { Invalidate(); }
+
+    // Stores `value` and returns true if it differs from `cached` (or that was
+    // unknown); counts the call either way
+    template <typename T>
+    bool Update(T &cached, T value)
+    {
+        if (cached == value)
+        {
+            ++stats_.filtered;
+            return false;
+        }
+        cached = value;
+        ++stats_.issued;
+        return true;
+    }
+    void SetCapability(int &cached, GLenum capability, bool enabled);
+
+    GLuint program_;
+    GLuint vao_;
+    GLuint active_unit_;
+    GLuint textures_[kTextureUnits];
+    // -1 unknown, 0 off, 1 on
+    int depth_test_;
+    int depth_write_;
+    int cull_face_;
+    int blend_;
+    int color_write_;
+    GLenum depth_func_;
+    GLenum cull_mode_;
+    GLenum front_face_;
+    GLenum blend_source_;
+    GLenum blend_destination_;
+    GLint viewport_[4];
+    bool viewport_known_;
+    Stats stats_;
+};
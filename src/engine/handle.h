@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+
+// Weak references into the Scene's pools. A handle stores a slot index plus the
+// slot's generation; the generation changes whenever the slot is freed, so a
+// handle to a destroyed object resolves to nullptr instead of dangling (even
+// after the slot has been reused).
+struct ObjectHandle
+{
+    static constexpr uint32_t kInvalidIndex = ~uint32_t(0);
+
+    uint32_t index = kInvalidIndex;
+    uint32_t generation = 0;
+
+    bool IsNull() const { return index == kInvalidIndex; }
+    bool operator==(const ObjectHandle &other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const ObjectHandle &other) const { return !(*this == other); }
+};
+
+template <typename T>
+struct ComponentHandle
+{
+    uint32_t index = ObjectHandle::kInvalidIndex;
+    uint32_t generation = 0;
+
+    bool IsNull() const { return index == ObjectHandle::kInvalidIndex; }
+    bool operator==(const ComponentHandle &other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const ComponentHandle &other) const { return !(*this == other); }
+};
@@ -0,0 +1,269 @@
+#include "job_system.h"
+
+#include <limits>
+
+namespace
+{
+    // Identifies the pool (and queue) the current thread works for
+    struct WorkerContext
+    {
+        const JobSystem *system = nullptr;
+        size_t index = std::numeric_limits<size_t>::max();
+    };
+    thread_local WorkerContext t_worker;
+}
+
+void JobSystem::WorkQueue::PushBack(QueuedJob &&job)
+{
+    if (size == ring.size())
+    {
+        std::vector<QueuedJob> grown(std::max<size_t>(16, ring.size() * 2));
+        for (size_t i = 0; i < size; ++i)
+        {
+            grown[i] = std::move(ring[(head + i) % ring.size()]);
+        }
+        ring.swap(grown);
+        head = 0;
+    }
+    ring[(head + size) % ring.size()] = std::move(job);
+    ++size;
+}
+
+JobSystem::QueuedJob JobSystem::WorkQueue::PopBack()
+{
+    --size;
+    return std::move(ring[(head + size) % ring.size()]);
+}
+
+JobSystem::QueuedJob JobSystem::WorkQueue::PopFront()
+{
+    QueuedJob job = std::move(ring[head]);
+    head = (head + 1) % ring.size();
+    --size;
+    return job;
+}
+
+JobSystem &JobSystem::GetInstance()
+{
+    static JobSystem instance(std::max(1u, std::thread::hardware_concurrency()) - 1u);
+    return instance;
+}
+
+JobSystem::JobSystem(unsigned worker_count)
+{
+    for (unsigned i = 0; i < worker_count + 1; ++i)
+    {
+        queues_.push_back(std::make_unique<WorkQueue>());
+    }
+    workers_.reserve(worker_count);
+    for (unsigned i = 0; i < worker_count; ++i)
+    {
+        workers_.emplace_back(&JobSystem::WorkerLoop, this, static_cast<size_t>(i));
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        running_ = false;
+    }
+    wake_.notify_all();
+    for (std::thread &worker : workers_)
+    {
+        worker.join();
+    }
+}
+
+void JobSystem::Run(Job job, JobCounter *counter)
+{
+    if (counter)
+    {
+        counter->pending_.fetch_add(1, std::memory_order_relaxed);
+    }
+    QueuedJob queued;
+    queued.job = std::move(job);
+    queued.counter = counter;
+    Enqueue(std::move(queued));
+}
+
+void JobSystem::RunAfter(JobCounter &dependency, Job job, JobCounter *counter)
+{
+    if (counter)
+    {
+        counter->pending_.fetch_add(1, std::memory_order_relaxed);
+    }
+    {
+        std::lock_guard<std::mutex> lock(dependency.mutex_);
+        if (!dependency.IsDone())
+        {
+            dependency.continuations_.push_back(JobCounter::Continuation{std::move(job), counter});
+            return;
+        }
+    }
+    QueuedJob queued;
+    queued.job = std::move(job);
+    queued.counter = counter;
+    Enqueue(std::move(queued));
+}
+
+void JobSystem::Wait(JobCounter &counter)
+{
+    while (!counter.IsDone())
+    {
+        if (!TryRunOne())
+        {
+            std::this_thread::yield();
+        }
+    }
+    // The last Execute may still hold the counter's lock; let it finish before
+    // the caller is free to destroy the counter
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> lock(counter.mutex_);
+        error.swap(counter.error_);
+    }
+    if (error)
+        std::rethrow_exception(error);
+}
+
+void JobSystem::Enqueue(QueuedJob job)
+{
+    // Workers push onto their own deque; everyone else goes through the injection queue
+    const size_t queue = t_worker.system == this ? t_worker.index : queues_.size() - 1;
+    {
+        std::lock_guard<std::mutex> lock(queues_[queue]->mutex);
+        queues_[queue]->PushBack(std::move(job));
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        queued_.fetch_add(1, std::memory_order_relaxed);
+    }
+    wake_.notify_one();
+}
+
+void JobSystem::EnqueueRanges(RangeBatch &batch, size_t grain, size_t count, JobCounter &counter)
+{
+    const size_t queue = t_worker.system == this ? t_worker.index : queues_.size() - 1;
+    // Every range after the first, which the caller runs itself
+    const int ranges = static_cast<int>((count - 1) / grain);
+    counter.pending_.fetch_add(ranges, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(queues_[queue]->mutex);
+        for (size_t begin = grain; begin < count; begin += grain)
+        {
+            QueuedJob job;
+            job.batch = &batch;
+            job.begin = begin;
+            job.end = std::min(begin + grain, count);
+            job.counter = &counter;
+            queues_[queue]->PushBack(std::move(job));
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        queued_.fetch_add(ranges, std::memory_order_relaxed);
+    }
+    wake_.notify_all();
+}
+
+bool JobSystem::TryRunOne()
+{
+    const size_t own = t_worker.system == this ? t_worker.index : queues_.size() - 1;
+    QueuedJob job;
+    if (!PopOwn(own, job) && !Steal(own, job))
+    {
+        return false;
+    }
+    Execute(job);
+    return true;
+}
+
+bool JobSystem::PopOwn(size_t queue, QueuedJob &out)
+{
+    WorkQueue &q = *queues_[queue];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if (q.size == 0)
+        return false;
+    out = q.PopBack();
+    return true;
+}
+
+bool JobSystem::Steal(size_t thief, QueuedJob &out)
+{
+    // Start after the thief's own queue so victims are spread across workers
+    const size_t count = queues_.size();
+    for (size_t offset = 1; offset < count; ++offset)
+    {
+        WorkQueue &q = *queues_[(thief + offset) % count];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (q.size == 0)
+            continue;
+        out = q.PopFront();
+        return true;
+    }
+    return false;
+}
+
+void JobSystem::Execute(QueuedJob &job)
+{
+    queued_.fetch_sub(1, std::memory_order_relaxed);
+    std::exception_ptr error;
+    if (job.batch)
+    {
+        // Never throws: RunRange keeps the exception for ParallelFor to rethrow
+        job.batch->run(*job.batch, job.begin, job.end);
+    }
+    else
+    {
+        try
+        {
+            job.job();
+        }
+        catch (...)
+        {
+            // Kept for Wait to rethrow; with no counter nobody can wait for it, so it is dropped
+            error = std::current_exception();
+        }
+    }
+
+    JobCounter *counter = job.counter;
+    if (!counter)
+        return;
+
+    std::vector<JobCounter::Continuation> ready;
+    {
+        // Decrement under the lock so RunAfter never misses the transition to zero
+        std::lock_guard<std::mutex> lock(counter->mutex_);
+        if (error && !counter->error_)
+            counter->error_ = error;
+        if (counter->pending_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            ready.swap(counter->continuations_);
+        }
+    }
+    for (JobCounter::Continuation &next : ready)
+    {
+        QueuedJob queued;
+        queued.job = std::move(next.job);
+        queued.counter = next.counter;
+        Enqueue(std::move(queued));
+    }
+}
+
+void JobSystem::WorkerLoop(size_t index)
+{
+    t_worker.system = this;
+    t_worker.index = index;
+    while (true)
+    {
+        if (TryRunOne())
+            continue;
+
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        wake_.wait(lock, [this]()
+                   { return !running_ || queued_.load(std::memory_order_relaxed) > 0; });
+        if (!running_)
+            return;
+    }
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+class JobSystem;
+
+// Tracks a group of in-flight jobs. Wait on it with JobSystem::Wait, or chain
+// follow-up work with JobSystem::RunAfter. The first exception thrown by one of
+// its jobs is kept and rethrown by Wait.
+class JobCounter
+{
+public:
+    JobCounter() = default;
+    JobCounter(const JobCounter &) = delete;
+    JobCounter &operator=(const JobCounter &) = delete;
+
+    bool IsDone() const { return pending_.load(std::memory_order_acquire) == 0; }
+
+private:
+    friend class JobSystem;
+
+    struct Continuation
+    {
+        std::function<void()> job;
+        JobCounter *counter;
+    };
+
+    std::atomic<int> pending_{0};
+    std::mutex mutex_;
+    std::vector<Continuation> continuations_;
+    std::exception_ptr error_;   // guarded by mutex_
+};
+
+// Work-stealing thread pool. Each worker owns a deque: it pushes and pops at the
+// back (LIFO, cache-warm) while idle workers steal from the front of others.
+// Threads outside the pool submit into a shared injection queue and help run
+// jobs while they Wait.
+class JobSystem
+{
+public:
+    using Job = std::function<void()>;
+
+    // Process-wide pool sized to hardware_concurrency - 1 (the caller is the extra thread)
+    static JobSystem &GetInstance();
+
+    explicit JobSystem(unsigned worker_count);
+    ~JobSystem();
+
+    JobSystem(const JobSystem &) = delete;
+    JobSystem &operator=(const JobSystem &) = delete;
+
+    unsigned WorkerCount() const { return static_cast<unsigned>(workers_.size()); }
+
+    void Run(Job job, JobCounter *counter = nullptr);
+
+    // Schedules `job` once `dependency` reaches zero (immediately if it already has)
+    void RunAfter(JobCounter &dependency, Job job, JobCounter *counter = nullptr);
+
+    // Blocks until `counter` reaches zero, executing queued jobs in the meantime.
+    // Then rethrows the first exception one of its jobs threw, if any.
+    void Wait(JobCounter &counter);
+
+    // Calls fn(begin, end) over [0, count) in ranges of at least `min_grain`
+    // items, spread across the pool. The calling thread runs the first range.
+    // Ranges are queued as plain structs, so no allocation is made per range.
+    // If any range throws, every range still finishes (or is skipped, if not yet
+    // started) before the first exception is rethrown here.
+    template <typename Fn>
+    void ParallelFor(size_t count, size_t min_grain, Fn &&fn)
+    {
+        if (count == 0)
+            return;
+        // Aim for a few ranges per thread so stealing can even out imbalance
+        const size_t target_ranges = (static_cast<size_t>(WorkerCount()) + 1) * 4;
+        const size_t grain = std::max<size_t>(std::max<size_t>(min_grain, 1), (count + target_ranges - 1) / target_ranges);
+        if (workers_.empty() || count <= grain)
+        {
+            fn(size_t(0), count);
+            return;
+        }
+
+        using FnType = std::remove_reference_t<Fn>;
+        RangeBatch batch;
+        batch.fn = const_cast<void *>(static_cast<const void *>(std::addressof(fn)));
+        batch.run = &RunRange<FnType>;
+        JobCounter counter;
+        EnqueueRanges(batch, grain, count, counter);
+        RunRange<FnType>(batch, 0, grain);
+        Wait(counter);
+        if (batch.error)
+            std::rethrow_exception(batch.error);
+    }
+
+private:
+    // The ranges of one ParallelFor. It lives on the caller's stack until all
+    // of them have run.
+    struct RangeBatch
+    {
+        void *fn = nullptr;
+        void (*run)(RangeBatch &batch, size_t begin, size_t end) = nullptr;
+        std::atomic<bool> failed{false};
+        std::exception_ptr error;  // first exception thrown by a range
+    };
+
+    template <typename Fn>
+    static void RunRange(RangeBatch &batch, size_t begin, size_t end)
+    {
+        if (batch.failed.load(std::memory_order_relaxed))
+            return;
+        try
+        {
+            (*static_cast<Fn *>(batch.fn))(begin, end);
+        }
+        catch (...)
+        {
+            if (!batch.failed.exchange(true))
+                batch.error = std::current_exception();
+        }
+    }
+
+    // Either a range of a ParallelFor (`batch` set) or a free-standing `job`
+    struct QueuedJob
+    {
+        Job job;
+        RangeBatch *batch = nullptr;
+        size_t begin = 0;
+        size_t end = 0;
+        JobCounter *counter = nullptr;
+    };
+
+    // Double-ended ring of jobs that only ever grows, so a warmed-up pool
+    // queues and runs jobs without allocating
+    struct WorkQueue
+    {
+        std::mutex mutex;
+        std::vector<QueuedJob> ring;
+        size_t head = 0;
+        size_t size = 0;
+
+        void PushBack(QueuedJob &&job);
+        QueuedJob PopBack();
+        QueuedJob PopFront();
+    };
+
+    void Enqueue(QueuedJob job);
+    // Queues [grain, count) of `batch` in ranges of `grain` items, all under one lock
+    void EnqueueRanges(RangeBatch &batch, size_t grain, size_t count, JobCounter &counter);
+    bool TryRunOne();
+    bool PopOwn(size_t queue, QueuedJob &out);
+    bool Steal(size_t thief, QueuedJob &out);
+    void Execute(QueuedJob &job);
+    void WorkerLoop(size_t index);
+
+    // queues_[i] belongs to worker i; the last queue is the shared injection queue
+    std::vector<std::unique_ptr<WorkQueue>> queues_;
+    std::vector<std::thread> workers_;
+    std::atomic<bool> running_{true};
+    std::atomic<int> queued_{0};
+    std::mutex sleep_mutex_;
+    std::condition_variable wake_;
+};
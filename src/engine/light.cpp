@@ -17,7 +17,7 @@ glm::vec3 Light::WorldDirection() const
     {
         return glm::normalize(glm::vec3(0.0f, -1.0f, 0.0f));
     }
-    glm::mat4 world = cached_transform_->LocalToWorld();
+    const glm::mat4 &world = cached_transform_->LocalToWorld();
     // Extract rotation from world by transforming local forward vector.
     glm::vec3 localForward = glm::vec3(0.0f, 0.0f, -1.0f);
     glm::vec3 worldForward = glm::normalize(glm::vec3(world * glm::vec4(localForward, 0.0f)));
@@ -34,12 +34,13 @@ glm::mat4 Light::GetLightSpaceMatrix() const
 
     // Light's position should be somewhere "behind" the scene looking towards the center
     // The position is derived from its direction.
-    glm::vec3 lightPos = -WorldDirection() * 20.0f; // Move light back along its direction
+    const glm::vec3 lightDir = WorldDirection();
+    glm::vec3 lightPos = -lightDir * 20.0f;         // Move light back along its direction
     glm::vec3 target = glm::vec3(0.0f);             // Looking at the world origin
     glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f);
 
     // Check for gimbal lock case (light pointing straight up/down)
-    if (glm::abs(glm::dot(WorldDirection(), up)) > 0.99f)
+    if (glm::abs(glm::dot(lightDir, up)) > 0.99f)
     {
         up = glm::vec3(1.0f, 0.0f, 0.0f); // Use X-axis as up vector
     }
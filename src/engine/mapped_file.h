@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Read-only memory mapping of a whole file (mmap, or a file mapping on
+// Windows). Pages are read in on first touch, so nothing is copied until the
+// data is used, and then only by the OS.
+class MappedFile
+{
+public:
+    // IsOpen() is false if the file is missing, empty or cannot be mapped
+    explicit MappedFile(const std::string &path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool IsOpen() const { return data_ != nullptr; }
+    const unsigned char *Data() const { return data_; }
+    size_t Size() const { return size_; }
+
+private:
+    const unsigned char *data_ = nullptr;
+    size_t size_ = 0;
+#ifdef _WIN32
+    void *file_ = nullptr;
+    void *mapping_ = nullptr;
+#endif
+};
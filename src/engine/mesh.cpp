@@ -1,17 +1,48 @@
 #include "mesh.h"
 
+#include "geometry_arena.h"
+#include "gl_state_cache.h"
+
+#include <atomic>
+#include <stdexcept>
+
 Mesh::Mesh(const std::vector<MeshVertex> &vertices, const std::vector<unsigned int> &indices)
-    : vertices(vertices), indices(indices)
+    : Mesh(vertices, indices, ComputeBounds(vertices))
+{
+}
+
+Mesh::Mesh(const std::vector<MeshVertex> &vertices, const std::vector<unsigned int> &indices, const Aabb &bounds,
+           VertexFormat format)
+    : vertices(vertices), indices(indices), bounds_(bounds), format_(format)
 {
-    CreateBuffers(vertices, indices);
+    CreateBuffers();
+}
+
+Aabb Mesh::ComputeBounds(const std::vector<MeshVertex> &vertices)
+{
+    Aabb bounds;
+    for (const MeshVertex &v : vertices)
+    {
+        bounds.Expand(v.position);
+    }
+    return bounds;
+}
+
+uint64_t Mesh::NextGeometryId()
+{
+    static std::atomic<uint64_t> next{1};
+    return next.fetch_add(1, std::memory_order_relaxed);
 }
 
 Mesh::Mesh(Mesh &&other) noexcept
-    : vao_(other.vao_), vbo_(other.vbo_), ebo_(other.ebo_),
-      instance_vbo_(other.instance_vbo_), index_count_(other.index_count_)
+    : vertices(std::move(other.vertices)), indices(std::move(other.indices)), vao_(other.vao_), vbo_(other.vbo_), ebo_(other.ebo_),
+      instance_vbo_(other.instance_vbo_), index_count_(other.index_count_), bounds_(other.bounds_),
+      instance_size_(other.instance_size_), instance_capacity_(other.instance_capacity_), geometry_id_(other.geometry_id_),
+      format_(other.format_), position_decode_(other.position_decode_), quantization_error_(other.quantization_error_)
 {
     other.vao_ = other.vbo_ = other.ebo_ = other.instance_vbo_ = 0;
     other.index_count_ = 0;
+    other.geometry_id_ = 0;
 }
 
 Mesh &Mesh::operator=(Mesh &&other) noexcept
@@ -19,21 +50,35 @@ Mesh &Mesh::operator=(Mesh &&other) noexcept
     if (this != &other)
     {
         if (vao_)
+        {
+            GLStateCache::GetInstance().ForgetVertexArray(vao_);
             glDeleteVertexArrays(1, &vao_);
+        }
         if (vbo_)
             glDeleteBuffers(1, &vbo_);
         if (ebo_)
             glDeleteBuffers(1, &ebo_);
         if (instance_vbo_)
             glDeleteBuffers(1, &instance_vbo_);
+        GeometryArena::GetInstance().Release(geometry_id_);
 
+        vertices = std::move(other.vertices);
+        indices = std::move(other.indices);
         vao_ = other.vao_;
         vbo_ = other.vbo_;
         ebo_ = other.ebo_;
         instance_vbo_ = other.instance_vbo_;
         index_count_ = other.index_count_;
+        bounds_ = other.bounds_;
+        instance_size_ = other.instance_size_;
+        instance_capacity_ = other.instance_capacity_;
+        geometry_id_ = other.geometry_id_;
+        format_ = other.format_;
+        position_decode_ = other.position_decode_;
+        quantization_error_ = other.quantization_error_;
         other.vao_ = other.vbo_ = other.ebo_ = other.instance_vbo_ = 0;
         other.index_count_ = 0;
+        other.geometry_id_ = 0;
     }
     return *this;
 }
@@ -41,16 +86,56 @@ Mesh &Mesh::operator=(Mesh &&other) noexcept
 Mesh::~Mesh()
 {
     if (vao_)
+    {
+        GLStateCache::GetInstance().ForgetVertexArray(vao_);
         glDeleteVertexArrays(1, &vao_);
+    }
     if (vbo_)
         glDeleteBuffers(1, &vbo_);
     if (ebo_)
         glDeleteBuffers(1, &ebo_);
     if (instance_vbo_)
         glDeleteBuffers(1, &instance_vbo_);
+    GeometryArena::GetInstance().Release(geometry_id_);
 }
 
-void Mesh::CreateBuffers(const std::vector<MeshVertex> &vertices, const std::vector<unsigned int> &indices)
+Mesh::Mesh(const MeshData &data)
+    : vertices(data.vertices, data.vertices + data.vertex_count), indices(data.indices, data.index_count, data.index_type),
+      bounds_(data.bounds), format_(data.format)
+{
+    if (format_ == VertexFormat::Packed && !data.packed_vertices)
+    {
+        CreateBuffers();
+        return;
+    }
+    if (format_ == VertexFormat::Packed)
+    {
+        position_decode_ = VertexQuantization::PositionDecode(bounds_);
+        quantization_error_ = data.quantization_error;
+        UploadBuffers(data.packed_vertices, data.vertex_count * sizeof(PackedVertex), data.indices);
+    }
+    else
+    {
+        UploadBuffers(data.vertices, data.vertex_count * sizeof(MeshVertex), data.indices);
+    }
+}
+
+void Mesh::CreateBuffers()
+{
+    if (format_ == VertexFormat::Packed)
+    {
+        position_decode_ = VertexQuantization::PositionDecode(bounds_);
+        const std::vector<PackedVertex> packed =
+            VertexQuantization::Pack(vertices.data(), vertices.size(), bounds_, &quantization_error_);
+        UploadBuffers(packed.data(), packed.size() * sizeof(PackedVertex), indices.data());
+    }
+    else
+    {
+        UploadBuffers(vertices.data(), vertices.size() * sizeof(MeshVertex), indices.data());
+    }
+}
+
+void Mesh::UploadBuffers(const void *vertex_data, size_t vertex_bytes, const void *index_data)
 {
     index_count_ = static_cast<GLsizei>(indices.size());
 
@@ -58,14 +143,24 @@ void Mesh::CreateBuffers(const std::vector<MeshVertex> &vertices, const std::vec
     glGenBuffers(1, &vbo_);
     glGenBuffers(1, &ebo_);
 
-    glBindVertexArray(vao_);
+    GLStateCache::GetInstance().BindVertexArray(vao_);
 
     glBindBuffer(GL_ARRAY_BUFFER, vbo_);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(MeshVertex), vertices.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, vertex_bytes, vertex_data, GL_STATIC_DRAW);
 
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.ByteSize(), index_data, GL_STATIC_DRAW);
+
+    if (format_ == VertexFormat::Packed)
+        VertexQuantization::SetAttributes();
+    else
+        SetVertexAttributes();
+
+    GLStateCache::GetInstance().BindVertexArray(0);
+}
 
+void Mesh::SetVertexAttributes()
+{
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (void *)0);
     glEnableVertexAttribArray(0);
 
@@ -74,36 +169,75 @@ void Mesh::CreateBuffers(const std::vector<MeshVertex> &vertices, const std::vec
 
     glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (void *)(6 * sizeof(float)));
     glEnableVertexAttribArray(2);
-
-    glBindVertexArray(0);
 }
 
 void Mesh::Bind() const
 {
-    glBindVertexArray(vao_);
+    GLStateCache::GetInstance().BindVertexArray(vao_);
 }
 
 void Mesh::Draw() const
 {
-    glDrawElements(GL_TRIANGLES, index_count_, GL_UNSIGNED_INT, 0);
+    glDrawElements(GL_TRIANGLES, index_count_, indices.Type(), 0);
+}
+
+void Mesh::DrawRange(GLsizei first_index, GLsizei count) const
+{
+    glDrawElements(GL_TRIANGLES, count, indices.Type(), (void *)(first_index * indices.IndexSize()));
 }
 
 void Mesh::CreateInstanceBuffer(const std::vector<glm::mat4> &model_matrices)
 {
     instance_size_ = model_matrices.size();
-    // If we already have an instance buffer, delete it first
-    if (instance_vbo_)
+    if (!instance_vbo_)
     {
-        glDeleteBuffers(1, &instance_vbo_);
+        glGenBuffers(1, &instance_vbo_);
     }
-
-    glGenBuffers(1, &instance_vbo_);
     glBindBuffer(GL_ARRAY_BUFFER, instance_vbo_);
-    glBufferData(GL_ARRAY_BUFFER, instance_size_ * sizeof(glm::mat4), model_matrices.data(), GL_STATIC_DRAW);
+    if (model_matrices.size() > instance_capacity_)
+    {
+        instance_capacity_ = model_matrices.size();
+        glBufferData(GL_ARRAY_BUFFER, instance_capacity_ * sizeof(glm::mat4), model_matrices.data(), GL_DYNAMIC_DRAW);
+    }
+    else
+    {
+        glBufferSubData(GL_ARRAY_BUFFER, 0, model_matrices.size() * sizeof(glm::mat4), model_matrices.data());
+    }
 
     // We need to tell the VAO how to interpret this new buffer data.
-    glBindVertexArray(vao_);
+    GLStateCache::GetInstance().BindVertexArray(vao_);
+    SetInstanceAttributes(0);
 
+    GLStateCache::GetInstance().BindVertexArray(0);
+}
+
+void Mesh::UpdateInstances(size_t first, const glm::mat4 *matrices, size_t count)
+{
+    if (first + count > static_cast<size_t>(instance_size_))
+    {
+        throw std::runtime_error("Mesh::UpdateInstances: range past the end of the instance buffer");
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, instance_vbo_);
+    glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(glm::mat4), count * sizeof(glm::mat4), matrices);
+}
+
+void Mesh::StreamInstances(StreamBuffer &stream, const glm::mat4 *matrices, size_t count)
+{
+    const size_t offset = stream.Upload(matrices, count * sizeof(glm::mat4));
+    BindInstances(stream.Id(), offset);
+    GLStateCache::GetInstance().BindVertexArray(0);
+    instance_size_ = static_cast<int>(count);
+}
+
+void Mesh::BindInstances(GLuint buffer, size_t byte_offset) const
+{
+    GLStateCache::GetInstance().BindVertexArray(vao_);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    SetInstanceAttributes(byte_offset);
+}
+
+void Mesh::SetInstanceAttributes(size_t byte_offset)
+{
     // A mat4 is equivalent to 4 vec4s. We need to set vertex attributes for each of them.
     // Your existing attributes are at locations 0, 1, 2. We'll start at 3.
     const GLuint starting_attrib_location = 3;
@@ -117,18 +251,21 @@ void Mesh::CreateInstanceBuffer(const std::vector<glm::mat4> &model_matrices)
             GL_FLOAT,                       // Type
             GL_FALSE,                       // Normalize
             sizeof(glm::mat4),              // Stride: total size of one instance's data
-            (void *)(i * sizeof(glm::vec4)) // Offset to this column
+            (void *)(byte_offset + i * sizeof(glm::vec4)) // Offset to this column
         );
         // This is the key! It tells OpenGL to advance this attribute only once per instance.
         glVertexAttribDivisor(current_location, 1);
     }
-
-    glBindVertexArray(0);
 }
 
 // ✨ Here is the new instanced draw call implementation ✨
 void Mesh::DrawInstanced() const
 {
     // The second-to-last argument is the number of instances to render.
-    glDrawElementsInstanced(GL_TRIANGLES, index_count_, GL_UNSIGNED_INT, 0, instance_size_);
-}
\ No newline at end of file
+    glDrawElementsInstanced(GL_TRIANGLES, index_count_, indices.Type(), 0, instance_size_);
+}
+
+void Mesh::DrawInstanced(GLsizei count) const
+{
+    glDrawElementsInstanced(GL_TRIANGLES, index_count_, indices.Type(), 0, count);
+}
@@ -1,8 +1,13 @@
 #pragma once
 
+#include <cstdint>
 #include <vector>
 #include <glad/glad.h>
 #include <glm/glm.hpp>
+#include "bounds.h"
+#include "mesh_indices.h"
+#include "stream_buffer.h"
+#include "vertex_quantization.h"
 
 struct MeshVertex
 {
@@ -11,14 +16,38 @@ struct MeshVertex
     glm::vec2 uv;
 };
 
+// Geometry already in its final layout, such as a mapped MeshCache file. The
+// GPU buffers are filled straight from it; the mesh keeps CPU copies.
+struct MeshData
+{
+    const MeshVertex *vertices = nullptr;
+    size_t vertex_count = 0;
+    const void *indices = nullptr;   // index_count of index_type
+    size_t index_count = 0;
+    GLenum index_type = GL_UNSIGNED_INT;
+    Aabb bounds;
+    VertexFormat format = VertexFormat::Float;
+    // For VertexFormat::Packed: the GPU stream, vertex_count long, and its error
+    const PackedVertex *packed_vertices = nullptr;
+    QuantizationError quantization_error;
+};
+
 class Mesh
 {
 public:
-    int instance_id;
+    int instance_id = 0;
     std::vector<MeshVertex> vertices;
-    std::vector<unsigned int> indices;
+    // 16-bit when every index fits, as uploaded
+    MeshIndices indices;
     Mesh() = default;
+    // Bounds are computed from the vertex positions
     Mesh(const std::vector<MeshVertex> &vertices, const std::vector<unsigned int> &indices);
+    // For loaders that already know the object-space bounds. With
+    // VertexFormat::Packed the GPU copy is quantized against them (the CPU
+    // copy in `vertices` stays full precision).
+    Mesh(const std::vector<MeshVertex> &vertices, const std::vector<unsigned int> &indices, const Aabb &bounds,
+         VertexFormat format = VertexFormat::Float);
+    explicit Mesh(const MeshData &data);
 
     Mesh(const Mesh &) = delete;
     Mesh &operator=(const Mesh &) = delete;
@@ -26,14 +55,55 @@ public:
     Mesh &operator=(Mesh &&other) noexcept;
     ~Mesh();
 
+    // Sets the instance matrices drawn by DrawInstanced(). The buffer is kept
+    // across calls and only reallocated when the count outgrows it.
     void CreateInstanceBuffer(const std::vector<glm::mat4> &model_matrices);
+    // Overwrites instances [first, first + count) of that buffer; the VAO is left alone
+    void UpdateInstances(size_t first, const glm::mat4 *matrices, size_t count);
+    // Per-frame alternative: writes `count` matrices into this frame's region of
+    // `stream` and points DrawInstanced() at them, with no reallocation
+    void StreamInstances(StreamBuffer &stream, const glm::mat4 *matrices, size_t count);
+    // Points the instance-matrix attributes at mat4s the caller streamed into
+    // `buffer` from `byte_offset` on, for DrawInstanced(count). Leaves the VAO bound.
+    void BindInstances(GLuint buffer, size_t byte_offset) const;
+
+    // Object-space bounding box of the vertex positions
+    const Aabb &Bounds() const { return bounds_; }
+    static Aabb ComputeBounds(const std::vector<MeshVertex> &vertices);
+
+    VertexFormat Format() const { return format_; }
+    // Object position = xyz + stored position * w: (0, 0, 0, 1) for float vertices
+    const glm::vec4 &PositionDecode() const { return position_decode_; }
+    // How far the packed vertices are from `vertices`; zero for float vertices
+    const QuantizationError &GetQuantizationError() const { return quantization_error_; }
+
+    GLsizei IndexCount() const { return index_count_; }
+    // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT, whatever `indices` holds
+    GLenum IndexType() const { return indices.Type(); }
+    // Names this mesh's geometry in GeometryArena; unique for the process and
+    // never reused, so a stale arena entry cannot match a new mesh
+    uint64_t GeometryId() const { return geometry_id_; }
+    // Instances drawn by DrawInstanced (set by CreateInstanceBuffer)
+    int InstanceCount() const { return instance_size_; }
 
     void Bind() const;
     void Draw() const;
+    // `count` indices starting at `first_index`, from the bound VAO
+    void DrawRange(GLsizei first_index, GLsizei count) const;
     void DrawInstanced() const;
+    void DrawInstanced(GLsizei count) const;
+
+    // Attribute setup for the bound VAO, shared with GeometryArena's.
+    // Attributes 0..2 read MeshVertex from GL_ARRAY_BUFFER.
+    static void SetVertexAttributes();
+    // Attributes 3..6 read one mat4 per instance from GL_ARRAY_BUFFER at `byte_offset`
+    static void SetInstanceAttributes(size_t byte_offset);
 
 private:
-    void CreateBuffers(const std::vector<MeshVertex> &vertices, const std::vector<unsigned int> &indices);
+    void CreateBuffers();
+    // Creates the VAO and buffers from data laid out for format_ and indices.Type()
+    void UploadBuffers(const void *vertex_data, size_t vertex_bytes, const void *index_data);
+    static uint64_t NextGeometryId();
 
 private:
     GLuint vao_ = 0;
@@ -41,6 +111,11 @@ private:
     GLuint ebo_ = 0;
     GLuint instance_vbo_ = 0;
     GLsizei index_count_ = 0;
-    int instance_size_;
-    // Future: consider primitive restart or 32-bit indices based on size
+    Aabb bounds_{};
+    int instance_size_ = 0;
+    size_t instance_capacity_ = 0;
+    uint64_t geometry_id_ = NextGeometryId();
+    VertexFormat format_ = VertexFormat::Float;
+    glm::vec4 position_decode_{0.0f, 0.0f, 0.0f, 1.0f};
+    QuantizationError quantization_error_;
 };
@@ -0,0 +1,368 @@
+#include "mesh_cache.h"
+
+#include "mapped_file.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+// Bump whenever the layout below changes
+static constexpr uint32_t kCacheVersion = 2;
+static constexpr char kMagic[8] = {'C', 'G', 'L', 'M', 'E', 'S', 'H', '\0'};
+static constexpr uint32_t kByteOrder = 0x01020304u;
+// Every blob starts on this boundary, so mapped vertices and indices are aligned
+static constexpr size_t kBlobAlignment = 16;
+
+std::string MeshCache::directory_ = ".meshcache";
+
+namespace
+{
+struct FileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t vertex_size;   // sizeof(MeshVertex) and sizeof(PackedVertex) when written
+    uint32_t packed_size;
+    uint64_t import_key;
+    uint64_t file_size;
+    uint64_t source_size;
+    int64_t source_mtime;
+    uint64_t source_hash;
+    uint32_t mesh_count;
+    uint32_t padding;
+};
+
+// One per submesh, after the header. Offsets are from the start of the file.
+struct SubmeshEntry
+{
+    uint64_t vertex_offset;
+    uint64_t packed_offset;   // 0 unless format is VertexFormat::Packed
+    uint64_t index_offset;
+    uint32_t vertex_count;
+    uint32_t index_count;
+    uint32_t index_type;
+    uint32_t format;
+    float bounds_min[3];
+    float bounds_max[3];
+    QuantizationError quantization_error;
+    uint64_t triangles;
+    uint64_t vertices_before;
+    uint64_t vertices_after;
+    MeshDrawStats stats[4];   // MeshOptimizationReport's, in order
+    float lod_error;          // MeshLod::error for LOD chains, 0 otherwise
+    uint32_t padding;
+};
+} // namespace
+
+static size_t AlignUp(size_t value)
+{
+    return (value + kBlobAlignment - 1) / kBlobAlignment * kBlobAlignment;
+}
+
+static int64_t ModificationTime(const fs::file_time_type &time)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+// Size, modification time and (if `hash` is given) content hash of a source file
+static bool DescribeSource(const std::string &path, uint64_t &size, int64_t &mtime, uint64_t *hash)
+{
+    std::error_code error;
+    size = fs::file_size(path, error);
+    if (error)
+        return false;
+    const fs::file_time_type time = fs::last_write_time(path, error);
+    if (error)
+        return false;
+    mtime = ModificationTime(time);
+    if (hash)
+    {
+        MappedFile source(path);
+        if (!source.IsOpen())
+            return false;
+        *hash = MeshCache::Hash(source.Data(), source.Size());
+    }
+    return true;
+}
+
+static bool ValidBlob(uint64_t offset, uint64_t count, size_t element_size, size_t file_size)
+{
+    return offset % kBlobAlignment == 0 && offset <= file_size && count <= (file_size - offset) / element_size;
+}
+
+// Every index must name one of the entry's vertices, or the GPU and the CPU
+// occlusion rasterizer would read past them
+template <typename Index>
+static bool IndicesBelow(const unsigned char *data, size_t count, uint32_t vertex_count)
+{
+    const Index *indices = reinterpret_cast<const Index *>(data);
+    Index largest = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        largest = std::max(largest, indices[i]);
+    }
+    return count == 0 || largest < vertex_count;
+}
+
+void MeshCache::SetDirectory(const std::string &directory)
+{
+    directory_ = directory;
+}
+
+const std::string &MeshCache::Directory()
+{
+    return directory_;
+}
+
+uint64_t MeshCache::Hash(const void *data, size_t size, uint64_t seed)
+{
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    uint64_t hash = seed;
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+std::string MeshCache::CachePath(const std::string &source_path, uint64_t import_key)
+{
+    const uint64_t name_hash = Hash(&import_key, sizeof(import_key), Hash(source_path.data(), source_path.size()));
+    char suffix[32];
+    std::snprintf(suffix, sizeof(suffix), "-%016llx.mesh", static_cast<unsigned long long>(name_hash));
+    return (fs::path(directory_) / (fs::path(source_path).filename().string() + suffix)).string();
+}
+
+bool MeshCache::Load(const std::string &source_path, uint64_t import_key, std::vector<Mesh> &meshes,
+                     std::vector<MeshOptimizationReport> *reports, std::vector<float> *lod_errors)
+{
+    if (directory_.empty())
+        return false;
+    uint64_t source_size = 0;
+    int64_t source_mtime = 0;
+    if (!DescribeSource(source_path, source_size, source_mtime, nullptr))
+        return false;
+
+    const std::string path = CachePath(source_path, import_key);
+    FileHeader header;
+    bool refresh_header = false;
+    {
+        MappedFile file(path);
+        if (!file.IsOpen() || file.Size() < sizeof(FileHeader))
+            return false;
+        std::memcpy(&header, file.Data(), sizeof(header));
+        if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kCacheVersion ||
+            header.byte_order != kByteOrder || header.vertex_size != sizeof(MeshVertex) ||
+            header.packed_size != sizeof(PackedVertex) || header.import_key != import_key ||
+            header.file_size != file.Size())
+            return false;
+        if (header.source_size != source_size || header.source_mtime != source_mtime)
+        {
+            // Touched (a checkout, a copy) but possibly unchanged: the content decides
+            uint64_t source_hash = 0;
+            if (!DescribeSource(source_path, source_size, source_mtime, &source_hash) ||
+                source_hash != header.source_hash)
+                return false;
+            refresh_header = true;
+        }
+
+        const size_t entries_end = sizeof(FileHeader) + static_cast<size_t>(header.mesh_count) * sizeof(SubmeshEntry);
+        if (header.mesh_count > file.Size() / sizeof(SubmeshEntry) || entries_end > file.Size())
+            return false;
+        std::vector<SubmeshEntry> entries(header.mesh_count);
+        if (!entries.empty())
+            std::memcpy(entries.data(), file.Data() + sizeof(FileHeader), entries.size() * sizeof(SubmeshEntry));
+        // Everything is checked before the first GL upload
+        for (const SubmeshEntry &entry : entries)
+        {
+            const bool packed = entry.format == static_cast<uint32_t>(VertexFormat::Packed);
+            if ((entry.index_type != GL_UNSIGNED_SHORT && entry.index_type != GL_UNSIGNED_INT) ||
+                (!packed && entry.format != static_cast<uint32_t>(VertexFormat::Float)) ||
+                !ValidBlob(entry.vertex_offset, entry.vertex_count, sizeof(MeshVertex), file.Size()) ||
+                !ValidBlob(entry.index_offset, entry.index_count, MeshIndices::TypeSize(entry.index_type), file.Size()) ||
+                (packed && !ValidBlob(entry.packed_offset, entry.vertex_count, sizeof(PackedVertex), file.Size())))
+                return false;
+            const unsigned char *indices = file.Data() + entry.index_offset;
+            const bool indices_valid = entry.index_type == GL_UNSIGNED_SHORT
+                                           ? IndicesBelow<uint16_t>(indices, entry.index_count, entry.vertex_count)
+                                           : IndicesBelow<uint32_t>(indices, entry.index_count, entry.vertex_count);
+            if (!indices_valid)
+                return false;
+        }
+
+        meshes.clear();
+        meshes.reserve(entries.size());
+        if (reports)
+            reports->assign(entries.size(), MeshOptimizationReport{});
+        if (lod_errors)
+            lod_errors->assign(entries.size(), 0.0f);
+        for (size_t i = 0; i < entries.size(); ++i)
+        {
+            const SubmeshEntry &entry = entries[i];
+            MeshData data;
+            data.vertices = reinterpret_cast<const MeshVertex *>(file.Data() + entry.vertex_offset);
+            data.vertex_count = entry.vertex_count;
+            data.indices = file.Data() + entry.index_offset;
+            data.index_count = entry.index_count;
+            data.index_type = entry.index_type;
+            data.bounds.min = glm::vec3(entry.bounds_min[0], entry.bounds_min[1], entry.bounds_min[2]);
+            data.bounds.max = glm::vec3(entry.bounds_max[0], entry.bounds_max[1], entry.bounds_max[2]);
+            data.format = static_cast<VertexFormat>(entry.format);
+            if (data.format == VertexFormat::Packed)
+            {
+                data.packed_vertices = reinterpret_cast<const PackedVertex *>(file.Data() + entry.packed_offset);
+                data.quantization_error = entry.quantization_error;
+            }
+            meshes.emplace_back(data);
+
+            if (reports)
+            {
+                MeshOptimizationReport &report = (*reports)[i];
+                report.triangles = entry.triangles;
+                report.vertices_before = entry.vertices_before;
+                report.vertices_after = entry.vertices_after;
+                report.original = entry.stats[0];
+                report.vertex_cache = entry.stats[1];
+                report.overdraw = entry.stats[2];
+                report.vertex_fetch = entry.stats[3];
+            }
+            if (lod_errors)
+                (*lod_errors)[i] = entry.lod_error;
+        }
+    }
+
+    if (refresh_header)
+    {
+        // Record the new size and time, so the next load skips the hash
+        header.source_size = source_size;
+        header.source_mtime = source_mtime;
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        if (file)
+            file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    }
+    return true;
+}
+
+bool MeshCache::Store(const std::string &source_path, uint64_t import_key, const std::vector<Mesh> &meshes,
+                      const std::vector<MeshOptimizationReport> &reports)
+{
+    std::vector<const Mesh *> pointers;
+    pointers.reserve(meshes.size());
+    for (const Mesh &mesh : meshes)
+    {
+        pointers.push_back(&mesh);
+    }
+    return Store(source_path, import_key, pointers, reports, {});
+}
+
+bool MeshCache::Store(const std::string &source_path, uint64_t import_key, const std::vector<const Mesh *> &meshes,
+                      const std::vector<MeshOptimizationReport> &reports, const std::vector<float> &lod_errors)
+{
+    if (directory_.empty())
+        return false;
+    FileHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kCacheVersion;
+    header.byte_order = kByteOrder;
+    header.vertex_size = sizeof(MeshVertex);
+    header.packed_size = sizeof(PackedVertex);
+    header.import_key = import_key;
+    header.mesh_count = static_cast<uint32_t>(meshes.size());
+    if (!DescribeSource(source_path, header.source_size, header.source_mtime, &header.source_hash))
+        return false;
+
+    // The packed stream is what Mesh uploaded; packing is deterministic, so it is rebuilt here
+    std::vector<std::vector<PackedVertex>> packed(meshes.size());
+    std::vector<SubmeshEntry> entries(meshes.size());
+    size_t offset = AlignUp(sizeof(FileHeader) + entries.size() * sizeof(SubmeshEntry));
+    for (size_t i = 0; i < meshes.size(); ++i)
+    {
+        const Mesh &mesh = *meshes[i];
+        SubmeshEntry &entry = entries[i];
+        entry = SubmeshEntry{};
+        entry.vertex_count = static_cast<uint32_t>(mesh.vertices.size());
+        entry.index_count = static_cast<uint32_t>(mesh.indices.size());
+        entry.index_type = mesh.IndexType();
+        entry.format = static_cast<uint32_t>(mesh.Format());
+        for (int k = 0; k < 3; ++k)
+        {
+            entry.bounds_min[k] = mesh.Bounds().min[k];
+            entry.bounds_max[k] = mesh.Bounds().max[k];
+        }
+        entry.quantization_error = mesh.GetQuantizationError();
+        if (i < reports.size())
+        {
+            const MeshOptimizationReport &report = reports[i];
+            entry.triangles = report.triangles;
+            entry.vertices_before = report.vertices_before;
+            entry.vertices_after = report.vertices_after;
+            entry.stats[0] = report.original;
+            entry.stats[1] = report.vertex_cache;
+            entry.stats[2] = report.overdraw;
+            entry.stats[3] = report.vertex_fetch;
+        }
+        if (i < lod_errors.size())
+            entry.lod_error = lod_errors[i];
+
+        entry.vertex_offset = offset;
+        offset = AlignUp(offset + mesh.vertices.size() * sizeof(MeshVertex));
+        entry.index_offset = offset;
+        offset = AlignUp(offset + mesh.indices.ByteSize());
+        if (mesh.Format() == VertexFormat::Packed)
+        {
+            packed[i] = VertexQuantization::Pack(mesh.vertices.data(), mesh.vertices.size(), mesh.Bounds());
+            entry.packed_offset = offset;
+            offset = AlignUp(offset + packed[i].size() * sizeof(PackedVertex));
+        }
+    }
+    header.file_size = offset;
+
+    std::error_code error;
+    fs::create_directories(directory_, error);
+    if (error)
+        return false;
+    // Written aside and renamed over the old file, so a reader never maps half a file
+    const std::string path = CachePath(source_path, import_key);
+    const std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file)
+            return false;
+        const char zeros[kBlobAlignment] = {};
+        size_t written = 0;
+        auto write = [&](const void *data, size_t size, size_t at)
+        {
+            file.write(zeros, static_cast<std::streamsize>(at - written));
+            file.write(static_cast<const char *>(data), static_cast<std::streamsize>(size));
+            written = at + size;
+        };
+        write(&header, sizeof(header), 0);
+        if (!entries.empty())
+            write(entries.data(), entries.size() * sizeof(SubmeshEntry), sizeof(FileHeader));
+        for (size_t i = 0; i < meshes.size(); ++i)
+        {
+            const Mesh &mesh = *meshes[i];
+            write(mesh.vertices.data(), mesh.vertices.size() * sizeof(MeshVertex), entries[i].vertex_offset);
+            write(mesh.indices.data(), mesh.indices.ByteSize(), entries[i].index_offset);
+            if (!packed[i].empty())
+                write(packed[i].data(), packed[i].size() * sizeof(PackedVertex), entries[i].packed_offset);
+        }
+        file.write(zeros, static_cast<std::streamsize>(header.file_size - written));
+        if (!file)
+            return false;
+    }
+    fs::rename(temporary, path, error);
+    if (error)
+    {
+        fs::remove(temporary, error);
+        return false;
+    }
+    return true;
+}
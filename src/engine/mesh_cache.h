@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "mesh.h"
+#include "mesh_optimizer.h"
+
+// Binary cache of imported meshes, one file per source asset and import key
+// (the flags and options that shape the result). A file holds every submesh's
+// vertices, indices at their final width, bounds, packed vertex stream when
+// the format is packed, optimization report and (for LOD chains)
+// simplification error, laid out so a mapped file can be uploaded from directly.
+//
+// A file is used while the source's size and modification time match the
+// ones recorded; when they differ, the source is hashed and the file is still
+// used if the content hash matches. Anything else (missing, stale, another
+// version of the layout, truncated, indices past the vertices) is a miss, and
+// the caller reimports.
+class MeshCache
+{
+public:
+    // Where cache files go, relative to the working directory unless absolute;
+    // empty turns the cache off. Defaults to ".meshcache".
+    static void SetDirectory(const std::string &directory);
+    static const std::string &Directory();
+
+    static std::string CachePath(const std::string &source_path, uint64_t import_key);
+
+    // Fills `meshes` (and `reports` and `lod_errors`, if given) from a valid cache file
+    static bool Load(const std::string &source_path, uint64_t import_key, std::vector<Mesh> &meshes,
+                     std::vector<MeshOptimizationReport> *reports = nullptr, std::vector<float> *lod_errors = nullptr);
+    // Writes the cache file for `meshes`, replacing any previous one. `reports`
+    // and `lod_errors` may be empty or hold one per mesh. False if the file
+    // could not be written.
+    static bool Store(const std::string &source_path, uint64_t import_key, const std::vector<Mesh> &meshes,
+                      const std::vector<MeshOptimizationReport> &reports);
+    static bool Store(const std::string &source_path, uint64_t import_key, const std::vector<const Mesh *> &meshes,
+                      const std::vector<MeshOptimizationReport> &reports, const std::vector<float> &lod_errors);
+
+    // FNV-1a, 64-bit
+    static uint64_t Hash(const void *data, size_t size, uint64_t seed = 14695981039346656037ull);
+
+private:
+    static std::string directory_;
+};
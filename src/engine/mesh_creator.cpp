@@ -96,7 +96,10 @@ Mesh MeshCreator::CreateCube(float side_length)
         triangleIndices.insert(triangleIndices.end(), std::begin(tris), std::end(tris));
     }
 
-    return Mesh(vertices, triangleIndices);
+    Aabb bounds;
+    bounds.min = glm::vec3(-halfExtent);
+    bounds.max = glm::vec3(halfExtent);
+    return Mesh(vertices, triangleIndices, bounds);
 }
 
 Mesh MeshCreator::CreateUnitCube()
@@ -121,7 +124,10 @@ Mesh MeshCreator::CreateUnitPlane()
     AppendVertex(vertices, { halfExtent, 0.0f,  halfExtent}, upNormal, {1.0f, 1.0f}); // 2: top-right
     AppendVertex(vertices, {-halfExtent, 0.0f,  halfExtent}, upNormal, {0.0f, 1.0f}); // 3: top-left
 
-    return Mesh(vertices, triangleIndices);
+    Aabb bounds;
+    bounds.min = glm::vec3(-halfExtent, 0.0f, -halfExtent);
+    bounds.max = glm::vec3(halfExtent, 0.0f, halfExtent);
+    return Mesh(vertices, triangleIndices, bounds);
 }
 
 
@@ -0,0 +1,45 @@
+#include "mesh_indices.h"
+
+#include <algorithm>
+#include <limits>
+
+MeshIndices::MeshIndices(const std::vector<unsigned int> &indices)
+{
+    // Primitive restart is never enabled, so 0xffff is an ordinary index
+    const unsigned int largest = indices.empty() ? 0u : *std::max_element(indices.begin(), indices.end());
+    wide_ = largest > std::numeric_limits<uint16_t>::max();
+    if (wide_)
+    {
+        wide_indices_.assign(indices.begin(), indices.end());
+    }
+    else
+    {
+        narrow_indices_.reserve(indices.size());
+        for (unsigned int index : indices)
+            narrow_indices_.push_back(static_cast<uint16_t>(index));
+    }
+}
+
+MeshIndices::MeshIndices(const void *data, size_t count, GLenum type) : wide_(type != GL_UNSIGNED_SHORT)
+{
+    if (wide_)
+    {
+        const uint32_t *source = static_cast<const uint32_t *>(data);
+        wide_indices_.assign(source, source + count);
+    }
+    else
+    {
+        const uint16_t *source = static_cast<const uint16_t *>(data);
+        narrow_indices_.assign(source, source + count);
+    }
+}
+
+const void *MeshIndices::data() const
+{
+    return wide_ ? static_cast<const void *>(wide_indices_.data()) : static_cast<const void *>(narrow_indices_.data());
+}
+
+std::vector<unsigned int> MeshIndices::Widen() const
+{
+    return std::vector<unsigned int>(begin(), end());
+}
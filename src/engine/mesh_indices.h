@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+#include <glad/glad.h>
+
+// Triangle indices as the GL index buffer gets them: 16-bit when the largest
+// index fits, 32-bit otherwise. Reads widen to unsigned int, so code walking
+// the indices does not care which width was picked.
+class MeshIndices
+{
+public:
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = unsigned int;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = unsigned int;
+
+        const_iterator(const MeshIndices *indices, size_t position) : indices_(indices), position_(position) {}
+        unsigned int operator*() const { return (*indices_)[position_]; }
+        const_iterator &operator++()
+        {
+            ++position_;
+            return *this;
+        }
+        bool operator==(const const_iterator &other) const { return position_ == other.position_; }
+        bool operator!=(const const_iterator &other) const { return position_ != other.position_; }
+
+    private:
+        const MeshIndices *indices_;
+        size_t position_;
+    };
+
+    MeshIndices() = default;
+    explicit MeshIndices(const std::vector<unsigned int> &indices);
+    // `count` indices of `type` (GL_UNSIGNED_SHORT or GL_UNSIGNED_INT), kept at that width
+    MeshIndices(const void *data, size_t count, GLenum type);
+
+    // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+    GLenum Type() const { return wide_ ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT; }
+    size_t IndexSize() const { return wide_ ? sizeof(uint32_t) : sizeof(uint16_t); }
+    static size_t TypeSize(GLenum type) { return type == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t); }
+
+    size_t size() const { return wide_ ? wide_indices_.size() : narrow_indices_.size(); }
+    bool empty() const { return size() == 0; }
+    unsigned int operator[](size_t i) const { return wide_ ? wide_indices_[i] : narrow_indices_[i]; }
+    // The stored indices, Type() each, ByteSize() in all
+    const void *data() const;
+    size_t ByteSize() const { return size() * IndexSize(); }
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, size()); }
+
+    // A 32-bit copy, for tools that only take unsigned int
+    std::vector<unsigned int> Widen() const;
+
+private:
+    std::vector<uint16_t> narrow_indices_;
+    std::vector<uint32_t> wide_indices_;
+    bool wide_ = false;
+};
@@ -0,0 +1,82 @@
+#include "mesh_lod.h"
+#include "mesh_optimizer.h"
+#include "mesh_simplifier.h"
+
+#include <algorithm>
+#include <cmath>
+
+LodGroup::LodGroup(std::shared_ptr<Mesh> base)
+{
+    levels_.push_back(MeshLod{std::move(base), 0.0f, 0.0f});
+}
+
+std::shared_ptr<LodGroup> LodGroup::Generate(std::shared_ptr<Mesh> base, const LodSettings &settings)
+{
+    auto group = std::make_shared<LodGroup>(base);
+    const Mesh &source = *base;
+    size_t previous_triangles = source.indices.size() / 3;
+    // The simplifier works on 32-bit indices whatever width the mesh stores
+    const std::vector<unsigned int> source_indices = source.indices.Widen();
+
+    std::vector<MeshVertex> vertices;
+    std::vector<unsigned int> indices;
+    for (int level = 1; level < settings.max_levels; ++level)
+    {
+        const size_t target = static_cast<size_t>(previous_triangles * settings.triangle_ratio);
+        if (target == 0)
+            break;
+        // Each level starts from the full mesh so errors do not compound
+        const float error = MeshSimplifier::Simplify(source.vertices, source_indices, target * 3, settings.max_error,
+                                                     vertices, indices);
+        const size_t triangles = indices.size() / 3;
+        // Not worth a level if the error budget stopped it well short of the target
+        if (triangles == 0 || triangles > previous_triangles * (1.0f + settings.triangle_ratio) * 0.5f)
+            break;
+
+        // Collapses leave the survivors in source order; reorder them as on import, unmeasured
+        MeshOptimizer::OptimizeVertexCache(indices, vertices.size());
+        MeshOptimizer::OptimizeOverdraw(indices, vertices);
+        MeshOptimizer::OptimizeVertexFetch(vertices, indices);
+        // Same bounds and vertex format as the base mesh, so culling does not change with the level
+        group->AddLevel(MeshLod{std::make_shared<Mesh>(vertices, indices, source.Bounds(), source.Format()), 0.0f, error});
+        previous_triangles = triangles;
+    }
+    group->AssignScreenSizes(settings.first_screen_size, settings.screen_size_ratio);
+    return group;
+}
+
+void LodGroup::AssignScreenSizes(float first, float ratio)
+{
+    float screen_size = first;
+    for (size_t i = 0; i < levels_.size(); ++i)
+    {
+        levels_[i].screen_size = i + 1 < levels_.size() ? screen_size : 0.0f;
+        screen_size *= ratio;
+    }
+}
+
+size_t LodGroup::Select(float screen_size, size_t current) const
+{
+    size_t level = std::min(current, levels_.size() - 1);
+    while (level > 0 && screen_size >= levels_[level - 1].screen_size * (1.0f + hysteresis))
+        --level;
+    while (level + 1 < levels_.size() && screen_size < levels_[level].screen_size * (1.0f - hysteresis))
+        ++level;
+    return level;
+}
+
+float LodGroup::ScreenSize(const Aabb &local_bounds, const glm::mat4 &model, const glm::mat4 &view,
+                           const glm::mat4 &projection)
+{
+    const glm::vec3 center = glm::vec3(view * model * glm::vec4(local_bounds.Center(), 1.0f));
+    const float scale = std::max(glm::length(glm::vec3(model[0])),
+                                 std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+    const float radius = glm::length(local_bounds.Extents()) * scale;
+    // projection[1][1] maps view-space height to NDC, which spans 2 units
+    if (projection[3][3] == 1.0f)
+        return radius * projection[1][1];
+    const float depth = -center.z;
+    if (depth <= radius)
+        return FLT_MAX;
+    return radius * projection[1][1] / depth;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+#include "bounds.h"
+#include "mesh.h"
+
+// How LodGroup::Generate builds a chain
+struct LodSettings
+{
+    int max_levels = 5;               // including the full-resolution mesh
+    float triangle_ratio = 0.35f;     // each level keeps this fraction of the previous level's triangles
+    float max_error = 0.05f;          // give up on a level past this error (fraction of the mesh diagonal)
+    float first_screen_size = 0.25f;  // projected height below which level 1 takes over
+    float screen_size_ratio = 0.5f;   // each further level starts at this fraction of the previous threshold
+};
+
+// One level of detail, used while the object's projected height (as a fraction
+// of the viewport height) is at least `screen_size`
+struct MeshLod
+{
+    std::shared_ptr<Mesh> mesh;
+    float screen_size = 0.0f;
+    float error = 0.0f;  // simplification error, relative to the mesh diagonal
+};
+
+// A mesh and its simplified versions, finest first. Shared by every renderer
+// drawing the same model; each renderer remembers its own current level.
+class LodGroup
+{
+public:
+    // Fraction of the switching threshold an object has to cross before its
+    // level changes, so objects sitting on a threshold do not flicker
+    float hysteresis = 0.15f;
+
+    LodGroup() = default;
+    explicit LodGroup(std::shared_ptr<Mesh> base);
+
+    // Simplifies `base` (which needs its CPU vertices and indices) into a chain.
+    // Stops early once a level cannot reach its target within max_error.
+    static std::shared_ptr<LodGroup> Generate(std::shared_ptr<Mesh> base, const LodSettings &settings = {});
+
+    // Levels must be added in decreasing screen_size order
+    void AddLevel(MeshLod level) { levels_.push_back(std::move(level)); }
+    // Level i stays in use down to first * ratio^i; the coarsest level never switches out
+    void AssignScreenSizes(float first, float ratio);
+    size_t LevelCount() const { return levels_.size(); }
+    const MeshLod &Level(size_t index) const { return levels_[index]; }
+
+    // Level to draw at `screen_size`, moving from `current` only past the hysteresis band
+    size_t Select(float screen_size, size_t current) const;
+
+    // Projected height of the bounding sphere of `local_bounds`, as a fraction of the viewport height
+    static float ScreenSize(const Aabb &local_bounds, const glm::mat4 &model, const glm::mat4 &view,
+                            const glm::mat4 &projection);
+
+private:
+    std::vector<MeshLod> levels_;
+};
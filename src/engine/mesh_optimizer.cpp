@@ -0,0 +1,450 @@
+#include "mesh_optimizer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <utility>
+
+// Resolution of each of the six overdraw views
+static constexpr int kOverdrawViewport = 256;
+// Vertex fetch simulation: 8 KB of 64-byte lines
+static constexpr size_t kFetchLineSize = 64;
+static constexpr unsigned int kFetchCacheLines = 128;
+static constexpr unsigned int kNoVertex = std::numeric_limits<unsigned int>::max();
+
+namespace
+{
+// FIFO cache over vertex ids with timestamps: an id is cached while fewer than
+// `size` misses happened since it was loaded. Restart() empties it in O(1).
+class FifoCache
+{
+public:
+    FifoCache(size_t entries, unsigned int size) : loaded_(entries, 0), time_(size + 1), size_(size) {}
+
+    // True, and loads `id`, if it was not cached
+    bool Miss(size_t id)
+    {
+        if (time_ - loaded_[id] <= size_)
+            return false;
+        loaded_[id] = time_++;
+        return true;
+    }
+    void Restart() { time_ += size_ + 1; }
+
+private:
+    std::vector<unsigned int> loaded_;
+    unsigned int time_;
+    unsigned int size_;
+};
+} // namespace
+
+std::string MeshOptimizationReport::Format() const
+{
+    char line[160];
+    std::snprintf(line, sizeof(line), "%zu triangles, %zu -> %zu vertices\n", triangles, vertices_before,
+                  vertices_after);
+    std::string text = line;
+    const std::pair<const char *, const MeshDrawStats *> steps[] = {
+        {"imported", &original}, {"vertex cache", &vertex_cache}, {"overdraw", &overdraw}, {"vertex fetch", &vertex_fetch}};
+    for (const auto &step : steps)
+    {
+        std::snprintf(line, sizeof(line), "  %-13s acmr %.3f  atvr %.3f  overdraw %.3f  overfetch %.3f\n", step.first,
+                      step.second->acmr, step.second->atvr, step.second->overdraw, step.second->overfetch);
+        text += line;
+    }
+    return text;
+}
+
+MeshOptimizationReport MeshOptimizer::Optimize(std::vector<MeshVertex> &vertices, std::vector<unsigned int> &indices,
+                                               size_t vertex_size, float overdraw_threshold)
+{
+    MeshOptimizationReport report;
+    report.triangles = indices.size() / 3;
+    report.vertices_before = vertices.size();
+    report.original = Analyze(vertices, indices, vertex_size);
+
+    OptimizeVertexCache(indices, vertices.size());
+    report.vertex_cache = Analyze(vertices, indices, vertex_size);
+
+    OptimizeOverdraw(indices, vertices, overdraw_threshold);
+    report.overdraw = Analyze(vertices, indices, vertex_size);
+
+    OptimizeVertexFetch(vertices, indices);
+    report.vertex_fetch = Analyze(vertices, indices, vertex_size);
+    report.vertices_after = vertices.size();
+    return report;
+}
+
+void MeshOptimizer::OptimizeVertexCache(std::vector<unsigned int> &indices, size_t vertex_count,
+                                        unsigned int cache_size)
+{
+    const size_t triangle_count = indices.size() / 3;
+    if (triangle_count == 0)
+        return;
+
+    // Triangles around each vertex, and how many of them are still to be emitted
+    std::vector<unsigned int> live(vertex_count, 0);
+    for (size_t i = 0; i < triangle_count * 3; ++i)
+        ++live[indices[i]];
+    std::vector<size_t> first(vertex_count + 1, 0);
+    for (size_t v = 0; v < vertex_count; ++v)
+        first[v + 1] = first[v] + live[v];
+    std::vector<unsigned int> adjacency(triangle_count * 3);
+    std::vector<size_t> fill(first.begin(), first.end() - 1);
+    for (size_t i = 0; i < triangle_count * 3; ++i)
+        adjacency[fill[indices[i]]++] = static_cast<unsigned int>(i / 3);
+
+    std::vector<unsigned int> cache_time(vertex_count, 0);
+    unsigned int time = cache_size + 1;
+    std::vector<char> emitted(triangle_count, 0);
+    std::vector<unsigned int> dead_ends;
+    std::vector<unsigned int> candidates;
+    std::vector<unsigned int> output;
+    output.reserve(triangle_count * 3);
+    size_t cursor = 0;   // where the scan for an unfinished vertex resumes
+
+    unsigned int fan = indices[0];
+    while (fan != kNoVertex)
+    {
+        // Emit every remaining triangle around the fan vertex
+        candidates.clear();
+        for (size_t a = first[fan]; a < first[fan + 1]; ++a)
+        {
+            const unsigned int triangle = adjacency[a];
+            if (emitted[triangle])
+                continue;
+            emitted[triangle] = 1;
+            for (size_t k = 0; k < 3; ++k)
+            {
+                const unsigned int v = indices[triangle * 3 + k];
+                output.push_back(v);
+                dead_ends.push_back(v);
+                candidates.push_back(v);
+                --live[v];
+                if (time - cache_time[v] > cache_size)
+                    cache_time[v] = time++;
+            }
+        }
+
+        // Next fan: among the vertices just touched, the oldest one whose
+        // remaining triangles would still find it in cache
+        fan = kNoVertex;
+        long best_priority = -1;
+        for (unsigned int v : candidates)
+        {
+            if (live[v] == 0)
+                continue;
+            long priority = 0;
+            if (time - cache_time[v] + 2 * live[v] <= cache_size)
+                priority = static_cast<long>(time - cache_time[v]);
+            if (priority > best_priority)
+            {
+                best_priority = priority;
+                fan = v;
+            }
+        }
+        if (fan != kNoVertex)
+            continue;
+
+        // Dead end: the most recent vertex with triangles left, else the next one in order
+        while (!dead_ends.empty() && fan == kNoVertex)
+        {
+            const unsigned int v = dead_ends.back();
+            dead_ends.pop_back();
+            if (live[v] > 0)
+                fan = v;
+        }
+        while (cursor < vertex_count && fan == kNoVertex)
+        {
+            if (live[cursor] > 0)
+                fan = static_cast<unsigned int>(cursor);
+            ++cursor;
+        }
+    }
+    indices.swap(output);
+}
+
+void MeshOptimizer::OptimizeOverdraw(std::vector<unsigned int> &indices, const std::vector<MeshVertex> &vertices,
+                                     float threshold, unsigned int cache_size)
+{
+    const size_t triangle_count = indices.size() / 3;
+    if (triangle_count == 0)
+        return;
+    FifoCache cache(vertices.size(), cache_size);
+    auto misses = [&](size_t triangle)
+    {
+        int count = 0;
+        for (size_t k = 0; k < 3; ++k)
+            count += cache.Miss(indices[triangle * 3 + k]) ? 1 : 0;
+        return count;
+    };
+
+    // Hard boundaries: where every distinct vertex misses, which is where the
+    // cache order jumped to a new area, so cutting there costs nothing. The
+    // first triangle always starts one, whatever it looks like.
+    std::vector<size_t> hard = {0};
+    misses(0);
+    for (size_t t = 1; t < triangle_count; ++t)
+    {
+        const unsigned int *v = &indices[t * 3];
+        const int distinct = 1 + (v[1] != v[0] ? 1 : 0) + (v[2] != v[0] && v[2] != v[1] ? 1 : 0);
+        if (misses(t) == distinct)
+            hard.push_back(t);
+    }
+    hard.push_back(triangle_count);
+
+    // Soft boundaries: each hard cluster is cut again as soon as the triangles
+    // since the last cut, drawn from an empty cache, reach `threshold` times
+    // the whole cluster's ACMR. Any order of the pieces then costs at most that.
+    std::vector<size_t> clusters;
+    for (size_t h = 0; h + 1 < hard.size(); ++h)
+    {
+        const size_t begin = hard[h];
+        const size_t end = hard[h + 1];
+        cache.Restart();
+        int cluster_misses = 0;
+        for (size_t t = begin; t < end; ++t)
+            cluster_misses += misses(t);
+        const float target = threshold * static_cast<float>(cluster_misses) / static_cast<float>(end - begin);
+
+        const size_t first_piece = clusters.size();
+        clusters.push_back(begin);
+        cache.Restart();
+        int running_misses = 0;
+        size_t running_triangles = 0;
+        for (size_t t = begin; t < end; ++t)
+        {
+            running_misses += misses(t);
+            ++running_triangles;
+            if (static_cast<float>(running_misses) <= target * static_cast<float>(running_triangles))
+            {
+                clusters.push_back(t + 1);
+                cache.Restart();
+                running_misses = 0;
+                running_triangles = 0;
+            }
+        }
+        // A cut at the very end starts nothing; a tail that never reached the
+        // target joins the piece before it
+        if (clusters.back() == end)
+            clusters.pop_back();
+        else if (running_triangles > 0 && clusters.size() - first_piece > 1)
+            clusters.pop_back();
+    }
+    clusters.push_back(triangle_count);
+
+    // Area-weighted centroid and normal of the mesh and of every cluster
+    struct Cluster
+    {
+        size_t begin;
+        size_t end;
+        float key;
+    };
+    std::vector<glm::vec3> centroids(clusters.size() - 1, glm::vec3(0.0f));
+    std::vector<glm::vec3> normals(clusters.size() - 1, glm::vec3(0.0f));
+    std::vector<float> areas(clusters.size() - 1, 0.0f);
+    glm::vec3 mesh_centroid(0.0f);
+    float mesh_area = 0.0f;
+    for (size_t c = 0; c + 1 < clusters.size(); ++c)
+    {
+        for (size_t t = clusters[c]; t < clusters[c + 1]; ++t)
+        {
+            const glm::vec3 &a = vertices[indices[t * 3]].position;
+            const glm::vec3 &b = vertices[indices[t * 3 + 1]].position;
+            const glm::vec3 &d = vertices[indices[t * 3 + 2]].position;
+            const glm::vec3 normal = glm::cross(b - a, d - a);   // twice the area, outwards for CCW
+            const float area = glm::length(normal);
+            centroids[c] += (a + b + d) * (area / 3.0f);
+            normals[c] += normal;
+            areas[c] += area;
+        }
+        mesh_centroid += centroids[c];
+        mesh_area += areas[c];
+    }
+    if (mesh_area > 0.0f)
+        mesh_centroid = mesh_centroid / mesh_area;
+
+    std::vector<Cluster> order;
+    order.reserve(clusters.size() - 1);
+    for (size_t c = 0; c + 1 < clusters.size(); ++c)
+    {
+        float key = 0.0f;
+        const float normal_length = glm::length(normals[c]);
+        if (areas[c] > 0.0f && normal_length > 0.0f)
+            key = glm::dot(centroids[c] / areas[c] - mesh_centroid, normals[c] / normal_length);
+        order.push_back(Cluster{clusters[c], clusters[c + 1], key});
+    }
+    // Clusters facing most directly away from the centre first
+    std::stable_sort(order.begin(), order.end(), [](const Cluster &a, const Cluster &b) { return a.key > b.key; });
+
+    std::vector<unsigned int> output;
+    output.reserve(triangle_count * 3);
+    for (const Cluster &cluster : order)
+        output.insert(output.end(), indices.begin() + cluster.begin * 3, indices.begin() + cluster.end * 3);
+    assert(output.size() == triangle_count * 3 && "clusters must cover every triangle");
+    indices.swap(output);
+}
+
+void MeshOptimizer::OptimizeVertexFetch(std::vector<MeshVertex> &vertices, std::vector<unsigned int> &indices)
+{
+    std::vector<unsigned int> remap(vertices.size(), kNoVertex);
+    std::vector<MeshVertex> reordered;
+    reordered.reserve(vertices.size());
+    for (unsigned int &index : indices)
+    {
+        if (remap[index] == kNoVertex)
+        {
+            remap[index] = static_cast<unsigned int>(reordered.size());
+            reordered.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+    vertices.swap(reordered);
+}
+
+MeshDrawStats MeshOptimizer::Analyze(const std::vector<MeshVertex> &vertices, const std::vector<unsigned int> &indices,
+                                     size_t vertex_size)
+{
+    MeshDrawStats stats;
+    AnalyzeVertexCache(indices, vertices.size(), stats);
+    AnalyzeOverdraw(vertices, indices, stats);
+    AnalyzeVertexFetch(indices, vertices.size(), vertex_size, stats);
+    return stats;
+}
+
+void MeshOptimizer::AnalyzeVertexCache(const std::vector<unsigned int> &indices, size_t vertex_count,
+                                       MeshDrawStats &stats, unsigned int cache_size)
+{
+    const size_t triangle_count = indices.size() / 3;
+    FifoCache cache(vertex_count, cache_size);
+    std::vector<char> referenced(vertex_count, 0);
+    size_t transformed = 0;
+    size_t unique = 0;
+    for (size_t i = 0; i < triangle_count * 3; ++i)
+    {
+        const unsigned int index = indices[i];
+        transformed += cache.Miss(index) ? 1 : 0;
+        if (!referenced[index])
+        {
+            referenced[index] = 1;
+            ++unique;
+        }
+    }
+    stats.acmr = triangle_count ? static_cast<float>(transformed) / static_cast<float>(triangle_count) : 0.0f;
+    stats.atvr = unique ? static_cast<float>(transformed) / static_cast<float>(unique) : 0.0f;
+}
+
+void MeshOptimizer::AnalyzeOverdraw(const std::vector<MeshVertex> &vertices, const std::vector<unsigned int> &indices,
+                                    MeshDrawStats &stats)
+{
+    const size_t triangle_count = indices.size() / 3;
+    Aabb bounds;
+    for (unsigned int index : indices)
+        bounds.Expand(vertices[index].position);
+    stats.overdraw = 0.0f;
+    if (triangle_count == 0)
+        return;
+
+    const float empty = std::numeric_limits<float>::infinity();
+    std::vector<float> depth(kOverdrawViewport * kOverdrawViewport);
+    size_t shaded = 0;
+    size_t covered = 0;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        // Screen x and y span the other two axes, so that x cross y points at the viewer
+        const int u = (axis + 1) % 3;
+        const int v = (axis + 2) % 3;
+        const glm::vec3 extent = bounds.max - bounds.min;
+        const float size = std::max(extent[u], extent[v]);
+        const float scale = size > 0.0f ? static_cast<float>(kOverdrawViewport) / size : 0.0f;
+        for (float side : {1.0f, -1.0f})
+        {
+            std::fill(depth.begin(), depth.end(), empty);
+            const float x_origin = side > 0.0f ? bounds.min[u] : -bounds.max[u];
+            for (size_t t = 0; t < triangle_count; ++t)
+            {
+                glm::vec3 p[3];
+                for (int k = 0; k < 3; ++k)
+                {
+                    const glm::vec3 &position = vertices[indices[t * 3 + k]].position;
+                    p[k] = glm::vec3((side * position[u] - x_origin) * scale, (position[v] - bounds.min[v]) * scale,
+                                     -side * position[axis]);
+                }
+                const float area = (p[1].x - p[0].x) * (p[2].y - p[0].y) - (p[1].y - p[0].y) * (p[2].x - p[0].x);
+                // Back faces (clockwise here) are culled, as by the renderer
+                if (area <= 0.0f)
+                    continue;
+
+                bool owns_edge[3];
+                for (int k = 0; k < 3; ++k)
+                {
+                    const glm::vec3 &a = p[(k + 1) % 3];
+                    const glm::vec3 &b = p[(k + 2) % 3];
+                    // Left edges run downwards and top edges leftwards
+                    owns_edge[k] = b.y < a.y || (b.y == a.y && b.x < a.x);
+                }
+                const int min_x = std::max(0, static_cast<int>(std::floor(std::min({p[0].x, p[1].x, p[2].x}))));
+                const int max_x = std::min(kOverdrawViewport - 1,
+                                           static_cast<int>(std::ceil(std::max({p[0].x, p[1].x, p[2].x}))));
+                const int min_y = std::max(0, static_cast<int>(std::floor(std::min({p[0].y, p[1].y, p[2].y}))));
+                const int max_y = std::min(kOverdrawViewport - 1,
+                                           static_cast<int>(std::ceil(std::max({p[0].y, p[1].y, p[2].y}))));
+                for (int y = min_y; y <= max_y; ++y)
+                {
+                    for (int x = min_x; x <= max_x; ++x)
+                    {
+                        const float cx = static_cast<float>(x) + 0.5f;
+                        const float cy = static_cast<float>(y) + 0.5f;
+                        float w[3];
+                        bool inside = true;
+                        for (int k = 0; k < 3 && inside; ++k)
+                        {
+                            // Edge opposite vertex k
+                            const glm::vec3 &a = p[(k + 1) % 3];
+                            const glm::vec3 &b = p[(k + 2) % 3];
+                            w[k] = (b.x - a.x) * (cy - a.y) - (b.y - a.y) * (cx - a.x);
+                            inside = w[k] > 0.0f || (w[k] == 0.0f && owns_edge[k]);
+                        }
+                        if (!inside)
+                            continue;
+                        const float z = (w[0] * p[0].z + w[1] * p[1].z + w[2] * p[2].z) / area;
+                        float &stored = depth[y * kOverdrawViewport + x];
+                        if (z < stored)
+                        {
+                            stored = z;
+                            ++shaded;
+                        }
+                    }
+                }
+            }
+            for (float z : depth)
+                covered += z < empty ? 1 : 0;
+        }
+    }
+    stats.overdraw = covered ? static_cast<float>(shaded) / static_cast<float>(covered) : 0.0f;
+}
+
+void MeshOptimizer::AnalyzeVertexFetch(const std::vector<unsigned int> &indices, size_t vertex_count,
+                                       size_t vertex_size, MeshDrawStats &stats)
+{
+    const size_t line_count = (vertex_count * vertex_size + kFetchLineSize - 1) / kFetchLineSize;
+    FifoCache cache(line_count, kFetchCacheLines);
+    std::vector<char> referenced(vertex_count, 0);
+    size_t fetched = 0;
+    size_t unique = 0;
+    for (unsigned int index : indices)
+    {
+        const size_t begin = index * vertex_size / kFetchLineSize;
+        const size_t end = (index * vertex_size + vertex_size - 1) / kFetchLineSize;
+        for (size_t line = begin; line <= end; ++line)
+            fetched += cache.Miss(line) ? kFetchLineSize : 0;
+        if (!referenced[index])
+        {
+            referenced[index] = 1;
+            ++unique;
+        }
+    }
+    stats.overfetch = unique ? static_cast<float>(fetched) / static_cast<float>(unique * vertex_size) : 0.0f;
+}
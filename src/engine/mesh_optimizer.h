@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "mesh.h"
+
+// How expensive an index/vertex layout is to draw, measured on the CPU so the
+// import pipeline can report and gate on it
+struct MeshDrawStats
+{
+    float acmr = 0.0f;        // vertices transformed per triangle (0.5 is the ideal for a big grid, 3 the worst)
+    float atvr = 0.0f;        // vertices transformed per vertex referenced (1 is ideal)
+    float overdraw = 0.0f;    // pixels shaded per pixel covered, back faces culled (1 is ideal)
+    float overfetch = 0.0f;   // vertex bytes fetched per vertex byte referenced (1 is ideal)
+};
+
+// The stats as imported and after each MeshOptimizer::Optimize step
+struct MeshOptimizationReport
+{
+    size_t triangles = 0;
+    size_t vertices_before = 0;
+    size_t vertices_after = 0;   // unreferenced vertices are dropped by the fetch step
+    MeshDrawStats original;
+    MeshDrawStats vertex_cache;
+    MeshDrawStats overdraw;
+    MeshDrawStats vertex_fetch;
+
+    // One line per step, for logs
+    std::string Format() const;
+};
+
+// Post-import reordering of indexed triangle lists, on CPU data only:
+//   1. vertex cache: Tipsify (Sander, Nehab & Barczak 2007), which fans around
+//      vertices still in a simulated FIFO post-transform cache;
+//   2. overdraw: the cache-ordered triangles are cut into clusters that each
+//      stay within `overdraw_threshold` of the cache efficiency, and clusters
+//      facing out from the mesh centre are drawn first so they occlude the rest;
+//   3. vertex fetch: vertices are renumbered in first-use order, so the vertex
+//      buffer is read front to back.
+// The triangles themselves (and each one's winding) never change.
+class MeshOptimizer
+{
+public:
+    // Post-transform cache entries assumed by the reordering and the stats
+    static constexpr unsigned int kVertexCacheSize = 16;
+
+    // Runs the three steps, measuring before and after each. `vertex_size`
+    // is the size of a vertex as uploaded, for the overfetch figure.
+    static MeshOptimizationReport Optimize(std::vector<MeshVertex> &vertices, std::vector<unsigned int> &indices,
+                                           size_t vertex_size = sizeof(MeshVertex), float overdraw_threshold = 1.05f);
+
+    static void OptimizeVertexCache(std::vector<unsigned int> &indices, size_t vertex_count,
+                                    unsigned int cache_size = kVertexCacheSize);
+    // Expects cache-ordered indices; reorders whole clusters of them
+    static void OptimizeOverdraw(std::vector<unsigned int> &indices, const std::vector<MeshVertex> &vertices,
+                                 float threshold = 1.05f, unsigned int cache_size = kVertexCacheSize);
+    // Renumbers vertices by first use and drops unreferenced ones
+    static void OptimizeVertexFetch(std::vector<MeshVertex> &vertices, std::vector<unsigned int> &indices);
+
+    static MeshDrawStats Analyze(const std::vector<MeshVertex> &vertices, const std::vector<unsigned int> &indices,
+                                 size_t vertex_size = sizeof(MeshVertex));
+    // Simulated FIFO post-transform cache; fills acmr and atvr
+    static void AnalyzeVertexCache(const std::vector<unsigned int> &indices, size_t vertex_count, MeshDrawStats &stats,
+                                   unsigned int cache_size = kVertexCacheSize);
+    // Rasterizes the mesh along the six axis directions at a fixed resolution; fills overdraw
+    static void AnalyzeOverdraw(const std::vector<MeshVertex> &vertices, const std::vector<unsigned int> &indices,
+                                MeshDrawStats &stats);
+    // Simulated cache of 64-byte lines over the vertex buffer; fills overfetch
+    static void AnalyzeVertexFetch(const std::vector<unsigned int> &indices, size_t vertex_count, size_t vertex_size,
+                                   MeshDrawStats &stats);
+};
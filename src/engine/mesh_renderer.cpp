@@ -1,4 +1,5 @@
 #include "mesh_renderer.h"
+#include "gl_state_cache.h"
 #include "renderer.h"
 #include "mesh_creator.h"
 #include "game_object.h"
@@ -54,6 +55,71 @@ std::shared_ptr<Mesh> MeshRenderer::CreateUnitCube()
     return g_unitCube;
 }
 
+void MeshRenderer::SetLodGroup(std::shared_ptr<LodGroup> lods)
+{
+    lod_group_ = std::move(lods);
+    lod_level_ = 0;
+    if (lod_group_)
+    {
+        mesh_ = lod_group_->Level(0).mesh;
+    }
+}
+
+glm::mat4 MeshRenderer::WorldMatrix()
+{
+    if (!cached_transform_ && Owner())
+    {
+        cached_transform_ = Owner()->GetComponent<Transform>();
+    }
+    return cached_transform_ ? cached_transform_->LocalToWorld() : glm::mat4(1.0f);
+}
+
+void MeshRenderer::SelectLod(const glm::mat4 &model, const glm::mat4 &projection, const glm::mat4 &view)
+{
+    if (lod_group_ && lod_group_->LevelCount() > 1)
+    {
+        const float screen_size = LodGroup::ScreenSize(mesh_->Bounds(), model, view, projection);
+        lod_level_ = lod_group_->Select(screen_size, lod_level_);
+    }
+}
+
+bool MeshRenderer::BuildDrawPacket(const glm::mat4 &projection, const glm::mat4 &view, DrawPacket &packet, float &view_depth)
+{
+    if (render_mode != RenderMode::Lit || !mesh_)
+        return false;
+    if (material_)
+    {
+        material_->EnsureResourcesLoaded();
+        if (auto matShader = material_->GetShader())
+        {
+            shader_ = matShader;
+        }
+    }
+    if (!shader_)
+        return false;
+
+    const glm::mat4 model = WorldMatrix();
+    SelectLod(model, projection, view);
+
+    const Texture *albedo = diffuse_texture.get();
+    if (material_ && material_->GetAlbedoTexture())
+    {
+        albedo = material_->GetAlbedoTexture().get();
+    }
+    packet.mesh = GetLodMesh().get();
+    packet.shader = shader_.get();
+    packet.albedo = albedo && albedo->is_valid() ? albedo : nullptr;
+    // Renderers without a Material sort together; their uniforms are compared by value
+    packet.material = material_.get();
+    packet.model = model;
+    packet.color = material_ ? material_->color : color;
+    packet.smoothness = material_ ? material_->smoothness : smoothness;
+    const Scene *scene = Owner() ? Owner()->GetScene() : nullptr;
+    packet.ambient = scene ? scene->GetAmbientColor() * material_ambient_multiplier : glm::vec3(0.0f);
+    view_depth = -(view * model * glm::vec4(mesh_->Bounds().Center(), 1.0f)).z;
+    return true;
+}
+
 void MeshRenderer::OnRender(Renderer &renderer, const glm::mat4 &projection, const glm::mat4 &view)
 {
     if (render_mode == RenderMode::Skybox)
@@ -65,17 +131,18 @@ void MeshRenderer::OnRender(Renderer &renderer, const glm::mat4 &projection, con
         v[3][1] = 0.0f;
         v[3][2] = 0.0f;
 
-        // Depth state for background: disable depth test for guaranteed visibility
-        GLboolean wasDepthEnabled = glIsEnabled(GL_DEPTH_TEST);
-        glDisable(GL_DEPTH_TEST);
-        glDepthMask(GL_FALSE);
-        glDepthFunc(GL_LEQUAL);
+        // Depth state for background: disable depth test for guaranteed visibility.
+        // Previous state comes from the state cache, not the driver.
+        GLStateCache &state = GLStateCache::GetInstance();
+        const bool wasDepthEnabled = state.DepthTest();
+        const bool wasDepthWrite = state.DepthWrite();
+        const GLenum oldDepthFunc = state.DepthFunc();
+        state.SetDepthTest(false);
+        state.SetDepthWrite(false);
+        state.SetDepthFunc(GL_LEQUAL);
         // Culling: disable for robustness (mesh winding might vary)
-        GLboolean wasCullEnabled = glIsEnabled(GL_CULL_FACE);
-        GLint oldCullFace = GL_BACK;
-        if (wasCullEnabled)
-            glGetIntegerv(GL_CULL_FACE_MODE, &oldCullFace);
-        glDisable(GL_CULL_FACE);
+        const bool wasCullEnabled = state.CullFace();
+        state.SetCullFace(false);
 
         // Lazy init a simple skybox shader if none provided
         if (!shader_ || shader_->id() == 0)
@@ -91,20 +158,23 @@ void MeshRenderer::OnRender(Renderer &renderer, const glm::mat4 &projection, con
         // GLM stores matrices in column-major; perspective has m[3][3] ~= 0, ortho has ~= 1
         if (glm::abs(projection[3][3] - 1.0f) < eps)
         {
-            GLint vp[4] = {0, 0, 1, 1};
-            glGetIntegerv(GL_VIEWPORT, vp);
+            const GLint *vp = state.Viewport();
             const float w = static_cast<float>(vp[2]);
             const float h = static_cast<float>(vp[3]);
             const float ar = (w > 0.0f && h > 0.0f) ? (w / h) : 1.0f;
             // Use a reasonable FOV to avoid distortion; skybox depth doesn't matter due to xyww trick
             projForSky = glm::perspective(glm::radians(60.0f), ar, 0.1f, 10.0f);
         }
-        shader_->set_mat4("uProj", projForSky);
-        shader_->set_mat4("uViewNoT", v);
+        // Names hashed at compile time: each lookup below only compares the name it lands on
+        static constexpr UniformName kProj{"uProj"};
+        static constexpr UniformName kViewNoT{"uViewNoT"};
+        static constexpr UniformName kSky{"uSky"};
+        shader_->set_mat4(shader_->location(kProj), projForSky);
+        shader_->set_mat4(shader_->location(kViewNoT), v);
         if (hasTexture)
         {
             diffuse_texture->bind(GL_TEXTURE_2D, 0);
-            shader_->set_int("uSky", 0);
+            shader_->set_int(shader_->location(kSky), 0);
         }
 
         // Use unit cube mesh if none assigned
@@ -113,70 +183,13 @@ void MeshRenderer::OnRender(Renderer &renderer, const glm::mat4 &projection, con
         box->Draw();
 
         // Restore depth/cull state
-        if (wasCullEnabled)
-        {
-            glEnable(GL_CULL_FACE);
-            glCullFace(oldCullFace);
-        }
-        else
-        {
-            glDisable(GL_CULL_FACE);
-        }
-        glDepthFunc(GL_LESS);
-        glDepthMask(GL_TRUE);
-        if (wasDepthEnabled)
-            glEnable(GL_DEPTH_TEST);
+        state.SetCullFace(wasCullEnabled);
+        state.SetDepthFunc(oldDepthFunc);
+        state.SetDepthWrite(wasDepthWrite);
+        state.SetDepthTest(wasDepthEnabled);
         return;
     }
 
-    if (!cached_transform_ && Owner())
-    {
-        cached_transform_ = Owner()->GetComponent<Transform>();
-    }
-    const Transform *t = cached_transform_;
-    glm::mat4 model = t ? t->LocalToWorld() : glm::mat4(1.0f);
-    glm::mat4 mvp = projection * view * model;
-
-    // Precompute inverse(model) for transforming directions to object space
-    const glm::mat4 invModel = glm::inverse(model);
-    // Resolve shader and textures from Material if present
-    if (material_)
-    {
-        material_->EnsureResourcesLoaded();
-        if (auto matShader = material_->GetShader())
-        {
-            shader_ = matShader;
-        }
-    }
-
-    // Bind texture (if any) to texture unit 0 and set uniforms
-    std::shared_ptr<Texture> albedoTex = diffuse_texture;
-    if (material_ && material_->GetAlbedoTexture())
-    {
-        albedoTex = material_->GetAlbedoTexture();
-    }
-
-    if (albedoTex && albedoTex->is_valid())
-    {
-        albedoTex->bind(GL_TEXTURE_2D, 0);
-        shader_->use();
-        // For Unlit mode, only uAlbedo is used; for Lit, both are used
-        shader_->set_int("uAlbedo", 0);
-        shader_->set_int("uUseTexture", 1);
-    }
-    else
-    {
-        shader_->use();
-        shader_->set_int("uUseTexture", 0);
-    }
-    // Set ambient color if Lit and Scene available
-    if (render_mode == RenderMode::Lit && Owner() && Owner()->GetScene())
-    {
-        shader_->use();
-        const glm::vec3 ambient = Owner()->GetScene()->GetAmbientColor();
-        shader_->set_vec3("uAmbient", ambient * material_ambient_multiplier);
-    }
-
     if (render_mode == RenderMode::Unlit)
     {
         std::cout << "nah" << std::endl;
@@ -189,35 +202,13 @@ void MeshRenderer::OnRender(Renderer &renderer, const glm::mat4 &projection, con
     }
     else
     {
-        // Set material uniforms expected by the lit shader
-        shader_->use();
-
-        if (renderer.use_shadows)
+        // Resolved the same way as for the render queue; camera, lights and
+        // shadow values come from the renderer's per-frame uniform block
+        DrawPacket packet;
+        float viewDepth = 0.0f;
+        if (BuildDrawPacket(projection, view, packet, viewDepth))
         {
-            const Light *shadowLight = Owner()->GetScene()->GetLights()[0];
-            glm::mat4 lightSpaceMatrix = shadowLight->GetLightSpaceMatrix();
-            shader_->set_mat4("uLightSpaceMatrix", lightSpaceMatrix);
-
-            // Bind the shadow map texture to a free texture unit (e.g., unit 1)
-            glActiveTexture(GL_TEXTURE1); // Use a different texture unit
-            glBindTexture(GL_TEXTURE_2D, renderer.GetShadowMapTexture());
-            shader_->set_int("uShadowMap", 1); // Tell shader to look at texture unit 1
-
-            // Pass shadow quality settings to shader
-            shader_->set_float("uShadowBias", renderer.shadow_settings.bias);
-            shader_->set_int("uPCFSamples", renderer.shadow_settings.pcf_samples);
-
-            // Don't forget to re-activate texture unit 0 if you use it for albedo
-            glActiveTexture(GL_TEXTURE0);
+            renderer.DrawMesh(packet, view, projection);
         }
-
-        const glm::vec3 colorToUse = material_ ? material_->color : color;
-        const float smoothnessToUse = material_ ? material_->smoothness : smoothness;
-        shader_->set_vec3("uColor", colorToUse);
-        shader_->set_float("uSmoothness", smoothnessToUse);
-        shader_->set_mat4("uModel", model);
-        shader_->set_mat4("uView", view);
-        shader_->set_mat4("uProjection", projection);
-        renderer.DrawMesh(*mesh_, *shader_);
     }
 }
@@ -6,6 +6,8 @@
 #include "texture.h"
 #include "material.h"
 #include "renderer.h"
+#include "mesh_lod.h"
+#include "render_queue.h"
 #include <glm/glm.hpp>
 #include <memory>
 
@@ -37,6 +39,9 @@ public:
     glm::vec3 light_color{1.0f, 1.0f, 1.0f};
 
     void OnRender(Renderer &renderer, const glm::mat4 &projection, const glm::mat4 &view) override;
+    // Resolves a Lit draw (picking the LOD level like OnRender) for the render
+    // queue. Returns false for renderers that must go through OnRender instead.
+    bool BuildDrawPacket(const glm::mat4 &projection, const glm::mat4 &view, DrawPacket &packet, float &view_depth);
     void OnAttach() override { cached_transform_ = nullptr; }
 
     // Optional texture used as diffuse/albedo (legacy path, prefer Material).
@@ -60,26 +65,77 @@ public:
         copy->smoothness = smoothness;
         copy->light_color = light_color;
         copy->render_mode = render_mode;
+        copy->occluder = occluder;
+        copy->is_static = is_static;
+        copy->lod_group_ = lod_group_;
+        copy->lod_level_ = lod_level_;
         return copy;
     }
 
     // Rendering mode selector (defaults to Lit)
     RenderMode render_mode = RenderMode::Lit;
 
+    // Large, solid meshes (walls, terrain, buildings) worth rasterizing into the
+    // CPU occlusion buffer when the scene has occlusion culling enabled
+    bool occluder = false;
+
+    // Never moves: the scene merges it with other static renderers sharing its
+    // material into a static batch (Scene::SetStaticBatching). Moving or editing
+    // it still works but rebuilds the batch. Ignored with a LOD group or as an occluder.
+    bool is_static = false;
+    // True while a static batch draws this renderer in its place
+    bool IsStaticBatched() const { return static_batched_; }
+
     // Helpers to set resources after default construction
-    void SetMesh(std::shared_ptr<Mesh> mesh) { mesh_ = std::move(mesh); }
+    // Replaces the mesh and drops any LOD chain
+    void SetMesh(std::shared_ptr<Mesh> mesh)
+    {
+        mesh_ = std::move(mesh);
+        lod_group_.reset();
+        lod_level_ = 0;
+    }
     void SetShader(std::shared_ptr<Shader> shader) { shader_ = std::move(shader); }
     void SetMaterial(std::shared_ptr<Material> material) { material_ = std::move(material); }
     std::shared_ptr<Mesh> GetMesh() const { return mesh_; }
     std::shared_ptr<Shader> GetShader() const { return shader_; }
     std::shared_ptr<Material> GetMaterial() const { return material_; }
 
+    // Level-of-detail chain; also sets the mesh to its full-resolution level.
+    // OnRender then picks a level per frame from the object's projected size.
+    void SetLodGroup(std::shared_ptr<LodGroup> lods);
+    std::shared_ptr<LodGroup> GetLodGroup() const { return lod_group_; }
+    size_t GetLodLevel() const { return lod_level_; }
+    // Mesh of the level picked by the last OnRender (the plain mesh without LODs);
+    // other passes, like shadows, draw this to match the main pass
+    const std::shared_ptr<Mesh> &GetLodMesh() const
+    {
+        return lod_group_ ? lod_group_->Level(lod_level_).mesh : mesh_;
+    }
+
+    // Object-space bounds of the mesh, or nullptr if this renderer is never
+    // culled: no mesh, drawn as the skybox, or a mesh with its own instance
+    // buffer (its bounds cover one instance, not all of them)
+    const Aabb *LocalBounds() const
+    {
+        if (!mesh_ || mesh_->instance_id > 0 || render_mode == RenderMode::Skybox)
+            return nullptr;
+        return &mesh_->Bounds();
+    }
+
     // Utility: create or obtain a shared unit cube mesh (internally uses MeshCreator)
     static std::shared_ptr<Mesh> CreateUnitCube();
 
 private:
+    friend class StaticBatchSystem;
+
+    glm::mat4 WorldMatrix();
+    void SelectLod(const glm::mat4 &model, const glm::mat4 &projection, const glm::mat4 &view);
+
     std::shared_ptr<Mesh> mesh_{};
     std::shared_ptr<Shader> shader_{};
     std::shared_ptr<Material> material_{};
+    std::shared_ptr<LodGroup> lod_group_{};
+    size_t lod_level_ = 0;
     Transform *cached_transform_ = nullptr;
+    bool static_batched_ = false;
 };
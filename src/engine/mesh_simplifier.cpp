@@ -0,0 +1,270 @@
+#include "mesh_simplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <tuple>
+
+namespace
+{
+// Symmetric 4x4 error quadric, area-weighted; Evaluate returns the mean squared
+// distance to the accumulated planes
+struct Quadric
+{
+    double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+    double a11 = 0, a12 = 0, a13 = 0;
+    double a22 = 0, a23 = 0;
+    double a33 = 0;
+    double weight = 0;
+
+    void AddPlane(const glm::vec3 &n, double d, double w)
+    {
+        const double nx = n.x, ny = n.y, nz = n.z;
+        a00 += w * nx * nx; a01 += w * nx * ny; a02 += w * nx * nz; a03 += w * nx * d;
+        a11 += w * ny * ny; a12 += w * ny * nz; a13 += w * ny * d;
+        a22 += w * nz * nz; a23 += w * nz * d;
+        a33 += w * d * d;
+        weight += w;
+    }
+
+    void Add(const Quadric &q)
+    {
+        a00 += q.a00; a01 += q.a01; a02 += q.a02; a03 += q.a03;
+        a11 += q.a11; a12 += q.a12; a13 += q.a13;
+        a22 += q.a22; a23 += q.a23;
+        a33 += q.a33;
+        weight += q.weight;
+    }
+
+    double Evaluate(const glm::vec3 &p) const
+    {
+        if (weight <= 0.0)
+            return 0.0;
+        const double x = p.x, y = p.y, z = p.z;
+        const double e = x * (a00 * x + 2.0 * (a01 * y + a02 * z + a03)) +
+                         y * (a11 * y + 2.0 * (a12 * z + a13)) +
+                         z * (a22 * z + 2.0 * a23) + a33;
+        return std::max(0.0, e / weight);
+    }
+};
+
+struct Collapse
+{
+    unsigned int from;
+    unsigned int to;
+    double cost;
+};
+} // namespace
+
+float MeshSimplifier::Simplify(const std::vector<MeshVertex> &vertices, const std::vector<unsigned int> &indices,
+                               size_t target_index_count, float max_error, std::vector<MeshVertex> &out_vertices,
+                               std::vector<unsigned int> &out_indices)
+{
+    const size_t vertex_count = vertices.size();
+
+    // Weld vertices that share position and UV; seams between UV islands stay split
+    std::vector<unsigned int> remap(vertex_count);
+    {
+        std::vector<unsigned int> order(vertex_count);
+        std::iota(order.begin(), order.end(), 0u);
+        auto key = [&](unsigned int i)
+        {
+            const MeshVertex &v = vertices[i];
+            return std::make_tuple(v.position.x, v.position.y, v.position.z, v.uv.x, v.uv.y);
+        };
+        std::sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b)
+        {
+            const auto ka = key(a);
+            const auto kb = key(b);
+            return ka < kb || (ka == kb && a < b);
+        });
+        for (size_t i = 0; i < vertex_count; ++i)
+        {
+            remap[order[i]] = i > 0 && key(order[i]) == key(order[i - 1]) ? remap[order[i - 1]] : order[i];
+        }
+    }
+
+    std::vector<unsigned int> triangles;
+    triangles.reserve(indices.size());
+    Aabb bounds;
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        const unsigned int a = remap[indices[i]], b = remap[indices[i + 1]], c = remap[indices[i + 2]];
+        if (a == b || b == c || c == a)
+            continue;
+        triangles.insert(triangles.end(), {a, b, c});
+        bounds.Expand(vertices[a].position);
+        bounds.Expand(vertices[b].position);
+        bounds.Expand(vertices[c].position);
+    }
+    const float diagonal = bounds.IsEmpty() ? 0.0f : glm::length(bounds.max - bounds.min);
+
+    // An edge without its reverse twin is open: a border or a UV seam
+    std::vector<uint8_t> locked(vertex_count, 0);
+    {
+        std::vector<uint64_t> edges;
+        edges.reserve(triangles.size());
+        for (size_t t = 0; t < triangles.size(); t += 3)
+        {
+            for (int e = 0; e < 3; ++e)
+                edges.push_back(uint64_t(triangles[t + e]) << 32 | triangles[t + (e + 1) % 3]);
+        }
+        std::sort(edges.begin(), edges.end());
+        for (uint64_t edge : edges)
+        {
+            const uint64_t twin = (edge << 32) | (edge >> 32);
+            if (!std::binary_search(edges.begin(), edges.end(), twin))
+            {
+                locked[edge >> 32] = 1;
+                locked[edge & 0xffffffffu] = 1;
+            }
+        }
+    }
+
+    std::vector<Quadric> quadrics(vertex_count);
+    for (size_t t = 0; t < triangles.size(); t += 3)
+    {
+        const glm::vec3 &p0 = vertices[triangles[t]].position;
+        const glm::vec3 &p1 = vertices[triangles[t + 1]].position;
+        const glm::vec3 &p2 = vertices[triangles[t + 2]].position;
+        glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+        const float length = glm::length(n);
+        if (!(length > 0.0f))
+            continue;
+        n = n / length;
+        const double d = -glm::dot(n, p0);
+        for (int k = 0; k < 3; ++k)
+            quadrics[triangles[t + k]].AddPlane(n, d, length * 0.5);
+    }
+
+    const double max_cost = double(max_error) * diagonal * double(max_error) * diagonal;
+    double worst_cost = 0.0;
+    std::vector<unsigned int> adjacency_offsets(vertex_count + 1);
+    std::vector<unsigned int> adjacency;
+    std::vector<Collapse> candidates;
+    std::vector<unsigned int> collapse_to(vertex_count);
+    std::vector<uint8_t> touched(vertex_count);
+
+    // Rejects collapses that would turn a surrounding triangle over or sharply fold it
+    auto flips = [&](unsigned int from, unsigned int to)
+    {
+        const glm::vec3 &target = vertices[to].position;
+        for (unsigned int k = adjacency_offsets[from]; k < adjacency_offsets[from + 1]; ++k)
+        {
+            const unsigned int *tri = &triangles[adjacency[k] * 3];
+            if (tri[0] == to || tri[1] == to || tri[2] == to)
+                continue;
+            glm::vec3 p[3];
+            glm::vec3 q[3];
+            for (int j = 0; j < 3; ++j)
+            {
+                p[j] = vertices[tri[j]].position;
+                q[j] = tri[j] == from ? target : p[j];
+            }
+            const glm::vec3 n0 = glm::cross(p[1] - p[0], p[2] - p[0]);
+            const glm::vec3 n1 = glm::cross(q[1] - q[0], q[2] - q[0]);
+            if (glm::dot(n0, n1) <= 0.25f * glm::length(n0) * glm::length(n1))
+                return true;
+        }
+        return false;
+    };
+
+    // Each pass collapses a batch of independent edges, cheapest first
+    while (triangles.size() > target_index_count)
+    {
+        const size_t triangle_count = triangles.size() / 3;
+        std::fill(adjacency_offsets.begin(), adjacency_offsets.end(), 0u);
+        for (unsigned int index : triangles)
+            ++adjacency_offsets[index + 1];
+        std::partial_sum(adjacency_offsets.begin(), adjacency_offsets.end(), adjacency_offsets.begin());
+        adjacency.resize(triangles.size());
+        {
+            std::vector<unsigned int> cursor(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+            for (size_t t = 0; t < triangle_count; ++t)
+            {
+                for (int k = 0; k < 3; ++k)
+                    adjacency[cursor[triangles[t * 3 + k]]++] = static_cast<unsigned int>(t);
+            }
+        }
+
+        candidates.clear();
+        for (size_t t = 0; t < triangles.size(); t += 3)
+        {
+            for (int e = 0; e < 3; ++e)
+            {
+                const unsigned int a = triangles[t + e];
+                const unsigned int b = triangles[t + (e + 1) % 3];
+                for (int dir = 0; dir < 2; ++dir)
+                {
+                    const unsigned int from = dir ? b : a;
+                    const unsigned int to = dir ? a : b;
+                    if (locked[from])
+                        continue;
+                    Quadric merged = quadrics[from];
+                    merged.Add(quadrics[to]);
+                    candidates.push_back(Collapse{from, to, merged.Evaluate(vertices[to].position)});
+                }
+            }
+        }
+        std::sort(candidates.begin(), candidates.end(), [](const Collapse &a, const Collapse &b)
+        {
+            return a.cost < b.cost;
+        });
+
+        std::iota(collapse_to.begin(), collapse_to.end(), 0u);
+        std::fill(touched.begin(), touched.end(), uint8_t(0));
+        const size_t goal = std::max<size_t>(1, (triangles.size() - target_index_count) / 3);
+        size_t removed = 0;
+        for (const Collapse &c : candidates)
+        {
+            if (c.cost > max_cost || removed >= goal)
+                break;
+            if (touched[c.from] || touched[c.to] || flips(c.from, c.to))
+                continue;
+            collapse_to[c.from] = c.to;
+            quadrics[c.to].Add(quadrics[c.from]);
+            worst_cost = std::max(worst_cost, c.cost);
+            // Everything around `from` changes shape, so it sits out the rest of the pass
+            for (unsigned int k = adjacency_offsets[c.from]; k < adjacency_offsets[c.from + 1]; ++k)
+            {
+                const unsigned int *tri = &triangles[adjacency[k] * 3];
+                touched[tri[0]] = touched[tri[1]] = touched[tri[2]] = 1;
+                if (tri[0] == c.to || tri[1] == c.to || tri[2] == c.to)
+                    ++removed;
+            }
+        }
+        if (removed == 0)
+            break;
+
+        size_t kept = 0;
+        for (size_t t = 0; t < triangles.size(); t += 3)
+        {
+            const unsigned int a = collapse_to[triangles[t]];
+            const unsigned int b = collapse_to[triangles[t + 1]];
+            const unsigned int c = collapse_to[triangles[t + 2]];
+            if (a == b || b == c || c == a)
+                continue;
+            triangles[kept++] = a;
+            triangles[kept++] = b;
+            triangles[kept++] = c;
+        }
+        triangles.resize(kept);
+    }
+
+    // Compact the surviving vertices in first-use order
+    out_vertices.clear();
+    out_indices.clear();
+    out_indices.reserve(triangles.size());
+    std::vector<unsigned int> new_index(vertex_count, ~0u);
+    for (unsigned int index : triangles)
+    {
+        if (new_index[index] == ~0u)
+        {
+            new_index[index] = static_cast<unsigned int>(out_vertices.size());
+            out_vertices.push_back(vertices[index]);
+        }
+        out_indices.push_back(new_index[index]);
+    }
+    return diagonal > 0.0f ? static_cast<float>(std::sqrt(worst_cost)) / diagonal : 0.0f;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "mesh.h"
+
+// Quadric error mesh simplification (Garland & Heckbert) by half-edge collapse:
+// a vertex is merged into one of its neighbours, so the output reuses input
+// vertices and their normals/UVs stay exact. Works on CPU data only.
+//
+// Vertices are welded by position and UV first. Edges that stay open after
+// welding (mesh borders and UV seams) are locked, so silhouettes and texture
+// islands keep their outline and seams never crack.
+class MeshSimplifier
+{
+public:
+    // Reduces `indices` towards target_index_count without moving any surface
+    // more than max_error (relative to the mesh's bounding-box diagonal).
+    // Writes the compacted result and returns the relative error reached.
+    static float Simplify(const std::vector<MeshVertex> &vertices, const std::vector<unsigned int> &indices,
+                          size_t target_index_count, float max_error, std::vector<MeshVertex> &out_vertices,
+                          std::vector<unsigned int> &out_indices);
+};
@@ -1,57 +1,143 @@
 #include "model_loader.h"
 
+#include "mesh_cache.h"
+
 #include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
+#include <cstdint>
+#include <cstring>
 #include <stdexcept>
 #include <vector>
 
-Mesh ModelLoader::LoadFirstMeshFromFile(const std::string& path, bool pre_transform_vertices)
+// Bump when FromAiMesh or MeshOptimizer change what they produce, so cached imports are redone
+static constexpr uint32_t kImporterVersion = 2;
+
+Mesh ModelLoader::LoadFirstMeshFromFile(const std::string& path, bool pre_transform_vertices, VertexFormat format,
+                                        MeshOptimizationReport* report)
 {
-    Assimp::Importer importer;
-    // Use provided flags or fallback to defaults
-    const unsigned int flags = 
-        aiProcess_Triangulate |
-        aiProcess_JoinIdenticalVertices |
-        aiProcess_ImproveCacheLocality |
-        aiProcess_GenNormals |
-        (pre_transform_vertices ? aiProcess_PreTransformVertices : 0);
-    const aiScene* scene = importer.ReadFile(path, flags);
-    if (!scene || !scene->HasMeshes())
+    std::vector<MeshOptimizationReport> reports;
+    std::vector<Mesh> meshes = Import(path, pre_transform_vertices, format, true, reports);
+    if (report)
     {
-        throw std::runtime_error("Failed to load mesh from: " + path);
+        *report = reports[0];
     }
-    aiMesh* mesh = scene->mMeshes[0];
-    return FromAiMesh(mesh);
+    return std::move(meshes[0]);
 }
 
-std::vector<Mesh> ModelLoader::LoadAllMeshesFromFile(const std::string& path, bool pre_transform_vertices)
+std::vector<Mesh> ModelLoader::LoadAllMeshesFromFile(const std::string& path, bool pre_transform_vertices,
+                                                     VertexFormat format, std::vector<MeshOptimizationReport>* reports)
 {
+    std::vector<MeshOptimizationReport> imported;
+    std::vector<Mesh> meshes = Import(path, pre_transform_vertices, format, false, imported);
+    if (reports)
+    {
+        *reports = std::move(imported);
+    }
+    return meshes;
+}
+
+std::vector<Mesh> ModelLoader::Import(const std::string& path, bool pre_transform_vertices, VertexFormat format,
+                                      bool first_mesh_only, std::vector<MeshOptimizationReport>& reports)
+{
+    const unsigned int flags = ImportFlags(pre_transform_vertices);
+    const uint64_t import_key = ImportKey(pre_transform_vertices, format, first_mesh_only);
+
+    std::vector<Mesh> result;
+    if (MeshCache::Load(path, import_key, result, &reports) && !result.empty())
+    {
+        return result;
+    }
+
     Assimp::Importer importer;
-    const unsigned int flags = 
-        aiProcess_Triangulate |
-        aiProcess_JoinIdenticalVertices |
-        aiProcess_ImproveCacheLocality |
-        aiProcess_GenNormals |
-        (pre_transform_vertices ? aiProcess_PreTransformVertices : 0);
     const aiScene* scene = importer.ReadFile(path, flags);
     if (!scene || !scene->HasMeshes())
     {
-        throw std::runtime_error("Failed to load meshes from: " + path);
+        throw std::runtime_error((first_mesh_only ? "Failed to load mesh from: " : "Failed to load meshes from: ") + path);
     }
-    std::vector<Mesh> result;
-    result.reserve(scene->mNumMeshes);
-    for (unsigned int i = 0; i < scene->mNumMeshes; ++i)
+    const unsigned int count = first_mesh_only ? 1u : scene->mNumMeshes;
+    result.clear();
+    result.reserve(count);
+    reports.assign(count, MeshOptimizationReport{});
+    for (unsigned int i = 0; i < count; ++i)
     {
         aiMesh* mesh = scene->mMeshes[i];
-        result.emplace_back(FromAiMesh(mesh));
+        result.emplace_back(FromAiMesh(mesh, format, &reports[i]));
     }
+    // A failed write only means the next start imports again
+    MeshCache::Store(path, import_key, result, reports);
     return result;
 }
 
-Mesh ModelLoader::FromAiMesh(aiMesh* mesh)
+std::shared_ptr<LodGroup> ModelLoader::LoadLodGroupFromFile(const std::string& path, const LodSettings& settings,
+                                                            bool pre_transform_vertices, VertexFormat format,
+                                                            MeshOptimizationReport* report)
+{
+    // The whole chain is cached under its own key; screen sizes are not part of
+    // it, since they are reassigned on every load
+    uint32_t lod_fields[4] = {static_cast<uint32_t>(settings.max_levels)};
+    std::memcpy(&lod_fields[1], &settings.triangle_ratio, sizeof(float));
+    std::memcpy(&lod_fields[2], &settings.max_error, sizeof(float));
+    lod_fields[3] = 0x4c4f44u;  // "LOD", so the key never matches a plain import
+    const uint64_t lod_key = MeshCache::Hash(lod_fields, sizeof(lod_fields), ImportKey(pre_transform_vertices, format, true));
+
+    std::vector<Mesh> meshes;
+    std::vector<MeshOptimizationReport> reports;
+    std::vector<float> errors;
+    if (MeshCache::Load(path, lod_key, meshes, &reports, &errors) && !meshes.empty())
+    {
+        auto group = std::make_shared<LodGroup>(std::make_shared<Mesh>(std::move(meshes[0])));
+        for (size_t i = 1; i < meshes.size(); ++i)
+        {
+            group->AddLevel(MeshLod{std::make_shared<Mesh>(std::move(meshes[i])), 0.0f, errors[i]});
+        }
+        group->AssignScreenSizes(settings.first_screen_size, settings.screen_size_ratio);
+        if (report)
+        {
+            *report = reports[0];
+        }
+        return group;
+    }
+
+    MeshOptimizationReport base_report;
+    auto base = std::make_shared<Mesh>(LoadFirstMeshFromFile(path, pre_transform_vertices, format, &base_report));
+    std::shared_ptr<LodGroup> group = LodGroup::Generate(std::move(base), settings);
+    if (report)
+    {
+        *report = base_report;
+    }
+
+    std::vector<const Mesh*> levels;
+    errors.clear();
+    for (size_t i = 0; i < group->LevelCount(); ++i)
+    {
+        levels.push_back(group->Level(i).mesh.get());
+        errors.push_back(group->Level(i).error);
+    }
+    // A failed write only means the next start simplifies again
+    MeshCache::Store(path, lod_key, levels, {base_report}, errors);
+    return group;
+}
+
+uint64_t ModelLoader::ImportKey(bool pre_transform_vertices, VertexFormat format, bool first_mesh_only)
+{
+    const uint32_t key_fields[] = {kImporterVersion, ImportFlags(pre_transform_vertices), static_cast<uint32_t>(format),
+                                   first_mesh_only ? 1u : 0u};
+    return MeshCache::Hash(key_fields, sizeof(key_fields));
+}
+
+unsigned int ModelLoader::ImportFlags(bool pre_transform_vertices)
+{
+    return aiProcess_Triangulate |
+           aiProcess_JoinIdenticalVertices |
+           aiProcess_GenNormals |
+           (pre_transform_vertices ? aiProcess_PreTransformVertices : 0);
+}
+
+Mesh ModelLoader::FromAiMesh(aiMesh* mesh, VertexFormat format, MeshOptimizationReport* report)
 {
     std::vector<MeshVertex> vertices;
     std::vector<unsigned int> indices;
+    Aabb bounds;
     vertices.reserve(mesh->mNumVertices);
     // Reserve three indices per face for triangulated meshes
     indices.reserve(mesh->mNumFaces * 3u);
@@ -60,6 +146,7 @@ Mesh ModelLoader::FromAiMesh(aiMesh* mesh)
     {
         MeshVertex v{};
         v.position = glm::vec3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
+        bounds.Expand(v.position);
         if (mesh->HasNormals())
         {
             v.normal = glm::vec3(mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z);
@@ -80,7 +167,15 @@ Mesh ModelLoader::FromAiMesh(aiMesh* mesh)
         }
     }
 
-    return Mesh(vertices, indices);
+    // Our own cache, overdraw and fetch ordering replaces aiProcess_ImproveCacheLocality
+    const size_t vertex_size = format == VertexFormat::Packed ? sizeof(PackedVertex) : sizeof(MeshVertex);
+    const MeshOptimizationReport optimized = MeshOptimizer::Optimize(vertices, indices, vertex_size);
+    if (report)
+    {
+        *report = optimized;
+    }
+
+    return Mesh(vertices, indices, bounds, format);
 }
 
 
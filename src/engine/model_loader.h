@@ -5,16 +5,39 @@
 #include <assimp/scene.h>
 #include <glm/glm.hpp>
 #include "mesh.h"
+#include "mesh_lod.h"
+#include "mesh_optimizer.h"
 
 class ModelLoader
 {
 public:
     // Optional Assimp post-process flags. If 0, sensible defaults are used internally.
-    static Mesh LoadFirstMeshFromFile(const std::string& path, bool pre_transform_vertices = false);
-    static std::vector<Mesh> LoadAllMeshesFromFile(const std::string& path, bool pre_transform_vertices = false);
+    // VertexFormat::Packed quantizes the GPU copy; see Mesh::GetQuantizationError.
+    // Every mesh goes through MeshOptimizer after import; pass `report` (one
+    // entry per mesh for LoadAllMeshesFromFile) to see what it achieved.
+    // Results are kept in MeshCache, so later loads of an unchanged file skip
+    // Assimp and the optimizer and upload from the mapped cache file.
+    static Mesh LoadFirstMeshFromFile(const std::string& path, bool pre_transform_vertices = false,
+                                      VertexFormat format = VertexFormat::Float,
+                                      MeshOptimizationReport* report = nullptr);
+    static std::vector<Mesh> LoadAllMeshesFromFile(const std::string& path, bool pre_transform_vertices = false,
+                                                   VertexFormat format = VertexFormat::Float,
+                                                   std::vector<MeshOptimizationReport>* reports = nullptr);
+    // First mesh plus a simplified LOD chain generated at import (in the same
+    // format). The chain is cached like an import, so it is only simplified once.
+    static std::shared_ptr<LodGroup> LoadLodGroupFromFile(const std::string& path, const LodSettings& settings = {},
+                                                          bool pre_transform_vertices = false,
+                                                          VertexFormat format = VertexFormat::Float,
+                                                          MeshOptimizationReport* report = nullptr);
 
 private:
-    static Mesh FromAiMesh(aiMesh* mesh);
+    // Through MeshCache; `reports` gets one entry per mesh
+    static std::vector<Mesh> Import(const std::string& path, bool pre_transform_vertices, VertexFormat format,
+                                    bool first_mesh_only, std::vector<MeshOptimizationReport>& reports);
+    static Mesh FromAiMesh(aiMesh* mesh, VertexFormat format, MeshOptimizationReport* report);
+    static unsigned int ImportFlags(bool pre_transform_vertices);
+    // MeshCache key of an import with these options
+    static uint64_t ImportKey(bool pre_transform_vertices, VertexFormat format, bool first_mesh_only);
 };
 
 
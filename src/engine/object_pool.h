@@ -0,0 +1,168 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Occupancy counters reported by ObjectPool (and the storages built on it)
+struct PoolStats
+{
+    size_t live = 0;       // objects currently allocated
+    size_t capacity = 0;   // slots backed by chunk memory
+    size_t high_water = 0; // most objects live at once since creation
+    size_t chunks = 0;
+
+    float Occupancy() const { return capacity ? static_cast<float>(live) / static_cast<float>(capacity) : 0.0f; }
+};
+
+// Slab allocator for one type. Objects are constructed in place inside fixed-size
+// chunks that are never moved, so addresses stay stable. Freed slots go on a LIFO
+// free list and are reused before the pool grows; both operations are O(1).
+// Slots are addressed by index: [0, SlotCount()) with IsAlive() marking holes.
+template <typename T>
+class ObjectPool
+{
+public:
+    static constexpr size_t kChunkCapacity = 256;
+
+    ObjectPool() = default;
+    ObjectPool(const ObjectPool &) = delete;
+    ObjectPool &operator=(const ObjectPool &) = delete;
+    ~ObjectPool() { ReleaseAll(); }
+
+    // Constructs a T in the most recently freed slot (or a new one); returns its index
+    template <typename... Args>
+    size_t Emplace(Args &&...args)
+    {
+        size_t index;
+        if (!free_.empty())
+        {
+            index = free_.back();
+            free_.pop_back();
+        }
+        else
+        {
+            index = slot_count_++;
+            if (index / kChunkCapacity == chunks_.size())
+            {
+                chunks_.push_back(std::make_unique<Chunk>());
+            }
+            alive_.push_back(0);
+            generations_.push_back(0);
+        }
+        new (Slot(index)) T(std::forward<Args>(args)...);
+        alive_[index] = 1;
+        if (++live_ > high_water_)
+        {
+            high_water_ = live_;
+        }
+        return index;
+    }
+
+    // Bumps the slot's generation so handles to the old object go stale
+    void Free(size_t index)
+    {
+        At(index).~T();
+        alive_[index] = 0;
+        ++generations_[index];
+        free_.push_back(static_cast<uint32_t>(index));
+        --live_;
+    }
+
+    // Destroys every live object (last slot first) and returns all chunk memory.
+    // Generations restart, so handles must not outlive this.
+    void ReleaseAll()
+    {
+        for (size_t i = slot_count_; i > 0; --i)
+        {
+            if (alive_[i - 1])
+            {
+                At(i - 1).~T();
+            }
+        }
+        chunks_.clear();
+        alive_.clear();
+        generations_.clear();
+        free_.clear();
+        slot_count_ = 0;
+        live_ = 0;
+    }
+
+    // Makes room for `count` more objects so the next Emplace calls never allocate chunks
+    void Reserve(size_t count)
+    {
+        const size_t reused = free_.size() < count ? free_.size() : count;
+        const size_t slots = slot_count_ + (count - reused);
+        while (chunks_.size() * kChunkCapacity < slots)
+        {
+            chunks_.push_back(std::make_unique<Chunk>());
+        }
+        if (slots > alive_.capacity())
+        {
+            // Geometric growth; the free list is sized too so later Free calls never allocate
+            const size_t capacity = slots > alive_.capacity() * 2 ? slots : alive_.capacity() * 2;
+            alive_.reserve(capacity);
+            generations_.reserve(capacity);
+            free_.reserve(capacity);
+        }
+    }
+
+    T &At(size_t index) { return *std::launder(reinterpret_cast<T *>(Slot(index))); }
+    const T &At(size_t index) const { return *std::launder(reinterpret_cast<const T *>(Slot(index))); }
+    bool IsAlive(size_t index) const { return index < slot_count_ && alive_[index] != 0; }
+    uint32_t Generation(size_t index) const { return generations_[index]; }
+
+    // The object in `index` if it is alive and still of `generation`, else nullptr
+    T *TryGet(size_t index, uint32_t generation)
+    {
+        return IsAlive(index) && generations_[index] == generation ? &At(index) : nullptr;
+    }
+
+    size_t SlotCount() const { return slot_count_; }
+    size_t Live() const { return live_; }
+
+    // Visits live objects in slot order. Safe against objects added during the walk.
+    template <typename Fn>
+    void ForEach(Fn &&fn)
+    {
+        for (size_t i = 0; i < slot_count_; ++i)
+        {
+            if (alive_[i])
+            {
+                fn(At(i));
+            }
+        }
+    }
+
+    PoolStats Stats() const
+    {
+        PoolStats stats;
+        stats.live = live_;
+        stats.capacity = chunks_.size() * kChunkCapacity;
+        stats.high_water = high_water_;
+        stats.chunks = chunks_.size();
+        return stats;
+    }
+
+private:
+    struct Chunk
+    {
+        alignas(T) unsigned char bytes[sizeof(T) * kChunkCapacity];
+    };
+
+    void *Slot(size_t index) const
+    {
+        return chunks_[index / kChunkCapacity]->bytes + (index % kChunkCapacity) * sizeof(T);
+    }
+
+    std::vector<std::unique_ptr<Chunk>> chunks_;
+    std::vector<uint8_t> alive_;
+    std::vector<uint32_t> generations_;
+    std::vector<uint32_t> free_;
+    size_t slot_count_ = 0;
+    size_t live_ = 0;
+    size_t high_water_ = 0;
+};
@@ -0,0 +1,453 @@
+#include "occlusion_buffer.h"
+#include "job_system.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define COOLGL_X86 1
+#include <immintrin.h>
+#endif
+
+// Clip-space w below this is treated as crossing the near plane
+static constexpr float kMinClipW = 1e-5f;
+static constexpr size_t kTestMinGrain = 64;
+
+// Rasterizes one pixel row of a triangle into `row` over [x0, x1] at pixel-center height y.
+// Pixel centers exactly on an edge belong to the triangle only if `owns` is set for
+// that edge (top-left rule), so shared edges leave neither cracks nor overlap.
+// Pixels whose `silhouette` entry equals `stamp` are only partly covered and are skipped.
+static void RasterizeRow(float *row, const uint32_t *silhouette, uint32_t stamp, int x0, int x1, float y,
+                         const float *a, const float *b, const float *c, const bool *owns, float z_a, float z_row,
+                         float z_max)
+{
+    const float e0_row = b[0] * y + c[0];
+    const float e1_row = b[1] * y + c[1];
+    const float e2_row = b[2] * y + c[2];
+    int x = x0 & ~3;
+#if defined(COOLGL_X86)
+    const __m128 lane = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 vz_max = _mm_set1_ps(z_max);
+    const __m128 all = _mm_castsi128_ps(_mm_set1_epi32(-1));
+    const __m128 owns0 = owns[0] ? all : zero, owns1 = owns[1] ? all : zero, owns2 = owns[2] ? all : zero;
+    const __m128i vstamp = _mm_set1_epi32(static_cast<int>(stamp));
+    auto edge_inside = [zero](__m128 e, __m128 owns_edge)
+    {
+        return _mm_or_ps(_mm_cmpgt_ps(e, zero), _mm_and_ps(_mm_cmpeq_ps(e, zero), owns_edge));
+    };
+    for (; x <= x1; x += 4)
+    {
+        const __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), lane);
+        const __m128 e0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[0]), px), _mm_set1_ps(e0_row));
+        const __m128 e1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[1]), px), _mm_set1_ps(e1_row));
+        const __m128 e2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[2]), px), _mm_set1_ps(e2_row));
+        __m128 inside = _mm_and_ps(edge_inside(e0, owns0), _mm_and_ps(edge_inside(e1, owns1), edge_inside(e2, owns2)));
+        // Lanes before x0 or after x1 belong to the neighbours' bounding boxes
+        const __m128i xi = _mm_add_epi32(_mm_set1_epi32(x), _mm_setr_epi32(0, 1, 2, 3));
+        const __m128i in_span = _mm_and_si128(_mm_cmpgt_epi32(xi, _mm_set1_epi32(x0 - 1)),
+                                              _mm_cmplt_epi32(xi, _mm_set1_epi32(x1 + 1)));
+        inside = _mm_and_ps(inside, _mm_castsi128_ps(in_span));
+        const __m128i marked = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(silhouette + x)), vstamp);
+        inside = _mm_andnot_ps(_mm_castsi128_ps(marked), inside);
+        if (_mm_movemask_ps(inside) == 0)
+            continue;
+        const __m128 z = _mm_min_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(z_a), px), _mm_set1_ps(z_row)), vz_max);
+        const __m128 old = _mm_loadu_ps(row + x);
+        const __m128 merged = _mm_min_ps(old, z);
+        _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, merged), _mm_andnot_ps(inside, old)));
+    }
+#else
+    for (x = x0; x <= x1; ++x)
+    {
+        if (silhouette[x] == stamp)
+            continue;
+        const float px = static_cast<float>(x) + 0.5f;
+        const float e0 = a[0] * px + e0_row, e1 = a[1] * px + e1_row, e2 = a[2] * px + e2_row;
+        if ((e0 > 0.0f || (e0 == 0.0f && owns[0])) && (e1 > 0.0f || (e1 == 0.0f && owns[1])) &&
+            (e2 > 0.0f || (e2 == 0.0f && owns[2])))
+        {
+            const float z = std::min(z_a * px + z_row, z_max);
+            row[x] = std::min(row[x], z);
+        }
+    }
+#endif
+}
+
+// Writes `stamp` to every pixel of `silhouette` rows [row_begin, row_end) that the segment
+// (x0, y0)-(x1, y1) touches, borders included
+static void MarkEdge(uint32_t *silhouette, int width, int row_begin, int row_end, float x0, float y0, float x1,
+                     float y1, uint32_t stamp)
+{
+    // Covers rounding in the intersections; marking a pixel too many only costs culling
+    const float pad = 1e-3f;
+    const float top = std::min(y0, y1), bottom = std::max(y0, y1);
+    const float slope = y1 != y0 ? (x1 - x0) / (y1 - y0) : 0.0f;
+    for (int y = row_begin; y < row_end; ++y)
+    {
+        const float lo = std::max(static_cast<float>(y), top);
+        const float hi = std::min(static_cast<float>(y + 1), bottom);
+        if (lo > hi)
+            continue;
+        float xa = std::min(x0, x1), xb = std::max(x0, x1);
+        if (y1 != y0)
+        {
+            xa = x0 + (lo - y0) * slope;
+            xb = x0 + (hi - y0) * slope;
+            if (xa > xb)
+                std::swap(xa, xb);
+        }
+        if (xb + pad < 0.0f || xa - pad >= static_cast<float>(width))
+            continue;
+        const float last = static_cast<float>(width - 1);
+        const int px0 = static_cast<int>(std::clamp(std::floor(xa - pad), 0.0f, last));
+        const int px1 = static_cast<int>(std::clamp(std::floor(xb + pad), 0.0f, last));
+        std::fill(silhouette + static_cast<size_t>(y) * width + px0, silhouette + static_cast<size_t>(y) * width + px1 + 1, stamp);
+    }
+}
+
+// True if any pixel of row[x0, x1] is at or behind `depth` (the box may show there)
+static bool RowHasDepthAtOrBehind(const float *row, int x0, int x1, float depth)
+{
+    int x = x0;
+#if defined(COOLGL_X86)
+    const __m128 d = _mm_set1_ps(depth);
+    for (; x + 3 <= x1; x += 4)
+    {
+        if (_mm_movemask_ps(_mm_cmpge_ps(_mm_loadu_ps(row + x), d)) != 0)
+            return true;
+    }
+#endif
+    for (; x <= x1; ++x)
+    {
+        if (row[x] >= depth)
+            return true;
+    }
+    return false;
+}
+
+OcclusionBuffer::OcclusionBuffer(int width, int height)
+{
+    Resize(width, height);
+}
+
+void OcclusionBuffer::Resize(int width, int height)
+{
+    tiles_x_ = std::max(1, (width + kTileSize - 1) / kTileSize);
+    tiles_y_ = std::max(1, (height + kTileSize - 1) / kTileSize);
+    width_ = tiles_x_ * kTileSize;
+    height_ = tiles_y_ * kTileSize;
+    depth_.assign(static_cast<size_t>(width_) * height_, 1.0f);
+    tile_max_.assign(static_cast<size_t>(tiles_x_) * tiles_y_, 1.0f);
+    silhouette_.assign(depth_.size(), 0u);
+    triangles_.clear();
+    edges_.clear();
+    occluder_ranges_.clear();
+}
+
+void OcclusionBuffer::Render(const OccluderMesh *occluders, size_t count, const glm::mat4 &view_projection, JobSystem *jobs)
+{
+    view_projection_ = view_projection;
+    triangles_.clear();
+    edges_.clear();
+    occluder_ranges_.clear();
+    for (size_t i = 0; i < count; ++i)
+    {
+        SetupTriangles(occluders[i]);
+    }
+
+    auto rasterize = [this](size_t begin, size_t end)
+    {
+        RasterizeTileRows(static_cast<int>(begin), static_cast<int>(end));
+    };
+    if (jobs)
+    {
+        // Bands of tile rows never share pixels, so workers need no synchronization
+        jobs->ParallelFor(static_cast<size_t>(tiles_y_), 1, rasterize);
+    }
+    else
+    {
+        rasterize(0, static_cast<size_t>(tiles_y_));
+    }
+}
+
+static size_t OccluderIndex(const OccluderMesh &occluder, size_t i)
+{
+    if (occluder.index_size == sizeof(uint16_t))
+        return static_cast<const uint16_t *>(occluder.indices)[i];
+    return static_cast<const unsigned int *>(occluder.indices)[i];
+}
+
+void OcclusionBuffer::SetupTriangles(const OccluderMesh &occluder)
+{
+    if (!occluder.vertices || !occluder.indices)
+        return;
+
+    // Every vertex is transformed once, then triangles are assembled from the results
+    size_t vertex_count = 0;
+    for (size_t i = 0; i < occluder.index_count; ++i)
+    {
+        vertex_count = std::max(vertex_count, OccluderIndex(occluder, i) + 1);
+    }
+    clip_scratch_.resize(vertex_count);
+    const glm::mat4 mvp = view_projection_ * occluder.model;
+    for (size_t i = 0; i < vertex_count; ++i)
+    {
+        clip_scratch_[i] = mvp * glm::vec4(occluder.vertices[i].position, 1.0f);
+    }
+
+    // Vertices split only for normals or UVs count as one in the silhouette
+    // search, so seams are not mistaken for silhouette edges
+    std::vector<uint32_t> &order = weld_order_scratch_;
+    order.resize(vertex_count);
+    std::iota(order.begin(), order.end(), 0u);
+    auto position_less = [&occluder](uint32_t l, uint32_t r)
+    {
+        const glm::vec3 &a = occluder.vertices[l].position, &b = occluder.vertices[r].position;
+        return a.x != b.x ? a.x < b.x : a.y != b.y ? a.y < b.y : a.z < b.z;
+    };
+    std::sort(order.begin(), order.end(), position_less);
+    weld_scratch_.resize(vertex_count);
+    for (size_t i = 0; i < vertex_count; ++i)
+    {
+        const bool same = i > 0 && !position_less(order[i - 1], order[i]);
+        weld_scratch_[order[i]] = same ? weld_scratch_[order[i - 1]] : order[i];
+    }
+
+    OccluderRange range;
+    range.triangle_begin = triangles_.size();
+    range.edge_begin = edges_.size();
+    edge_scratch_.clear();
+
+    const float half_w = 0.5f * static_cast<float>(width_);
+    const float half_h = 0.5f * static_cast<float>(height_);
+    for (size_t i = 0; i + 2 < occluder.index_count; i += 3)
+    {
+        glm::vec3 v[3];
+        uint32_t id[3];
+        bool behind = false;
+        for (int k = 0; k < 3; ++k)
+        {
+            id[k] = weld_scratch_[OccluderIndex(occluder, i + k)];
+            const glm::vec4 &c = clip_scratch_[id[k]];
+            if (c.w < kMinClipW)
+            {
+                behind = true;
+                break;
+            }
+            const float inv_w = 1.0f / c.w;
+            v[k] = glm::vec3((c.x * inv_w + 1.0f) * half_w, (c.y * inv_w + 1.0f) * half_h, c.z * inv_w * 0.5f + 0.5f);
+        }
+        if (behind)
+            continue;
+
+        float det = (v[1].x - v[0].x) * (v[2].y - v[0].y) - (v[2].x - v[0].x) * (v[1].y - v[0].y);
+        if (std::abs(det) < 1e-8f)
+            continue;
+        const bool front = det > 0.0f;
+        if (!front)
+        {
+            std::swap(v[1], v[2]);
+            std::swap(id[1], id[2]);
+            det = -det;
+        }
+
+        ScreenTriangle tri;
+        tri.min_x = std::max(0, static_cast<int>(std::floor(std::min({v[0].x, v[1].x, v[2].x}))));
+        tri.max_x = std::min(width_ - 1, static_cast<int>(std::ceil(std::max({v[0].x, v[1].x, v[2].x}))));
+        tri.min_y = std::max(0, static_cast<int>(std::floor(std::min({v[0].y, v[1].y, v[2].y}))));
+        tri.max_y = std::min(height_ - 1, static_cast<int>(std::ceil(std::max({v[0].y, v[1].y, v[2].y}))));
+        tri.z_max = std::max({v[0].z, v[1].z, v[2].z});
+        if (tri.min_x > tri.max_x || tri.min_y > tri.max_y || std::min({v[0].z, v[1].z, v[2].z}) > 1.0f)
+            continue;
+
+        for (int k = 0; k < 3; ++k)
+        {
+            const glm::vec3 &p = v[k];
+            const glm::vec3 &q = v[(k + 1) % 3];
+            tri.edge_a[k] = p.y - q.y;
+            tri.edge_b[k] = q.x - p.x;
+            tri.edge_c[k] = p.x * q.y - p.y * q.x;
+            // Left edges run downwards and top edges leftwards (counter-clockwise, y up)
+            tri.owns_edge[k] = tri.edge_a[k] > 0.0f || (tri.edge_a[k] == 0.0f && tri.edge_b[k] < 0.0f);
+
+            const uint32_t lo = std::min(id[k], id[(k + 1) % 3]), hi = std::max(id[k], id[(k + 1) % 3]);
+            edge_scratch_.push_back({(static_cast<uint64_t>(hi) << 32) | lo, front, glm::vec2(p.x, p.y), glm::vec2(q.x, q.y)});
+        }
+        const float dz1 = v[1].z - v[0].z, dz2 = v[2].z - v[0].z;
+        tri.z_a = (dz1 * (v[2].y - v[0].y) - dz2 * (v[1].y - v[0].y)) / det;
+        tri.z_b = (dz2 * (v[1].x - v[0].x) - dz1 * (v[2].x - v[0].x)) / det;
+        // Sampled at pixel centers; the offset moves each sample to the pixel's far corner
+        tri.z_c = v[0].z - tri.z_a * v[0].x - tri.z_b * v[0].y + 0.5f * (std::abs(tri.z_a) + std::abs(tri.z_b));
+        triangles_.push_back(tri);
+    }
+
+    // An edge is inside the occluder's screen footprint only if exactly two of
+    // the triangles drawn share it and both face the same way; every other edge
+    // may border uncovered screen
+    std::sort(edge_scratch_.begin(), edge_scratch_.end(),
+              [](const SetupEdge &l, const SetupEdge &r) { return l.key < r.key; });
+    for (size_t i = 0; i < edge_scratch_.size();)
+    {
+        size_t end = i + 1;
+        while (end < edge_scratch_.size() && edge_scratch_[end].key == edge_scratch_[i].key)
+            ++end;
+        const bool interior = end - i == 2 && edge_scratch_[i].front == edge_scratch_[i + 1].front;
+        if (!interior)
+        {
+            const SetupEdge &e = edge_scratch_[i];
+            SilhouetteEdge edge;
+            edge.x0 = e.p.x;
+            edge.y0 = e.p.y;
+            edge.x1 = e.q.x;
+            edge.y1 = e.q.y;
+            // Rows whose closed pixel span [y, y + 1] meets the edge
+            const float top = std::min(e.p.y, e.q.y), bottom = std::max(e.p.y, e.q.y);
+            edge.min_row = static_cast<int>(std::clamp(std::ceil(top) - 1.0f, 0.0f, static_cast<float>(height_)));
+            edge.max_row = static_cast<int>(std::clamp(std::floor(bottom), -1.0f, static_cast<float>(height_ - 1)));
+            if (edge.min_row <= edge.max_row)
+                edges_.push_back(edge);
+        }
+        i = end;
+    }
+
+    range.triangle_end = triangles_.size();
+    range.edge_end = edges_.size();
+    if (range.triangle_end > range.triangle_begin)
+        occluder_ranges_.push_back(range);
+}
+
+void OcclusionBuffer::RasterizeTileRows(int tile_row_begin, int tile_row_end)
+{
+    const int y_begin = tile_row_begin * kTileSize;
+    const int y_end = tile_row_end * kTileSize;
+    std::fill(depth_.begin() + static_cast<size_t>(y_begin) * width_, depth_.begin() + static_cast<size_t>(y_end) * width_, 1.0f);
+    std::fill(silhouette_.begin() + static_cast<size_t>(y_begin) * width_,
+              silhouette_.begin() + static_cast<size_t>(y_end) * width_, 0u);
+
+    // One occluder at a time: its silhouette is marked first, so its triangles
+    // skip the pixels it covers only in part. Other occluders do not mask it.
+    for (size_t o = 0; o < occluder_ranges_.size(); ++o)
+    {
+        const OccluderRange &range = occluder_ranges_[o];
+        const uint32_t stamp = static_cast<uint32_t>(o + 1);
+        for (size_t e = range.edge_begin; e < range.edge_end; ++e)
+        {
+            const SilhouetteEdge &edge = edges_[e];
+            const int y0 = std::max(edge.min_row, y_begin);
+            const int y1 = std::min(edge.max_row + 1, y_end);
+            if (y0 < y1)
+                MarkEdge(silhouette_.data(), width_, y0, y1, edge.x0, edge.y0, edge.x1, edge.y1, stamp);
+        }
+        for (size_t t = range.triangle_begin; t < range.triangle_end; ++t)
+        {
+            const ScreenTriangle &tri = triangles_[t];
+            const int y0 = std::max(tri.min_y, y_begin);
+            const int y1 = std::min(tri.max_y, y_end - 1);
+            for (int y = y0; y <= y1; ++y)
+            {
+                const float py = static_cast<float>(y) + 0.5f;
+                const size_t offset = static_cast<size_t>(y) * width_;
+                RasterizeRow(depth_.data() + offset, silhouette_.data() + offset, stamp, tri.min_x, tri.max_x, py,
+                             tri.edge_a, tri.edge_b, tri.edge_c, tri.owns_edge, tri.z_a, tri.z_b * py + tri.z_c,
+                             tri.z_max);
+            }
+        }
+    }
+
+    // Farthest depth per tile, for whole-tile rejection in IsOccluded
+    for (int ty = tile_row_begin; ty < tile_row_end; ++ty)
+    {
+        for (int tx = 0; tx < tiles_x_; ++tx)
+        {
+            float farthest = 0.0f;
+            for (int y = ty * kTileSize; y < (ty + 1) * kTileSize; ++y)
+            {
+                const float *row = depth_.data() + static_cast<size_t>(y) * width_ + tx * kTileSize;
+                for (int x = 0; x < kTileSize; ++x)
+                {
+                    farthest = std::max(farthest, row[x]);
+                }
+            }
+            tile_max_[static_cast<size_t>(ty) * tiles_x_ + tx] = farthest;
+        }
+    }
+}
+
+bool OcclusionBuffer::IsOccluded(const Aabb &box) const
+{
+    if (triangles_.empty() || box.IsEmpty())
+        return false;
+
+    float min_x = 1e30f, min_y = 1e30f, max_x = -1e30f, max_y = -1e30f, nearest = 1e30f;
+    for (int i = 0; i < 8; ++i)
+    {
+        const glm::vec4 corner((i & 1) ? box.max.x : box.min.x, (i & 2) ? box.max.y : box.min.y,
+                               (i & 4) ? box.max.z : box.min.z, 1.0f);
+        const glm::vec4 c = view_projection_ * corner;
+        if (c.w < kMinClipW)
+            return false;
+        const float inv_w = 1.0f / c.w;
+        const float x = (c.x * inv_w + 1.0f) * 0.5f * static_cast<float>(width_);
+        const float y = (c.y * inv_w + 1.0f) * 0.5f * static_cast<float>(height_);
+        min_x = std::min(min_x, x);
+        max_x = std::max(max_x, x);
+        min_y = std::min(min_y, y);
+        max_y = std::max(max_y, y);
+        nearest = std::min(nearest, c.z * inv_w * 0.5f + 0.5f);
+    }
+    if (nearest <= 0.0f)
+        return false;
+    // Off-screen boxes are the frustum test's business
+    if (max_x < 0.0f || max_y < 0.0f || min_x >= static_cast<float>(width_) || min_y >= static_cast<float>(height_))
+        return false;
+
+    const int x0 = std::max(0, static_cast<int>(std::floor(min_x)));
+    const int x1 = std::min(width_ - 1, static_cast<int>(std::floor(max_x)));
+    const int y0 = std::max(0, static_cast<int>(std::floor(min_y)));
+    const int y1 = std::min(height_ - 1, static_cast<int>(std::floor(max_y)));
+    for (int ty = y0 / kTileSize; ty <= y1 / kTileSize; ++ty)
+    {
+        for (int tx = x0 / kTileSize; tx <= x1 / kTileSize; ++tx)
+        {
+            if (tile_max_[static_cast<size_t>(ty) * tiles_x_ + tx] < nearest)
+                continue;
+            const int px0 = std::max(x0, tx * kTileSize);
+            const int px1 = std::min(x1, tx * kTileSize + kTileSize - 1);
+            const int py0 = std::max(y0, ty * kTileSize);
+            const int py1 = std::min(y1, ty * kTileSize + kTileSize - 1);
+            for (int y = py0; y <= py1; ++y)
+            {
+                if (RowHasDepthAtOrBehind(depth_.data() + static_cast<size_t>(y) * width_, px0, px1, nearest))
+                    return false;
+            }
+        }
+    }
+    return true;
+}
+
+size_t OcclusionBuffer::TestBoxes(const Aabb *boxes, size_t count, uint8_t *occluded, JobSystem *jobs) const
+{
+    auto test_range = [this, boxes, occluded](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            occluded[i] = IsOccluded(boxes[i]) ? 1 : 0;
+        }
+    };
+    if (jobs)
+    {
+        jobs->ParallelFor(count, kTestMinGrain, test_range);
+    }
+    else
+    {
+        test_range(0, count);
+    }
+    size_t hidden = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        hidden += occluded[i];
+    }
+    return hidden;
+}
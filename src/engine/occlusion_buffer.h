@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "bounds.h"
+#include "mesh.h"
+
+class JobSystem;
+
+// One occluder to rasterize: indexed triangles in object space plus their model matrix.
+// Only CPU data is read, so this works without a GL context.
+struct OccluderMesh
+{
+    const MeshVertex *vertices = nullptr;
+    const void *indices = nullptr;
+    size_t index_count = 0;
+    size_t index_size = sizeof(unsigned int);   // bytes per index: 2 or 4, as in MeshIndices
+    glm::mat4 model{1.0f};
+};
+
+// Low-resolution software depth buffer for occlusion culling. Occluder triangles
+// are rasterized on the CPU (four pixels per SSE step, one job per band of tile
+// rows) and each 8x8 tile keeps the farthest depth it holds, so most box tests
+// are answered from the tile level without touching pixels.
+//
+// Everything errs towards "visible": a pixel is written only if its center is
+// inside an occluder and none of the occluder's silhouette edges (edges of one
+// triangle, or between a front- and a back-facing one) touches it, so pixels an
+// occluder covers only in part stay empty. Occluder depths are pushed to the
+// far end of each pixel, triangles crossing the near plane are dropped as
+// occluders, and boxes crossing it are never reported hidden.
+class OcclusionBuffer
+{
+public:
+    static constexpr int kTileSize = 8;
+
+    // Dimensions are rounded up to whole tiles
+    explicit OcclusionBuffer(int width = 256, int height = 128);
+    void Resize(int width, int height);
+
+    // Clears the buffer and rasterizes `count` occluders as seen through view_projection
+    void Render(const OccluderMesh *occluders, size_t count, const glm::mat4 &view_projection, JobSystem *jobs = nullptr);
+
+    // True if `box` (world space) is certainly hidden by the last Render's occluders
+    bool IsOccluded(const Aabb &box) const;
+    // Writes 1 to occluded[i] for every hidden box; returns how many were hidden
+    size_t TestBoxes(const Aabb *boxes, size_t count, uint8_t *occluded, JobSystem *jobs = nullptr) const;
+
+    int Width() const { return width_; }
+    int Height() const { return height_; }
+    // Row-major depth in [0, 1] (1 = far/empty), bottom row first like GL
+    const float *Depth() const { return depth_.data(); }
+    // Triangles that reached the rasterizer in the last Render
+    size_t TriangleCount() const { return triangles_.size(); }
+
+private:
+    struct ScreenTriangle
+    {
+        // Edge functions e(x, y) = a * x + b * y + c, positive inside
+        float edge_a[3], edge_b[3], edge_c[3];
+        bool owns_edge[3];
+        // Depth plane, already offset to the far corner of each pixel
+        float z_a, z_b, z_c, z_max;
+        int min_x, max_x, min_y, max_y;
+    };
+    struct SilhouetteEdge
+    {
+        float x0, y0, x1, y1;
+        int min_row, max_row;
+    };
+    // Triangles and silhouette edges of one occluder, as ranges into triangles_ and edges_
+    struct OccluderRange
+    {
+        size_t triangle_begin, triangle_end;
+        size_t edge_begin, edge_end;
+    };
+    // Per occluder edge while looking for the silhouette; vertices are welded by position
+    struct SetupEdge
+    {
+        uint64_t key;
+        bool front;
+        glm::vec2 p, q;
+    };
+
+    void SetupTriangles(const OccluderMesh &occluder);
+    void RasterizeTileRows(int tile_row_begin, int tile_row_end);
+
+    int width_ = 0;
+    int height_ = 0;
+    int tiles_x_ = 0;
+    int tiles_y_ = 0;
+    glm::mat4 view_projection_{1.0f};
+    std::vector<float> depth_;
+    std::vector<float> tile_max_;
+    // Pixels a silhouette edge touches hold that occluder's range index + 1
+    std::vector<uint32_t> silhouette_;
+    std::vector<ScreenTriangle> triangles_;
+    std::vector<SilhouetteEdge> edges_;
+    std::vector<OccluderRange> occluder_ranges_;
+    std::vector<glm::vec4> clip_scratch_;
+    std::vector<uint32_t> weld_order_scratch_;
+    std::vector<uint32_t> weld_scratch_;
+    std::vector<SetupEdge> edge_scratch_;
+};
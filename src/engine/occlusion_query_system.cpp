@@ -0,0 +1,167 @@
+#include "occlusion_query_system.h"
+#include "culling_system.h"
+#include "renderer.h"
+
+// A box poking through the near plane has its closest faces clipped away, so its
+// query can come back empty while the object is right in front of the camera
+static bool CrossesNearPlane(const Aabb &box, const glm::mat4 &view_projection)
+{
+    for (int corner = 0; corner < 8; ++corner)
+    {
+        const glm::vec4 p(corner & 1 ? box.max.x : box.min.x, corner & 2 ? box.max.y : box.min.y,
+                          corner & 4 ? box.max.z : box.min.z, 1.0f);
+        const glm::vec4 clip = view_projection * p;
+        if (clip.w <= 0.0f || clip.z < -clip.w)
+            return true;
+    }
+    return false;
+}
+
+void OcclusionQuerySystem::Render(Renderer &renderer, ComponentStorage<MeshRenderer> &renderers,
+                                  const std::vector<uint32_t> &visible_slots, const CullingSystem &culling,
+                                  const glm::mat4 &projection, const glm::mat4 &view)
+{
+    stats_ = OcclusionQueryStats{};
+    ++frame_;
+    if (states_.size() < renderers.SlotCount())
+    {
+        states_.resize(renderers.SlotCount());
+    }
+    CollectResults(renderer);
+
+    // Visible last time: draw now, so the depth buffer is filled before the box queries
+    const glm::mat4 view_projection = projection * view;
+    hidden_slots_.clear();
+    for (uint32_t slot : visible_slots)
+    {
+        SlotState &state = states_[slot];
+        const uint32_t generation = renderers.Generation(slot);
+        if (state.generation != generation || state.last_frame + 1 != frame_)
+        {
+            // New, or back in the frustum: assume visible until a query says otherwise
+            state.generation = generation;
+            state.query = 0;
+            state.visible = true;
+            state.drawn_conditionally = false;
+            state.next_test_frame = frame_;
+        }
+        state.last_frame = frame_;
+
+        MeshRenderer &mesh_renderer = renderers.At(slot);
+        const Aabb *bounds = culling.SlotBounds(slot);
+        if (!state.visible && bounds && !CrossesNearPlane(*bounds, view_projection))
+        {
+            hidden_slots_.push_back(slot);
+            continue;
+        }
+
+        state.visible = true;
+        ++stats_.drawn;
+        if (bounds && state.query == 0 && frame_ >= state.next_test_frame)
+        {
+            BeginQuery(slot, renderer);
+            mesh_renderer.OnRender(renderer, projection, view);
+            glEndQuery(GL_ANY_SAMPLES_PASSED);
+        }
+        else
+        {
+            mesh_renderer.OnRender(renderer, projection, view);
+        }
+    }
+    stats_.hidden = hidden_slots_.size();
+
+    if (!hidden_slots_.empty())
+    {
+        // Hidden last time: test the box, unless the previous test is still in
+        // flight. Only the slots tested now stay in hidden_slots_: a conditional
+        // draw keyed to an older query would follow a stale result, so the others
+        // are skipped this frame.
+        renderer.BeginOcclusionBoxes(view_projection);
+        size_t tested = 0;
+        for (uint32_t slot : hidden_slots_)
+        {
+            if (states_[slot].query != 0)
+                continue;
+            BeginQuery(slot, renderer);
+            renderer.DrawOcclusionBox(*culling.SlotBounds(slot));
+            glEndQuery(GL_ANY_SAMPLES_PASSED);
+            hidden_slots_[tested++] = slot;
+        }
+        renderer.EndOcclusionBoxes();
+        hidden_slots_.resize(tested);
+
+        if (conditional_render_)
+        {
+            for (uint32_t slot : hidden_slots_)
+            {
+                states_[slot].drawn_conditionally = true;
+                glBeginConditionalRender(states_[slot].query, GL_QUERY_WAIT);
+                renderers.At(slot).OnRender(renderer, projection, view);
+                glEndConditionalRender();
+            }
+            stats_.conditional_draws = hidden_slots_.size();
+        }
+    }
+
+    stats_.queries_pending = pending_.size();
+    stats_.pool_size = renderer.GetQueryPool().Size();
+}
+
+void OcclusionQuerySystem::CollectResults(Renderer &renderer)
+{
+    size_t kept = 0;
+    for (size_t i = 0; i < pending_.size(); ++i)
+    {
+        const PendingQuery pending = pending_[i];
+        GLuint available = GL_FALSE;
+        glGetQueryObjectuiv(pending.query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+        {
+            pending_[kept++] = pending;
+            continue;
+        }
+
+        // Results for slots that were reset or reused since are dropped
+        if (pending.slot < states_.size())
+        {
+            SlotState &state = states_[pending.slot];
+            if (state.query == pending.query && state.generation == pending.generation)
+            {
+                GLuint any_samples = GL_FALSE;
+                glGetQueryObjectuiv(pending.query, GL_QUERY_RESULT, &any_samples);
+                state.visible = any_samples != GL_FALSE;
+                state.query = 0;
+                if (state.drawn_conditionally && state.visible)
+                {
+                    ++stats_.conditional_passed;
+                }
+                if (state.visible)
+                {
+                    state.next_test_frame = NextTestFrame(pending.slot);
+                }
+                ++stats_.results_read;
+            }
+        }
+        renderer.GetQueryPool().Release(pending.query);
+    }
+    pending_.resize(kept);
+}
+
+void OcclusionQuerySystem::BeginQuery(uint32_t slot, Renderer &renderer)
+{
+    SlotState &state = states_[slot];
+    state.query = renderer.GetQueryPool().Acquire();
+    state.drawn_conditionally = false;
+    pending_.push_back(PendingQuery{state.query, slot, state.generation});
+    ++stats_.queries_issued;
+    glBeginQuery(GL_ANY_SAMPLES_PASSED, state.query);
+}
+
+uint32_t OcclusionQuerySystem::NextTestFrame(uint32_t slot) const
+{
+    // Hashing slot and frame staggers the re-tests so objects that became
+    // visible together do not all query on the same frame again
+    uint32_t h = slot * 0x9E3779B1u ^ frame_ * 0x85EBCA77u;
+    h ^= h >> 15;
+    return frame_ + visible_interval_ - (visible_interval_ > 1 ? h % (visible_interval_ / 2 + 1) : 0);
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include "component_storage.h"
+#include "mesh_renderer.h"
+
+class CullingSystem;
+class Renderer;
+
+// What the last OcclusionQuerySystem::Render did
+struct OcclusionQueryStats
+{
+    size_t drawn = 0;            // renderers drawn unconditionally (visible last time)
+    size_t hidden = 0;           // renderers hidden last time: box-tested instead of drawn
+    size_t queries_issued = 0;   // queries begun this frame, on geometry or on boxes
+    size_t queries_pending = 0;  // queries still waiting for the GPU after this frame
+    size_t results_read = 0;     // results that arrived and updated visibility
+    size_t conditional_draws = 0;   // hidden renderers box-tested this frame and drawn under that test
+    size_t conditional_passed = 0;  // results read for conditionally drawn renderers that passed,
+                                    // i.e. draws the GPU actually carried out (in earlier frames)
+    size_t pool_size = 0;        // query objects the renderer's pool has ever created
+};
+
+// GPU occlusion culling with hardware occlusion queries and the temporal
+// coherence of CHC++: visibility from the previous result decides what is drawn,
+// and results are only ever read once GL_QUERY_RESULT_AVAILABLE says so, so the
+// CPU never waits on the GPU.
+//
+// Each frame, among the frustum-visible renderers:
+// - visible ones are drawn, and every few frames (jittered per object so the
+//   queries spread out) the draw itself is wrapped in a query;
+// - hidden ones get a bounding-box query once the visible ones have filled the
+//   depth buffer, and, with conditional rendering, are drawn under that query
+//   so an object coming into view does not pop in a frame late. The draw uses
+//   GL_QUERY_WAIT: the query was issued just before, so with NO_WAIT drivers
+//   would nearly always find it pending and draw anyway. The wait is on the GPU
+//   only, for a box query it has just been given; the CPU never blocks. A
+//   hidden object whose previous box query is still in flight gets no new
+//   query and no conditional draw that frame.
+class OcclusionQuerySystem
+{
+public:
+    // `visible_slots` is the frustum-culled list from `culling`'s last Cull
+    void Render(Renderer &renderer, ComponentStorage<MeshRenderer> &renderers, const std::vector<uint32_t> &visible_slots,
+                const CullingSystem &culling, const glm::mat4 &projection, const glm::mat4 &view);
+
+    // Forgets all visibility; queries still in flight are recycled as they complete
+    void Invalidate() { states_.clear(); }
+
+    // Frames between re-tests of a visible object (at least 1)
+    void SetVisibleInterval(uint32_t frames) { visible_interval_ = frames > 0 ? frames : 1; }
+    void SetConditionalRender(bool enabled) { conditional_render_ = enabled; }
+
+    const OcclusionQueryStats &LastStats() const { return stats_; }
+
+private:
+    struct SlotState
+    {
+        uint32_t generation = 0;
+        uint32_t last_frame = 0;       // last frame the slot was frustum-visible
+        uint32_t next_test_frame = 0;  // visible objects are re-tested from this frame on
+        GLuint query = 0;              // query in flight for this slot, or 0
+        bool visible = true;
+        bool drawn_conditionally = false;  // drawn under `query` with conditional render
+    };
+
+    struct PendingQuery
+    {
+        GLuint query;
+        uint32_t slot;
+        uint32_t generation;
+    };
+
+    void CollectResults(Renderer &renderer);
+    void BeginQuery(uint32_t slot, Renderer &renderer);
+    uint32_t NextTestFrame(uint32_t slot) const;
+
+    uint32_t frame_ = 0;
+    uint32_t visible_interval_ = 8;
+    bool conditional_render_ = true;
+    std::vector<SlotState> states_;
+    std::vector<PendingQuery> pending_;
+    std::vector<uint32_t> hidden_slots_;
+    OcclusionQueryStats stats_;
+};
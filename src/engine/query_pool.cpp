@@ -0,0 +1,42 @@
+#include "query_pool.h"
+#include <utility>
+
+QueryPool::QueryPool(QueryPool &&other) noexcept
+    : all_(std::move(other.all_)), free_(std::move(other.free_))
+{
+    other.all_.clear();
+    other.free_.clear();
+}
+
+QueryPool &QueryPool::operator=(QueryPool &&other) noexcept
+{
+    if (this != &other)
+    {
+        all_.swap(other.all_);
+        free_.swap(other.free_);
+    }
+    return *this;
+}
+
+QueryPool::~QueryPool()
+{
+    if (!all_.empty())
+    {
+        glDeleteQueries(static_cast<GLsizei>(all_.size()), all_.data());
+    }
+}
+
+GLuint QueryPool::Acquire()
+{
+    if (free_.empty())
+    {
+        const size_t first = all_.size();
+        all_.resize(first + kBatchSize);
+        glGenQueries(static_cast<GLsizei>(kBatchSize), all_.data() + first);
+        // Hand out the lowest names first
+        free_.assign(all_.rbegin(), all_.rbegin() + kBatchSize);
+    }
+    const GLuint query = free_.back();
+    free_.pop_back();
+    return query;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include <glad/glad.h>
+
+// Recycles GL query objects across frames. Names are generated in batches and
+// handed back with Release once their result has been read, so steady-state
+// frames never call glGenQueries. All names are deleted with the pool.
+class QueryPool
+{
+public:
+    QueryPool() = default;
+    QueryPool(const QueryPool &) = delete;
+    QueryPool &operator=(const QueryPool &) = delete;
+    QueryPool(QueryPool &&other) noexcept;
+    QueryPool &operator=(QueryPool &&other) noexcept;
+    ~QueryPool();
+
+    GLuint Acquire();
+    void Release(GLuint query) { free_.push_back(query); }
+
+    // Names ever generated, and how many are currently checked out
+    size_t Size() const { return all_.size(); }
+    size_t InUse() const { return all_.size() - free_.size(); }
+
+private:
+    static constexpr size_t kBatchSize = 64;
+
+    std::vector<GLuint> all_;
+    std::vector<GLuint> free_;
+};
@@ -0,0 +1,72 @@
+#include "render_queue.h"
+
+#include <algorithm>
+#include <cstring>
+
+void RenderQueue::Clear()
+{
+    packets_.clear();
+    keys_.clear();
+    order_.clear();
+    shader_ids_.clear();
+    material_ids_.clear();
+    texture_ids_.clear();
+    mesh_ids_.clear();
+}
+
+void RenderQueue::Push(const DrawPacket &packet, float view_depth, Pass pass)
+{
+    const uint64_t key = uint64_t(pass) << 62 |
+                         uint64_t(IdOf(shader_ids_, packet.shader)) << 50 |
+                         uint64_t(IdOf(material_ids_, packet.material)) << 38 |
+                         uint64_t(IdOf(texture_ids_, packet.albedo)) << 26 |
+                         uint64_t(IdOf(mesh_ids_, packet.mesh)) << 14 |
+                         DepthBits(view_depth);
+    order_.push_back(static_cast<uint32_t>(packets_.size()));
+    packets_.push_back(packet);
+    keys_.push_back(key);
+}
+
+void RenderQueue::Sort()
+{
+    const size_t count = order_.size();
+    scratch_.resize(count);
+    for (int shift = 0; shift < 64; shift += 8)
+    {
+        size_t histogram[256] = {};
+        for (uint32_t index : order_)
+            ++histogram[(keys_[index] >> shift) & 0xff];
+        // One bucket holding everything: this digit cannot reorder anything
+        if (std::find(std::begin(histogram), std::end(histogram), count) != std::end(histogram))
+            continue;
+
+        size_t offset = 0;
+        for (size_t &bucket : histogram)
+        {
+            const size_t size = bucket;
+            bucket = offset;
+            offset += size;
+        }
+        for (uint32_t index : order_)
+            scratch_[histogram[(keys_[index] >> shift) & 0xff]++] = index;
+        order_.swap(scratch_);
+    }
+}
+
+uint32_t RenderQueue::IdOf(std::unordered_map<const void *, uint32_t> &ids, const void *resource)
+{
+    const uint32_t max_id = (1u << kIdBits) - 1;
+    const auto inserted = ids.emplace(resource, static_cast<uint32_t>(std::min<size_t>(ids.size(), max_id)));
+    return inserted.first->second;
+}
+
+uint32_t RenderQueue::DepthBits(float view_depth)
+{
+    // Bits of a positive float order like the value itself; the top ones are
+    // the exponent and leading mantissa, i.e. a logarithmic depth scale
+    if (!(view_depth > 0.0f))
+        return 0;
+    uint32_t bits;
+    std::memcpy(&bits, &view_depth, sizeof(bits));
+    return bits >> (31 - kDepthBits);
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+
+class Mesh;
+class Shader;
+class Texture;
+
+// One lit draw, fully resolved so Renderer::DrawQueue needs nothing else
+struct DrawPacket
+{
+    const Mesh *mesh = nullptr;
+    const Shader *shader = nullptr;
+    const Texture *albedo = nullptr;   // nullptr: untextured
+    const void *material = nullptr;    // groups draws sharing material uniforms (the Material, if any)
+    glm::mat4 model{1.0f};
+    glm::vec3 color{1.0f};
+    glm::vec3 ambient{0.0f};
+    float smoothness = 0.5f;
+    // Index range to draw; a count of 0 draws the whole mesh
+    uint32_t first_index = 0;
+    uint32_t index_count = 0;
+};
+
+// Draw packets sorted by a 64-bit key so the renderer meets each program,
+// material, texture and mesh once per run instead of once per object:
+//
+//   63..62 pass | 61..50 shader | 49..38 material | 37..26 texture | 25..14 mesh | 13..0 depth
+//
+// Resources get small ids in first-seen order each frame (ids past 4095 share
+// the last one, which only costs sort quality). Depth sorts front to back
+// within a run, so early-z rejects more of what follows.
+class RenderQueue
+{
+public:
+    enum class Pass : uint8_t
+    {
+        Opaque = 0,
+    };
+
+    void Clear();
+    // `view_depth` is the distance along the camera's forward axis
+    void Push(const DrawPacket &packet, float view_depth, Pass pass = Pass::Opaque);
+    // Stable LSD radix sort on the keys, 8 bits per pass; passes where every key
+    // has the same digit are skipped
+    void Sort();
+
+    size_t Size() const { return packets_.size(); }
+    // i-th packet in sorted order (insertion order before Sort)
+    const DrawPacket &Sorted(size_t i) const { return packets_[order_[i]]; }
+    uint64_t SortedKey(size_t i) const { return keys_[order_[i]]; }
+
+private:
+    static constexpr uint32_t kIdBits = 12;
+    static constexpr uint32_t kDepthBits = 14;
+
+    static uint32_t IdOf(std::unordered_map<const void *, uint32_t> &ids, const void *resource);
+    static uint32_t DepthBits(float view_depth);
+
+    std::vector<DrawPacket> packets_;
+    std::vector<uint64_t> keys_;
+    std::vector<uint32_t> order_;
+    std::vector<uint32_t> scratch_;
+    std::unordered_map<const void *, uint32_t> shader_ids_;
+    std::unordered_map<const void *, uint32_t> material_ids_;
+    std::unordered_map<const void *, uint32_t> texture_ids_;
+    std::unordered_map<const void *, uint32_t> mesh_ids_;
+};
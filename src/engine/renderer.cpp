@@ -1,8 +1,12 @@
 #include "renderer.h"
 #include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <cstring>
 #include <iostream>
-
-Renderer::CachedLightState Renderer::s_cached_light_state_{};
+#include "gl_capabilities.h"
+#include "gl_state_cache.h"
+#include "texture.h"
 
 // Enhanced depth shader with minimal bias
 static const char *kDepthVS = R"glsl(
@@ -30,90 +34,482 @@ static const char *kDepthFS = R"glsl(
     }
 )glsl";
 
+// Occlusion query proxy: a unit cube stretched over a world-space AABB. Nothing is
+// written, the query only counts samples that pass the depth test.
+static const char *kBoxVS = R"glsl(
+    #version 410 core
+    layout (location = 0) in vec3 aPos;
+
+    uniform mat4 uViewProjection;
+    uniform vec3 uBoxMin;
+    uniform vec3 uBoxSize;
+
+    void main() {
+        gl_Position = uViewProjection * vec4(uBoxMin + aPos * uBoxSize, 1.0);
+    }
+)glsl";
+
+static const char *kBoxFS = R"glsl(
+    #version 410 core
+
+    void main() {
+    }
+)glsl";
+
 Renderer::Renderer()
 {
-    glEnable(GL_DEPTH_TEST);
+    GLStateCache &state = GLStateCache::GetInstance();
+    state.SetDepthTest(true);
     // Enable back-face culling for fewer fragment shader invocations
-    glEnable(GL_CULL_FACE);
-    glCullFace(GL_BACK);
-    glFrontFace(GL_CCW);
+    state.SetCullFace(true);
+    state.SetCullMode(GL_BACK);
+    state.SetFrontFace(GL_CCW);
+
+    // glBindBufferRange offsets into the uniform stream must be multiples of this
+    GLint alignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    m_uniformAlignment = std::max<size_t>(static_cast<size_t>(alignment), 16);
+    m_uniformBuffer = StreamBuffer(GL_UNIFORM_BUFFER, m_uniformAlignment);
 }
 
 void Renderer::BeginFrame(float r, float g, float b, float a)
 {
+    m_frameStats = FrameStats{};
+    GLStateCache::GetInstance().ResetStats();
+    m_instanceBuffer.NextFrame();
+    m_uniformBuffer.NextFrame();
+    m_indirectBuffer.NextFrame();
+    m_frameUniformsBound = false;
     glClearColor(r, g, b, a);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 }
 
 void Renderer::UpdateLightState(int light_count, const glm::vec3 *light_dirs, const glm::vec3 *light_colors, const glm::vec3 cam_pos)
 {
-    s_cached_light_state_.has_changed = s_cached_light_state_.count != light_count;
+    m_frameUniforms.light_count = light_count;
+    for (int i = 0; i < light_count; ++i)
+    {
+        m_frameUniforms.light_dirs[i] = glm::vec4(light_dirs[i], 0.0f);
+        m_frameUniforms.light_colors[i] = glm::vec4(light_colors[i], 0.0f);
+    }
+    m_frameUniforms.camera_position = cam_pos;
+}
+
+size_t Renderer::UniformStride(size_t bytes) const
+{
+    return (bytes + m_uniformAlignment - 1) / m_uniformAlignment * m_uniformAlignment;
+}
+
+void Renderer::BindFrameUniforms(const glm::mat4 &view, const glm::mat4 &projection)
+{
+    m_frameUniforms.view = view;
+    m_frameUniforms.projection = projection;
+    // Without a shadow pass the matrix stays zero, which the lit shaders read as unshadowed
+    m_frameUniforms.light_space = use_shadows ? m_lightSpaceMatrix : glm::mat4(0.0f);
+    m_frameUniforms.shadow_bias = shadow_settings.bias;
+    m_frameUniforms.pcf_samples = shadow_settings.pcf_samples;
+    if (m_frameUniformsBound && std::memcmp(&m_frameUniforms, &m_boundFrameUniforms, sizeof(UniformBlocks::Frame)) == 0)
+        return;
+
+    const size_t offset = m_uniformBuffer.Upload(&m_frameUniforms, sizeof(UniformBlocks::Frame));
+    glBindBufferRange(GL_UNIFORM_BUFFER, UniformBlocks::kFrameBinding, m_uniformBuffer.Id(), static_cast<GLintptr>(offset),
+                      sizeof(UniformBlocks::Frame));
+    m_frameStats.uniform_bytes += sizeof(UniformBlocks::Frame);
+    m_boundFrameUniforms = m_frameUniforms;
+    m_frameUniformsBound = true;
+}
+
+static void WriteMaterialUniforms(char *destination, const DrawPacket &packet)
+{
+    UniformBlocks::Material material;
+    material.color = packet.color;
+    material.smoothness = packet.smoothness;
+    material.ambient = packet.ambient;
+    material.use_texture = packet.albedo ? 1 : 0;
+    std::memcpy(destination, &material, sizeof(material));
+}
+
+// `mesh` supplies the vertex decode; nullptr for float vertices
+static void WriteDrawUniforms(char *destination, const glm::mat4 &model, bool instanced, const Mesh *mesh)
+{
+    UniformBlocks::Draw draw;
+    draw.model = model;
+    draw.instanced = instanced ? 1 : 0;
+    if (mesh && mesh->Format() == VertexFormat::Packed)
+    {
+        draw.position_decode = mesh->PositionDecode();
+        draw.packed_normals = 1;
+    }
+    std::memcpy(destination, &draw, sizeof(draw));
+}
+
+// Packets whose MaterialBlock contents would be identical
+static bool SameMaterialUniforms(const DrawPacket &a, const DrawPacket &b)
+{
+    return (a.albedo != nullptr) == (b.albedo != nullptr) && a.color == b.color && a.smoothness == b.smoothness &&
+           a.ambient == b.ambient;
+}
+
+// Index range or whole mesh, as the packet asks
+static void DrawPacketMesh(const DrawPacket &packet, Renderer::FrameStats &stats)
+{
+    const Mesh &mesh = *packet.mesh;
+    ++stats.draw_calls;
+    if (mesh.instance_id > 0)
+    {
+        stats.triangles += static_cast<size_t>(mesh.IndexCount() / 3) * mesh.InstanceCount();
+        mesh.DrawInstanced();
+    }
+    else if (packet.index_count > 0)
+    {
+        stats.triangles += packet.index_count / 3;
+        mesh.DrawRange(static_cast<GLsizei>(packet.first_index), static_cast<GLsizei>(packet.index_count));
+    }
+    else
+    {
+        stats.triangles += mesh.IndexCount() / 3;
+        mesh.Draw();
+    }
+}
+
+void Renderer::DrawMesh(const DrawPacket &packet, const glm::mat4 &view, const glm::mat4 &projection)
+{
+    BindFrameUniforms(view, projection);
+    packet.shader->use();
+    if (packet.albedo)
+        packet.albedo->bind(GL_TEXTURE_2D, UniformBlocks::kAlbedoUnit);
+    if (use_shadows)
+        GLStateCache::GetInstance().BindTexture(UniformBlocks::kShadowMapUnit, GL_TEXTURE_2D, m_shadowMapTexture);
+
+    const size_t materialStride = UniformStride(sizeof(UniformBlocks::Material));
+    const size_t bytes = materialStride + sizeof(UniformBlocks::Draw);
+    size_t offset = 0;
+    char *uniforms = static_cast<char *>(m_uniformBuffer.Map(bytes, offset));
+    WriteMaterialUniforms(uniforms, packet);
+    WriteDrawUniforms(uniforms + materialStride, packet.model, packet.mesh->instance_id > 0, packet.mesh);
+    m_uniformBuffer.Unmap();
+    m_frameStats.uniform_bytes += bytes;
+    glBindBufferRange(GL_UNIFORM_BUFFER, UniformBlocks::kMaterialBinding, m_uniformBuffer.Id(), static_cast<GLintptr>(offset),
+                      sizeof(UniformBlocks::Material));
+    glBindBufferRange(GL_UNIFORM_BUFFER, UniformBlocks::kDrawBinding, m_uniformBuffer.Id(),
+                      static_cast<GLintptr>(offset + materialStride), sizeof(UniformBlocks::Draw));
+
+    packet.mesh->Bind();
+    DrawPacketMesh(packet, m_frameStats);
+}
+
+// Packets that can share one instanced draw: everything but the model matrix
+// matches. Meshes with their own instance buffer and index ranges (static
+// batches) are drawn as they are.
+static bool SameInstancedDraw(const DrawPacket &a, const DrawPacket &b)
+{
+    return a.mesh == b.mesh && a.shader == b.shader && a.albedo == b.albedo && a.material == b.material &&
+           a.color == b.color && a.smoothness == b.smoothness && a.ambient == b.ambient;
+}
+
+// GL 4.3 / ARB_multi_draw_indirect, not in the 4.1 loader
+typedef void(APIENTRYP PFNGLMULTIDRAWELEMENTSINDIRECTPROC_)(GLenum mode, GLenum type, const void *indirect,
+                                                            GLsizei drawcount, GLsizei stride);
+static PFNGLMULTIDRAWELEMENTSINDIRECTPROC_ s_multiDrawElementsIndirect = nullptr;
 
-    for (int i = 0; i < light_count && !s_cached_light_state_.has_changed; ++i)
+bool Renderer::MultiDrawIndirectSupported()
+{
+    static const bool supported = []()
     {
-        const glm::vec3 diff = s_cached_light_state_.dirs[i] - light_dirs[i];
-        if (glm::dot(diff, diff) > 1e-12f)
+        // The commands' base instance is what points each draw at its matrices
+        const bool available = GLCapabilities::VersionAtLeast(4, 3) ||
+                               (GLCapabilities::HasExtension("GL_ARB_multi_draw_indirect") &&
+                                GLCapabilities::HasExtension("GL_ARB_base_instance"));
+        if (available)
         {
-            s_cached_light_state_.has_changed = true;
+            s_multiDrawElementsIndirect = reinterpret_cast<PFNGLMULTIDRAWELEMENTSINDIRECTPROC_>(
+                glfwGetProcAddress("glMultiDrawElementsIndirect"));
         }
-    }
-    for (int i = 0; i < light_count && !s_cached_light_state_.has_changed; ++i)
+        return s_multiDrawElementsIndirect != nullptr;
+    }();
+    return supported;
+}
+
+// The draw of `instances` copies of a packet's mesh (or index range) in the arena
+static DrawElementsIndirectCommand ArenaCommand(const DrawPacket &packet, const GeometryArena::Range &range,
+                                                size_t instances, size_t first_instance)
+{
+    DrawElementsIndirectCommand command;
+    command.count = packet.index_count > 0 ? packet.index_count : range.index_count;
+    command.instance_count = static_cast<GLuint>(instances);
+    command.first_index = range.first_index + packet.first_index;
+    command.base_vertex = range.base_vertex;
+    command.base_instance = static_cast<GLuint>(first_instance);
+    return command;
+}
+
+void Renderer::DrawQueue(const RenderQueue &queue, const glm::mat4 &view, const glm::mat4 &projection)
+{
+    if (queue.Size() == 0)
+        return;
+
+    GeometryArena &arena = GeometryArena::GetInstance();
+    const bool multiDraw = use_geometry_arena && MultiDrawIndirectSupported();
+
+    // Split the sorted packets into draws first, so every instance matrix goes
+    // up in one upload rather than one per group, and every material and draw
+    // block in another
+    m_queueBatches.clear();
+    m_instanceMatrices.clear();
+    m_indirectCommands.clear();
+    size_t materialCount = 0;
+    const DrawPacket *previous = nullptr;
+    for (size_t i = 0; i < queue.Size();)
     {
-        const glm::vec3 diff = s_cached_light_state_.colors[i] - light_colors[i];
-        if (glm::dot(diff, diff) > 1e-12f)
+        const DrawPacket &first = queue.Sorted(i);
+        size_t end = i + 1;
+        if (auto_instancing && first.mesh->instance_id == 0 && first.index_count == 0)
         {
-            s_cached_light_state_.has_changed = true;
+            while (end < queue.Size() && SameInstancedDraw(first, queue.Sorted(end)))
+                ++end;
         }
+        if (!previous || !SameMaterialUniforms(*previous, first))
+            ++materialCount;
+        previous = &first;
+        QueueBatch batch{};
+        batch.first = i;
+        batch.count = end - i;
+        batch.material = materialCount - 1;
+        // Meshes with their own instance buffer or packed vertices keep drawing
+        // from their own VAO
+        batch.in_arena =
+            use_geometry_arena && first.mesh->instance_id == 0 && first.mesh->Format() == VertexFormat::Float;
+        if (batch.in_arena)
+            batch.geometry = arena.Place(*first.mesh);
+        // A multi-draw reads every model matrix from the stream, even single ones
+        if (batch.count > 1 || (multiDraw && batch.in_arena))
+        {
+            batch.instance_offset = m_instanceMatrices.size() * sizeof(glm::mat4);
+            for (size_t k = i; k < end; ++k)
+                m_instanceMatrices.push_back(queue.Sorted(k).model);
+        }
+        m_queueBatches.push_back(batch);
+        i = end;
     }
-    if (!s_cached_light_state_.has_changed)
+
+    // Arena batches that need nothing rebound between them become one
+    // multi-draw, a command each. They share one draw block, which only says
+    // the model matrix comes from the instance attributes.
+    const size_t kSharedDrawBlock = ~size_t(0);
+    size_t drawBlocks = 0;
+    bool shortMultiDraws = false;
+    bool intMultiDraws = false;
+    for (size_t b = 0; b < m_queueBatches.size();)
     {
-        const glm::vec3 diff = s_cached_light_state_.cam_pos - cam_pos;
-        if (glm::dot(diff, diff) > 1e-12f)
+        QueueBatch &batch = m_queueBatches[b];
+        if (!multiDraw || !batch.in_arena)
+        {
+            batch.draw_block = drawBlocks++;
+            ++b;
+            continue;
+        }
+        const DrawPacket &packet = queue.Sorted(batch.first);
+        size_t end = b + 1;
+        while (end < m_queueBatches.size())
+        {
+            const QueueBatch &next = m_queueBatches[end];
+            const DrawPacket &nextPacket = queue.Sorted(next.first);
+            if (!next.in_arena || next.geometry.index_type != batch.geometry.index_type ||
+                next.material != batch.material || nextPacket.shader != packet.shader || nextPacket.albedo != packet.albedo)
+                break;
+            ++end;
+        }
+        batch.multi_draw_end = end;
+        batch.first_command = m_indirectCommands.size();
+        (batch.geometry.index_type == GL_UNSIGNED_SHORT ? shortMultiDraws : intMultiDraws) = true;
+        for (size_t k = b; k < end; ++k)
         {
-            s_cached_light_state_.has_changed = true;
+            QueueBatch &member = m_queueBatches[k];
+            member.draw_block = kSharedDrawBlock;
+            m_indirectCommands.push_back(ArenaCommand(queue.Sorted(member.first), member.geometry, member.count,
+                                                      member.instance_offset / sizeof(glm::mat4)));
         }
+        b = end;
     }
+    const size_t sharedDrawBlock = drawBlocks;
+    if (!m_indirectCommands.empty())
+        ++drawBlocks;
 
-    if (s_cached_light_state_.has_changed)
+    size_t instanceBase = 0;
+    if (!m_instanceMatrices.empty())
+        instanceBase = m_instanceBuffer.Upload(m_instanceMatrices.data(), m_instanceMatrices.size() * sizeof(glm::mat4));
+    size_t indirectBase = 0;
+    if (!m_indirectCommands.empty())
     {
-        s_cached_light_state_.count = light_count;
-        for (int i = 0; i < light_count; ++i)
-            s_cached_light_state_.dirs[i] = light_dirs[i];
-        for (int i = 0; i < light_count; ++i)
-            s_cached_light_state_.colors[i] = light_colors[i];
-        s_cached_light_state_.cam_pos = cam_pos;
+        indirectBase = m_indirectBuffer.Upload(m_indirectCommands.data(),
+                                               m_indirectCommands.size() * sizeof(DrawElementsIndirectCommand));
     }
-}
 
-void Renderer::DrawMesh(const Mesh &mesh,
-                        const Shader &shader)
-{
-    shader.use();
-    const GLint locLightCount = shader.get_uniform_location_cached("uLightCount");
-    const GLint locLightDirs0 = shader.get_uniform_location_cached("uLightDirs[0]");
-    const GLint locLightColors0 = shader.get_uniform_location_cached("uLightColors[0]");
-
-    if (s_cached_light_state_.has_changed)
+    BindFrameUniforms(view, projection);
+    // Material blocks, then the draw blocks
+    const size_t materialStride = UniformStride(sizeof(UniformBlocks::Material));
+    const size_t drawStride = UniformStride(sizeof(UniformBlocks::Draw));
+    const size_t drawBase = materialCount * materialStride;
+    const size_t uniformBytes = drawBase + drawBlocks * drawStride;
+    size_t uniformBase = 0;
+    char *uniforms = static_cast<char *>(m_uniformBuffer.Map(uniformBytes, uniformBase));
+    for (size_t b = 0; b < m_queueBatches.size(); ++b)
     {
-        auto count = s_cached_light_state_.count;
-        shader.set_int(locLightCount, count);
-        shader.set_vec3_array(locLightDirs0, s_cached_light_state_.dirs, count);
-        shader.set_vec3_array(locLightColors0, s_cached_light_state_.colors, count);
-        shader.set_vec3("uCamPos", s_cached_light_state_.cam_pos);
+        const QueueBatch &batch = m_queueBatches[b];
+        const DrawPacket &packet = queue.Sorted(batch.first);
+        if (b == 0 || batch.material != m_queueBatches[b - 1].material)
+            WriteMaterialUniforms(uniforms + batch.material * materialStride, packet);
+        if (batch.draw_block != kSharedDrawBlock)
+        {
+            WriteDrawUniforms(uniforms + drawBase + batch.draw_block * drawStride, packet.model,
+                              batch.count > 1 || packet.mesh->instance_id > 0, packet.mesh);
+        }
     }
+    if (!m_indirectCommands.empty())
+        WriteDrawUniforms(uniforms + drawBase + sharedDrawBlock * drawStride, glm::mat4(1.0f), true, nullptr);
+    m_uniformBuffer.Unmap();
+    m_frameStats.uniform_bytes += uniformBytes;
+    const GLuint uniformBuffer = m_uniformBuffer.Id();
 
-    const bool is_instanced = mesh.instance_id > 0;
+    if (use_shadows)
+        GLStateCache::GetInstance().BindTexture(UniformBlocks::kShadowMapUnit, GL_TEXTURE_2D, m_shadowMapTexture);
 
-    shader.set_int("u_isInstanced", is_instanced);
-    mesh.Bind();
+    const Shader *shader = nullptr;
+    const Texture *texture = nullptr;
+    const Mesh *mesh = nullptr;   // whose VAO is bound, unless arenaBound
+    GLenum arenaBound = 0;        // index type of the bound arena VAO, if one is
+    size_t material = materialCount;
 
-    if (is_instanced)
+    if (!m_indirectCommands.empty())
     {
-        mesh.DrawInstanced();
+        // Base instances count from this queue's first matrix, in each index type's VAO
+        if (shortMultiDraws)
+        {
+            arena.BindInstances(GL_UNSIGNED_SHORT, m_instanceBuffer.Id(), instanceBase);
+            arenaBound = GL_UNSIGNED_SHORT;
+            ++m_frameStats.state_changes;
+        }
+        if (intMultiDraws)
+        {
+            arena.BindInstances(GL_UNSIGNED_INT, m_instanceBuffer.Id(), instanceBase);
+            arenaBound = GL_UNSIGNED_INT;
+            ++m_frameStats.state_changes;
+        }
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_indirectBuffer.Id());
     }
-    else
+
+    size_t next = 0;
+    for (size_t b = 0; b < m_queueBatches.size(); b = next)
     {
-        mesh.Draw();
+        next = b + 1;
+        const QueueBatch &batch = m_queueBatches[b];
+        const DrawPacket &packet = queue.Sorted(batch.first);
+        if (packet.shader != shader)
+        {
+            shader = packet.shader;
+            shader->use();
+            ++m_frameStats.program_switches;
+            ++m_frameStats.state_changes;
+        }
+
+        if (packet.albedo && packet.albedo != texture)
+        {
+            texture = packet.albedo;
+            texture->bind(GL_TEXTURE_2D, UniformBlocks::kAlbedoUnit);
+            ++m_frameStats.state_changes;
+        }
+
+        if (batch.material != material)
+        {
+            material = batch.material;
+            glBindBufferRange(GL_UNIFORM_BUFFER, UniformBlocks::kMaterialBinding, uniformBuffer,
+                              static_cast<GLintptr>(uniformBase + material * materialStride), sizeof(UniformBlocks::Material));
+            ++m_frameStats.state_changes;
+        }
+
+        if (batch.in_arena && arenaBound != batch.geometry.index_type)
+        {
+            arena.Bind(batch.geometry.index_type);
+            arenaBound = batch.geometry.index_type;
+            mesh = nullptr;
+            ++m_frameStats.state_changes;
+        }
+
+        if (batch.multi_draw_end > b)
+        {
+            next = batch.multi_draw_end;
+            glBindBufferRange(GL_UNIFORM_BUFFER, UniformBlocks::kDrawBinding, uniformBuffer,
+                              static_cast<GLintptr>(uniformBase + drawBase + sharedDrawBlock * drawStride),
+                              sizeof(UniformBlocks::Draw));
+            const size_t commands = next - b;
+            for (size_t c = batch.first_command; c < batch.first_command + commands; ++c)
+            {
+                const DrawElementsIndirectCommand &command = m_indirectCommands[c];
+                m_frameStats.triangles += static_cast<size_t>(command.count / 3) * command.instance_count;
+            }
+            ++m_frameStats.draw_calls;
+            ++m_frameStats.multi_draws;
+            m_frameStats.indirect_commands += commands;
+            s_multiDrawElementsIndirect(GL_TRIANGLES, batch.geometry.index_type,
+                                        (void *)(indirectBase + batch.first_command * sizeof(DrawElementsIndirectCommand)),
+                                        static_cast<GLsizei>(commands), 0);
+            continue;
+        }
+
+        glBindBufferRange(GL_UNIFORM_BUFFER, UniformBlocks::kDrawBinding, uniformBuffer,
+                          static_cast<GLintptr>(uniformBase + drawBase + batch.draw_block * drawStride),
+                          sizeof(UniformBlocks::Draw));
+
+        if (batch.in_arena)
+        {
+            // No multi-draw: one base-vertex draw per batch, all from the arena's VAO
+            const DrawElementsIndirectCommand command = ArenaCommand(packet, batch.geometry, batch.count, 0);
+            const GLenum indexType = batch.geometry.index_type;
+            const void *indices = (void *)(command.first_index * MeshIndices::TypeSize(indexType));
+            ++m_frameStats.draw_calls;
+            m_frameStats.triangles += static_cast<size_t>(command.count / 3) * batch.count;
+            if (batch.count > 1)
+            {
+                // Re-pointed per group, as for a mesh's own VAO below
+                arena.BindInstances(indexType, m_instanceBuffer.Id(), instanceBase + batch.instance_offset);
+                ++m_frameStats.state_changes;
+                ++m_frameStats.instanced_draws;
+                m_frameStats.instances += batch.count;
+                glDrawElementsInstancedBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(command.count), indexType,
+                                                  indices, static_cast<GLsizei>(batch.count), command.base_vertex);
+            }
+            else
+            {
+                glDrawElementsBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(command.count), indexType, indices,
+                                         command.base_vertex);
+            }
+            continue;
+        }
+
+        if (batch.count > 1)
+        {
+            // No base instance in GL 4.1, so each group re-points the VAO's
+            // instance attributes at its slice of the stream
+            mesh = packet.mesh;
+            arenaBound = 0;
+            mesh->BindInstances(m_instanceBuffer.Id(), instanceBase + batch.instance_offset);
+            ++m_frameStats.state_changes;
+            ++m_frameStats.draw_calls;
+            ++m_frameStats.instanced_draws;
+            m_frameStats.instances += batch.count;
+            m_frameStats.triangles += static_cast<size_t>(mesh->IndexCount() / 3) * batch.count;
+            mesh->DrawInstanced(static_cast<GLsizei>(batch.count));
+            continue;
+        }
+
+        if (packet.mesh != mesh)
+        {
+            mesh = packet.mesh;
+            arenaBound = 0;
+            mesh->Bind();
+            ++m_frameStats.state_changes;
+        }
+        DrawPacketMesh(packet, m_frameStats);
     }
 }
 
@@ -124,7 +520,7 @@ void Renderer::InitializeShadowMap(int width, int height)
 
     // Create the depth texture
     glGenTextures(1, &m_shadowMapTexture);
-    glBindTexture(GL_TEXTURE_2D, m_shadowMapTexture);
+    GLStateCache::GetInstance().BindTexture(0, GL_TEXTURE_2D, m_shadowMapTexture);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, width, height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
 
     // Enable hardware PCF (Percentage Closer Filtering) for smooth shadows
@@ -155,40 +551,95 @@ void Renderer::InitializeShadowMap(int width, int height)
 
     // Create the depth shader
     m_depthShader = std::make_unique<Shader>(kDepthVS, kDepthFS);
+    m_depthMVP = m_depthShader->uniform<glm::mat4>("uMVP");
+    m_depthModel = m_depthShader->uniform<glm::mat4>("uModel");
+    m_depthInstanced = m_depthShader->uniform<int>("u_isInstanced");
 }
 
 void Renderer::BeginShadowPass(const glm::mat4 &lightSpaceMatrix, const glm::vec3 &lightDir)
 {
     m_lightSpaceMatrix = lightSpaceMatrix; // Cache it for drawing
     m_currentLightDir = lightDir;          // Cache light direction
-    glViewport(0, 0, m_shadowMapWidth, m_shadowMapHeight);
+    GLStateCache &state = GLStateCache::GetInstance();
+    state.SetViewport(0, 0, m_shadowMapWidth, m_shadowMapHeight);
     glBindFramebuffer(GL_FRAMEBUFFER, m_shadowMapFBO);
     glClear(GL_DEPTH_BUFFER_BIT);
     m_depthShader->use();
-    glCullFace(GL_FRONT); // Fix for peter-panning
+    state.SetCullMode(GL_FRONT); // Fix for peter-panning
 }
 
 void Renderer::SetViewport(int width, int height)
 {
-    glViewport(0, 0, width, height);
+    GLStateCache::GetInstance().SetViewport(0, 0, width, height);
 }
 
 void Renderer::EndShadowPass()
 {
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glCullFace(GL_BACK); // Restore back-face culling
+    GLStateCache::GetInstance().SetCullMode(GL_BACK); // Restore back-face culling
     // You'll need to reset viewport to screen size in your main loop
 }
 
 void Renderer::DrawMeshForDepth(const Mesh &mesh, const glm::mat4 &modelMatrix)
 {
     glm::mat4 mvp = m_lightSpaceMatrix * modelMatrix;
+    if (mesh.Format() == VertexFormat::Packed)
+    {
+        // The position decode rides in the MVP: a uniform scale, then an offset
+        const glm::vec4 &decode = mesh.PositionDecode();
+        glm::mat4 decodeMatrix(decode.w);
+        decodeMatrix[3] = glm::vec4(glm::vec3(decode), 1.0f);
+        mvp = mvp * decodeMatrix;
+    }
 
     // Set uniforms for the depth shader
-    m_depthShader->set_mat4("uMVP", mvp);
-    m_depthShader->set_mat4("uModel", modelMatrix);
-    m_depthShader->set_int("u_isInstanced", 0);
+    m_depthShader->set(m_depthMVP, mvp);
+    m_depthShader->set(m_depthModel, modelMatrix);
+    m_depthShader->set(m_depthInstanced, 0);
 
     mesh.Bind();
     mesh.Draw();
-}
\ No newline at end of file
+}
+
+void Renderer::BeginOcclusionBoxes(const glm::mat4 &viewProjection)
+{
+    if (!m_boxShader)
+    {
+        // Unit cube [0, 1]^3; only positions are read
+        std::vector<MeshVertex> corners(8);
+        for (int i = 0; i < 8; ++i)
+            corners[i].position = glm::vec3(i & 1 ? 1.0f : 0.0f, i & 2 ? 1.0f : 0.0f, i & 4 ? 1.0f : 0.0f);
+        const std::vector<unsigned int> indices = {0, 2, 1, 1, 2, 3, 4, 5, 6, 5, 7, 6,
+                                                   0, 1, 4, 1, 5, 4, 2, 6, 3, 3, 6, 7,
+                                                   0, 4, 2, 2, 4, 6, 1, 3, 5, 3, 7, 5};
+        m_boxMesh = std::make_unique<Mesh>(corners, indices);
+        m_boxShader = std::make_unique<Shader>(kBoxVS, kBoxFS);
+        m_boxViewProjection = m_boxShader->uniform<glm::mat4>("uViewProjection");
+        m_boxMin = m_boxShader->uniform<glm::vec3>("uBoxMin");
+        m_boxSize = m_boxShader->uniform<glm::vec3>("uBoxSize");
+    }
+
+    m_boxShader->use();
+    m_boxShader->set(m_boxViewProjection, viewProjection);
+    m_boxMesh->Bind();
+    GLStateCache &state = GLStateCache::GetInstance();
+    state.SetColorWrite(false);
+    state.SetDepthWrite(false);
+    // Both sides count, so a box is not lost when its front faces are clipped
+    state.SetCullFace(false);
+}
+
+void Renderer::DrawOcclusionBox(const Aabb &box)
+{
+    m_boxShader->set(m_boxMin, box.min);
+    m_boxShader->set(m_boxSize, box.max - box.min);
+    m_boxMesh->Draw();
+}
+
+void Renderer::EndOcclusionBoxes()
+{
+    GLStateCache &state = GLStateCache::GetInstance();
+    state.SetColorWrite(true);
+    state.SetDepthWrite(true);
+    state.SetCullFace(true);
+}
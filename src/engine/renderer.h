@@ -4,11 +4,26 @@
 #include "mesh.h"
 #include "shader.h"
 #include "light.h"
+#include "bounds.h"
+#include "geometry_arena.h"
+#include "query_pool.h"
+#include "render_queue.h"
+#include "stream_buffer.h"
+#include "uniform_blocks.h"
+#include <vector>
 
 class Renderer
 {
 public:
     bool use_shadows = false;
+    // DrawQueue merges runs of packets differing only in their model matrix
+    // into one instanced draw
+    bool auto_instancing = true;
+    // DrawQueue draws meshes from the shared GeometryArena: consecutive
+    // packets sharing program, texture and material values go out as one
+    // glMultiDrawElementsIndirect where available, and as base-vertex draws
+    // with no VAO switches between them otherwise
+    bool use_geometry_arena = true;
 
     // Shadow quality settings
     struct ShadowSettings
@@ -20,12 +35,45 @@ public:
         bool use_contact_hardening = false;
     } shadow_settings;
 
+    // What the main pass submitted since the last BeginFrame. State changes
+    // (program, material block, texture and VAO binds) and program switches
+    // are counted for DrawQueue only, as are the instanced draws it merged
+    // packets into and the packets they covered, and its multi-draws with the
+    // commands they carried. A multi-draw counts as one draw call.
+    struct FrameStats
+    {
+        size_t draw_calls = 0;
+        size_t triangles = 0;
+        size_t state_changes = 0;
+        size_t program_switches = 0;
+        size_t instanced_draws = 0;
+        size_t instances = 0;
+        size_t uniform_bytes = 0;   // uniform block data streamed
+        size_t multi_draws = 0;
+        size_t indirect_commands = 0;
+    };
+
     Renderer();
 
     void BeginFrame(float r, float g, float b, float a);
+    // Lights and camera position for the per-frame uniform block (FrameBlock)
     void UpdateLightState(int light_count, const glm::vec3 *light_dirs, const glm::vec3 *light_colors, const glm::vec3 cam_pos);
-    void DrawMesh(const Mesh &mesh,
-                  const Shader &shader);
+    // Draws one lit packet outside the queue
+    void DrawMesh(const DrawPacket &packet, const glm::mat4 &view, const glm::mat4 &projection);
+
+    // Draws a sorted queue of lit packets. The per-frame block goes up once a
+    // frame; a material block is written whenever material values change from
+    // one packet to the next and a draw block per draw, all streamed in one
+    // range and bound with glBindBufferRange. Textures and VAOs are only
+    // touched when they differ from the previous packet. With auto_instancing,
+    // consecutive packets sharing program, mesh, texture and material values
+    // are drawn as one instanced call, their model matrices streamed in a
+    // single upload. See use_geometry_arena for how meshes are submitted.
+    void DrawQueue(const RenderQueue &queue, const glm::mat4 &view, const glm::mat4 &projection);
+
+    // GL 4.3, or ARB_multi_draw_indirect with ARB_base_instance, and a loadable
+    // glMultiDrawElementsIndirect; checked once per process, with the context current
+    static bool MultiDrawIndirectSupported();
 
     // Helper to draw only a mesh with a shader when no lighting is needed
     void DrawSimple(const Mesh &mesh,
@@ -42,24 +90,63 @@ public:
     void EndShadowPass();
     void DrawMeshForDepth(const Mesh &mesh, const glm::mat4 &mvp);
     GLuint GetShadowMapTexture() const { return m_shadowMapTexture; }
+    const FrameStats &GetFrameStats() const { return m_frameStats; }
 
-private:
-    struct CachedLightState
-    {
-        int count = -1;
-        glm::vec3 dirs[Light::kMaxLights];
-        glm::vec3 colors[Light::kMaxLights];
-        glm::vec3 cam_pos;
-        bool has_changed = false;
-    };
+    // Hardware occlusion queries. The pool recycles query objects across frames;
+    // the box pass draws world-space AABBs depth-tested against the current depth
+    // buffer with color and depth writes off, for wrapping in glBeginQuery.
+    QueryPool &GetQueryPool() { return m_queryPool; }
+    void BeginOcclusionBoxes(const glm::mat4 &viewProjection);
+    void DrawOcclusionBox(const Aabb &box);
+    void EndOcclusionBoxes();
 
-    static CachedLightState s_cached_light_state_;
+private:
+    // Uploads the frame block (with this view and projection) unless the one
+    // already bound this frame holds the same values
+    void BindFrameUniforms(const glm::mat4 &view, const glm::mat4 &projection);
+    // `bytes` rounded up to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+    size_t UniformStride(size_t bytes) const;
 
     GLuint m_shadowMapFBO = 0;
     GLuint m_shadowMapTexture = 0;
     int m_shadowMapWidth = 0;
     int m_shadowMapHeight = 0;
     std::unique_ptr<Shader> m_depthShader;
+    Uniform<glm::mat4> m_depthMVP;
+    Uniform<glm::mat4> m_depthModel;
+    Uniform<int> m_depthInstanced;
     glm::mat4 m_lightSpaceMatrix;
     glm::vec3 m_currentLightDir;
+
+    FrameStats m_frameStats;
+    UniformBlocks::Frame m_frameUniforms;
+    UniformBlocks::Frame m_boundFrameUniforms;
+    bool m_frameUniformsBound = false;
+    size_t m_uniformAlignment = 16;
+    StreamBuffer m_uniformBuffer{GL_UNIFORM_BUFFER};
+    // A run of sorted queue packets drawn by one call (instanced when count > 1)
+    struct QueueBatch
+    {
+        size_t first;
+        size_t count;
+        size_t instance_offset;   // bytes into m_instanceBuffer
+        size_t material;          // index of its material block
+        size_t draw_block;        // index of its draw block
+        bool in_arena;            // drawn from GeometryArena at `geometry`
+        GeometryArena::Range geometry;
+        // First batch of a multi-draw: the batch after its last, and its first command
+        size_t multi_draw_end;
+        size_t first_command;
+    };
+    std::vector<QueueBatch> m_queueBatches;
+    std::vector<glm::mat4> m_instanceMatrices;
+    StreamBuffer m_instanceBuffer;
+    std::vector<DrawElementsIndirectCommand> m_indirectCommands;
+    StreamBuffer m_indirectBuffer{GL_DRAW_INDIRECT_BUFFER, 4};
+    QueryPool m_queryPool;
+    std::unique_ptr<Shader> m_boxShader;
+    std::unique_ptr<Mesh> m_boxMesh;
+    Uniform<glm::mat4> m_boxViewProjection;
+    Uniform<glm::vec3> m_boxMin;
+    Uniform<glm::vec3> m_boxSize;
 };
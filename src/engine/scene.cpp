@@ -9,28 +9,153 @@
 #include "mesh_renderer.h"
 
 #include <SOIL2.h>
+#include <algorithm>
+
+Scene::~Scene()
+{
+    // Objects detach their components first, then each pool is dropped wholesale
+    object_pool_.ReleaseAll();
+    objects_.clear();
+    registry_.ReleaseAll();
+}
 
 GameObject &Scene::CreateObject()
 {
-    auto obj = std::make_unique<GameObject>();
-    GameObject &ref = *obj;
-    ref.SetScene(this);
-    objects_.push_back(std::move(obj));
+    GameObject &ref = AllocateObject();
+    registry_.Register(ref);
     return ref;
 }
 
+GameObject &Scene::AllocateObject()
+{
+    const size_t index = object_pool_.Emplace(this);
+    GameObject &ref = object_pool_.At(index);
+    ref.pool_index_ = static_cast<uint32_t>(index);
+    ref.generation_ = object_pool_.Generation(index);
+    ref.list_index_ = objects_.size();
+    objects_.push_back(&ref);
+    return ref;
+}
+
+void Scene::ReserveObjects(size_t count)
+{
+    object_pool_.Reserve(count);
+    const size_t needed = objects_.size() + count;
+    if (needed > objects_.capacity())
+    {
+        objects_.reserve(std::max(needed, objects_.capacity() * 2));
+    }
+}
+
 GameObject &Scene::Instantiate(const GameObject &original)
 {
-    GameObject &clone = CreateObject();
-    original.CloneComponentsTo(clone);
-    return clone;
+    return *objects_[CloneMany(original, 1)];
+}
+
+size_t Scene::InstantiateMany(const GameObject &original, size_t count)
+{
+    return CloneMany(original, count);
+}
+
+size_t Scene::CloneMany(const GameObject &original, size_t count)
+{
+    const size_t first = objects_.size();
+    ReserveObjects(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        AllocateObject();
+    }
+    registry_.CloneInto(original, objects_.data() + first, count);
+    return first;
+}
+
+void Scene::Destroy(GameObject &object)
+{
+    if (object.pending_destroy_)
+        return;
+    object.pending_destroy_ = true;
+    pending_destroy_.push_back(&object);
+}
+
+void Scene::Destroy(ObjectHandle handle)
+{
+    if (GameObject *object = Resolve(handle))
+    {
+        Destroy(*object);
+    }
+}
+
+GameObject *Scene::Resolve(ObjectHandle handle)
+{
+    return handle.IsNull() ? nullptr : object_pool_.TryGet(handle.index, handle.generation);
+}
+
+void Scene::FlushDestroyed()
+{
+    // Index loop: OnDetach may queue further objects, which are handled in this pass
+    for (size_t i = 0; i < pending_destroy_.size(); ++i)
+    {
+        GameObject &object = *pending_destroy_[i];
+        registry_.DestroyComponents(object);
+
+        // Swap-remove from the object list
+        GameObject *last = objects_.back();
+        objects_[object.list_index_] = last;
+        last->list_index_ = object.list_index_;
+        objects_.pop_back();
+
+        object_pool_.Free(object.pool_index_);
+    }
+    pending_destroy_.clear();
 }
 
 void Scene::Update(float time_seconds)
 {
-    for (auto &obj : objects_)
+    // Walk components type by type so each loop stays within one contiguous storage
+    registry_.UpdateAll(time_seconds, job_system_);
+
+    // Objects destroyed during this frame's updates leave before their matrices are rebuilt
+    FlushDestroyed();
+
+    // Rebuild every changed transform matrix in one batched pass before rendering
+    transform_system_.Update(registry_.Storage<Transform>(), job_system_);
+
+    if (spatial_grid_)
+    {
+        spatial_grid_->Update(registry_.Storage<Transform>(), transform_system_);
+    }
+}
+
+void Scene::EnableSpatialGrid(float cell_size)
+{
+    spatial_grid_ = std::make_unique<SpatialGrid>(cell_size);
+    spatial_grid_->Rebuild(registry_.Storage<Transform>());
+}
+
+void Scene::SetOcclusionQueries(bool enabled)
+{
+    // Visibility gathered before a pause would be stale when queries resume
+    if (!enabled)
     {
-        obj->Update(time_seconds);
+        occlusion_query_system_.Invalidate();
+    }
+    occlusion_queries_ = enabled;
+}
+
+void Scene::SetStaticBatching(bool enabled)
+{
+    if (!enabled)
+    {
+        static_batch_system_.Clear(registry_.Storage<MeshRenderer>());
+    }
+    static_batching_ = enabled;
+}
+
+void Scene::BuildStaticBatches()
+{
+    if (static_batching_)
+    {
+        static_batch_system_.Update(registry_.Storage<MeshRenderer>(), job_system_);
     }
 }
 
@@ -67,19 +192,70 @@ void Scene::Render(Renderer &renderer)
     renderer.BeginFrame(clear_color_.r, clear_color_.g, clear_color_.b, 1.0f);
 
     // Render skybox first (if any)
-    if (skybox_object_)
+    if (skybox_renderer_)
     {
-        skybox_object_->Render(renderer, projection, view);
+        skybox_renderer_->OnRender(renderer, projection, view);
     }
 
-    for (auto &obj : objects_)
+    ComponentStorage<MeshRenderer> &mesh_renderers = registry_.Storage<MeshRenderer>();
+    // Settles which renderers are batched before culling looks at them
+    BuildStaticBatches();
+    registry_.RenderAll(renderer, projection, view, ComponentTypeIds::Of<MeshRenderer>());
+    if (frustum_culling_)
+    {
+        const std::vector<uint32_t> &visible = culling_system_.Cull(mesh_renderers, projection * view, job_system_);
+        if (occlusion_queries_)
+        {
+            occlusion_query_system_.Render(renderer, mesh_renderers, visible, culling_system_, projection, view);
+            // Static batches are not query candidates; they are culled per cell
+            DrawMeshRenderers(renderer, projection, view, {});
+        }
+        else
+        {
+            DrawMeshRenderers(renderer, projection, view, visible);
+        }
+    }
+    else
     {
-        obj->Render(renderer, projection, view);
+        all_mesh_slots_.clear();
+        for (size_t i = 0; i < mesh_renderers.SlotCount(); ++i)
+        {
+            if (mesh_renderers.IsAlive(i) && !mesh_renderers.At(i).IsStaticBatched())
+                all_mesh_slots_.push_back(static_cast<uint32_t>(i));
+        }
+        DrawMeshRenderers(renderer, projection, view, all_mesh_slots_);
     }
 
     // renderer.DrawInstanced(projection, view);
 }
 
+void Scene::DrawMeshRenderers(Renderer &renderer, const glm::mat4 &projection, const glm::mat4 &view,
+                              const std::vector<uint32_t> &slots)
+{
+    ComponentStorage<MeshRenderer> &mesh_renderers = registry_.Storage<MeshRenderer>();
+    render_queue_.Clear();
+    DrawPacket packet;
+    float view_depth = 0.0f;
+    for (uint32_t slot : slots)
+    {
+        MeshRenderer &mesh_renderer = mesh_renderers.At(slot);
+        if (mesh_renderer.BuildDrawPacket(projection, view, packet, view_depth))
+        {
+            render_queue_.Push(packet, view_depth);
+        }
+        else
+        {
+            mesh_renderer.OnRender(renderer, projection, view);
+        }
+    }
+    if (static_batching_)
+    {
+        static_batch_system_.Gather(projection, view, frustum_culling_, render_queue_);
+    }
+    render_queue_.Sort();
+    renderer.DrawQueue(render_queue_, view, projection);
+}
+
 bool Scene::SetSkyFromEquirect(const std::string &path)
 {
     // Load GL texture into a persistent shared Texture
@@ -94,20 +270,14 @@ bool Scene::SetSkyFromEquirect(const std::string &path)
         ambient_color_ = avg;
     }
 
-    // Create skybox object with MeshRenderer in Skybox mode
-    if (!skybox_object_)
-    {
-        skybox_object_ = std::make_unique<GameObject>();
-        skybox_object_->SetScene(this);
-    }
-    MeshRenderer *mr = skybox_object_->GetComponent<MeshRenderer>();
-    if (!mr)
+    // Create skybox MeshRenderer in Skybox mode
+    if (!skybox_renderer_)
     {
-        mr = skybox_object_->AddComponent<MeshRenderer>();
-        mr->render_mode = MeshRenderer::RenderMode::Skybox;
-        mr->SetMesh(MeshRenderer::CreateUnitCube());
+        skybox_renderer_ = std::make_unique<MeshRenderer>();
+        skybox_renderer_->render_mode = MeshRenderer::RenderMode::Skybox;
+        skybox_renderer_->SetMesh(MeshRenderer::CreateUnitCube());
     }
-    mr->diffuse_texture = std::move(sky_tex);
+    skybox_renderer_->diffuse_texture = std::move(sky_tex);
     return true;
 }
 
@@ -8,8 +8,16 @@
 #include <GLFW/glfw3.h>
 #include "shader.h"
 #include "mesh_renderer.h"
+#include "component_registry.h"
+#include "transform_system.h"
+#include "culling_system.h"
+#include "occlusion_query_system.h"
+#include "static_batch_system.h"
+#include "spatial_grid.h"
+#include "job_system.h"
+#include "object_pool.h"
+#include "game_object.h"
 
-class GameObject;
 class Renderer;
 class Camera;
 class Light;
@@ -18,14 +26,124 @@ class Scene
 {
 public:
     Scene() = default;
+    ~Scene();
+
+    Scene(const Scene &) = delete;
+    Scene &operator=(const Scene &) = delete;
 
     GameObject &CreateObject();
-    // Duplicate a GameObject with supported components (Transform, Camera, Light)
-    // Note: MeshRenderer is not duplicated due to GPU resource ownership; attach a new one manually.
+    // Pre-allocates pool space for `count` more GameObjects
+    void ReserveObjects(size_t count);
+    // Duplicate a GameObject's cloneable components (see Component::Clone)
     GameObject &Instantiate(const GameObject &original);
+
+    // Creates `count` clones of `original` in one batch: pools are reserved up
+    // front and each component type is copied in a single pass. Returns the index
+    // of the first clone in GetGameObjects(); the clones follow contiguously
+    // until the next FlushDestroyed reorders the list.
+    size_t InstantiateMany(const GameObject &original, size_t count);
+
+    // As above, then calls initializer(GameObject &clone, size_t i) for each clone.
+    // With `parallel`, clones are initialized on the job system, so the
+    // initializer must only touch its own clone.
+    template <typename Fn>
+    size_t InstantiateMany(const GameObject &original, size_t count, Fn &&initializer, bool parallel = false)
+    {
+        const size_t first = CloneMany(original, count);
+        auto init_range = [this, first, &initializer](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                initializer(*objects_[first + i], i);
+            }
+        };
+        if (parallel && job_system_)
+        {
+            job_system_->ParallelFor(count, 256, init_range);
+        }
+        else
+        {
+            init_range(0, count);
+        }
+        return first;
+    }
+    // Queues `object` for destruction. It stays fully usable until the end of
+    // the frame's Update (or an explicit FlushDestroyed), so nothing being
+    // iterated is invalidated. Children of a destroyed Transform become roots.
+    void Destroy(GameObject &object);
+    void Destroy(ObjectHandle handle);
+    // Destroys every queued object and recycles its pool slots
+    void FlushDestroyed();
+
+    // nullptr if the object or component has been destroyed
+    GameObject *Resolve(ObjectHandle handle);
+    template <typename T>
+    T *Resolve(ComponentHandle<T> handle) { return registry_.Resolve(handle); }
+    template <typename T>
+    ComponentHandle<T> GetHandle(const T &component) { return registry_.HandleOf(component); }
+
+    // Runs every component's OnStart/OnUpdate, then FlushDestroyed, then the
+    // batched transform update (and the spatial grid refresh, if enabled).
+    // Components update type by type, in the order each type was first added to
+    // the scene, then in storage slot order; one object's components do not run
+    // in attach order. A component that must see another type's update from the
+    // same frame needs its type to reach the scene later.
     void Update(float time_seconds);
+    // Lit MeshRenderers are gathered into a RenderQueue and drawn sorted by
+    // program, material, texture, mesh and depth; Renderer::GetFrameStats
+    // reports the draws and state changes that took
     void Render(Renderer &renderer);
 
+    // Render skips MeshRenderers whose world bounds lie outside the camera frustum
+    // (on by default); GetCullingStats reports what the last Render culled
+    void SetFrustumCulling(bool enabled) { frustum_culling_ = enabled; }
+    bool GetFrustumCulling() const { return frustum_culling_; }
+    const CullingStats &GetCullingStats() const { return culling_system_.LastStats(); }
+    // Adds a CPU occlusion pass after frustum culling: MeshRenderers flagged as
+    // occluders hide what is behind them (off by default)
+    void SetOcclusionCulling(bool enabled) { culling_system_.SetOcclusionCulling(enabled); }
+    bool GetOcclusionCulling() const { return culling_system_.GetOcclusionCulling(); }
+    // GPU alternative: frustum-visible MeshRenderers are drawn or skipped based on
+    // hardware occlusion queries from earlier frames, never waiting on results.
+    // Needs frustum culling (off by default); the query pool lives in the Renderer.
+    void SetOcclusionQueries(bool enabled);
+    bool GetOcclusionQueries() const { return occlusion_queries_; }
+    const OcclusionQueryStats &GetOcclusionQueryStats() const { return occlusion_query_system_.LastStats(); }
+
+    // MeshRenderers flagged is_static are merged into one mesh per material and
+    // spatial cell (on by default). Render picks up newly flagged renderers and
+    // rebuilds a batch only when one of its members moved, changed or went away;
+    // cells are frustum culled, then the members of cells partly in view.
+    void SetStaticBatching(bool enabled);
+    bool GetStaticBatching() const { return static_batching_; }
+    // Edge of the cubic cells batches are split into (world units, default 32)
+    void SetStaticBatchCellSize(float cell_size) { static_batch_system_.SetCellSize(cell_size); }
+    // Builds pending batches now (e.g. once a level is loaded) instead of on the
+    // next Render. Needs the GL context.
+    void BuildStaticBatches();
+    const StaticBatchStats &GetStaticBatchStats() const { return static_batch_system_.LastStats(); }
+
+    // Proximity queries over object positions. The grid is opt-in: once enabled
+    // it is refreshed at the end of every Update, and GetSpatialGrid returns it
+    // (nullptr while disabled). Re-enabling with a new cell size rebuilds it.
+    void EnableSpatialGrid(float cell_size = 4.0f);
+    void DisableSpatialGrid() { spatial_grid_.reset(); }
+    const SpatialGrid *GetSpatialGrid() const { return spatial_grid_.get(); }
+
+    // Iterates every object that has all of Ts, e.g.
+    // scene.ForEach<Transform, MeshRenderer>([](Transform &t, MeshRenderer &mr) { ... });
+    // Do not add components from inside `fn`.
+    template <typename... Ts, typename Fn>
+    void ForEach(Fn &&fn) { registry_.ForEach<Ts...>(std::forward<Fn>(fn)); }
+
+    ComponentRegistry &GetComponentRegistry() { return registry_; }
+    TransformSystem &GetTransformSystem() { return transform_system_; }
+
+    // Worker pool used by Update for kParallelUpdate components and transform
+    // composition. nullptr keeps the whole update on the calling thread.
+    void SetJobSystem(JobSystem *jobs) { job_system_ = jobs; }
+    JobSystem *GetJobSystem() const { return job_system_; }
+
     // Camera management
     void RegisterCamera(Camera *camera);
     void UnregisterCamera(Camera *camera);
@@ -49,21 +167,50 @@ public:
     void SetWindow(GLFWwindow *window) { window_ = window; }
     GLFWwindow *GetWindow() const { return window_; }
 
-    const std::vector<std::unique_ptr<GameObject>> &GetGameObjects() const { return objects_; };
+    // Live objects; destroying an object swaps the last one into its place
+    const std::vector<GameObject *> &GetGameObjects() const { return objects_; };
+
+    // Allocation stats for the GameObject pool and the component pools
+    PoolStats GetObjectPoolStats() const { return object_pool_.Stats(); }
+    CombinedPoolStats GetComponentPoolStats() const { return registry_.Stats(); }
+    template <typename T>
+    PoolStats GetComponentPoolStats() { return registry_.Storage<T>().Stats(); }
 
 private:
+    GameObject &AllocateObject();
+    size_t CloneMany(const GameObject &original, size_t count);
+    // Lit renderers go through the sorted render queue along with the static
+    // batches, the rest draw directly
+    void DrawMeshRenderers(Renderer &renderer, const glm::mat4 &projection, const glm::mat4 &view,
+                           const std::vector<uint32_t> &slots);
+
     // Important: Declare manager containers before `objects_` so they
     // outlive `objects_` during destruction. Components' OnDetach may
     // reference these containers (e.g., lights), so they must still be valid
     // while GameObjects are being destroyed.
     Camera *active_camera_ = nullptr;
     std::vector<Light *> lights_{};
-    std::vector<std::unique_ptr<GameObject>> objects_;
+    // Owns all component memory; must outlive the objects so OnDetach can run
+    ComponentRegistry registry_{};
+    ObjectPool<GameObject> object_pool_{};
+    std::vector<GameObject *> objects_;
+    std::vector<GameObject *> pending_destroy_;
+    TransformSystem transform_system_{};
+    CullingSystem culling_system_{};
+    OcclusionQuerySystem occlusion_query_system_{};
+    StaticBatchSystem static_batch_system_{};
+    RenderQueue render_queue_{};
+    std::vector<uint32_t> all_mesh_slots_{};
+    std::unique_ptr<SpatialGrid> spatial_grid_{};
+    bool frustum_culling_ = true;
+    bool occlusion_queries_ = false;
+    bool static_batching_ = true;
+    JobSystem *job_system_ = &JobSystem::GetInstance();
     glm::vec3 ambient_color_{0.0f, 0.0f, 0.0f};
     glm::vec3 clear_color_{0.1f, 0.2f, 0.3f};
 
-    // Skybox is a dedicated GameObject with a MeshRenderer in Skybox mode
-    std::unique_ptr<GameObject> skybox_object_{};
+    // Skybox is a standalone MeshRenderer in Skybox mode, drawn before all objects
+    std::unique_ptr<MeshRenderer> skybox_renderer_{};
 
     GLFWwindow *window_ = nullptr;
 };
@@ -0,0 +1,227 @@
+#include "scene_bvh.h"
+
+#include <algorithm>
+
+// Median splits give depth ~log2(n / kLeafSize); this covers any realistic scene
+static constexpr size_t kMaxCullStack = 64;
+
+static bool SameBox(const Aabb &a, const Aabb &b)
+{
+    return a.min == b.min && a.max == b.max;
+}
+
+void SceneBvh::Build(const Aabb *boxes, size_t count)
+{
+    nodes_.clear();
+    dirty_leaves_.clear();
+    order_.resize(count);
+    slot_of_proxy_.resize(count);
+    leaf_of_proxy_.resize(count);
+    boxes_.resize(count);
+    centroids_.resize(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        order_[i] = static_cast<uint32_t>(i);
+        boxes_[i] = boxes[i];
+        centroids_[i] = boxes[i].Center();
+    }
+    if (count == 0)
+    {
+        build_cost_ = 0.0f;
+        return;
+    }
+
+    // A binary tree with at least one proxy per leaf has fewer than 2 * count nodes
+    nodes_.reserve(2 * count);
+    nodes_.emplace_back();
+    BuildNode(0, 0, static_cast<uint32_t>(count));
+
+    // Lay the boxes out in tree order so each leaf reads one contiguous range
+    const std::vector<Aabb> by_proxy = boxes_;
+    for (auto *channel : {&cx_, &cy_, &cz_, &ex_, &ey_, &ez_})
+    {
+        channel->resize(count);
+    }
+    for (uint32_t slot = 0; slot < count; ++slot)
+    {
+        const uint32_t proxy = order_[slot];
+        slot_of_proxy_[proxy] = slot;
+        SetSlot(slot, by_proxy[proxy]);
+    }
+    for (uint32_t i = 0; i < nodes_.size(); ++i)
+    {
+        const Node &node = nodes_[i];
+        if (node.left != 0)
+            continue;
+        for (uint32_t slot = node.first; slot < node.first + node.count; ++slot)
+        {
+            leaf_of_proxy_[order_[slot]] = i;
+        }
+    }
+    build_cost_ = Cost();
+}
+
+void SceneBvh::BuildNode(uint32_t index, uint32_t first, uint32_t count)
+{
+    Aabb box;
+    Aabb centroid_bounds;
+    for (uint32_t i = first; i < first + count; ++i)
+    {
+        box.Expand(boxes_[order_[i]]);
+        centroid_bounds.Expand(centroids_[order_[i]]);
+    }
+    nodes_[index].box = box;
+    nodes_[index].first = first;
+    nodes_[index].count = count;
+    if (count <= kLeafSize)
+        return;
+
+    const glm::vec3 size = centroid_bounds.max - centroid_bounds.min;
+    const int axis = size.x >= size.y && size.x >= size.z ? 0 : (size.y >= size.z ? 1 : 2);
+    const uint32_t half = count / 2;
+    auto by_axis = [this, axis](uint32_t a, uint32_t b)
+    {
+        return centroids_[a][axis] < centroids_[b][axis];
+    };
+    std::nth_element(order_.begin() + first, order_.begin() + first + half, order_.begin() + first + count, by_axis);
+
+    // Children are allocated as a pair so the right one is always left + 1
+    const uint32_t left = static_cast<uint32_t>(nodes_.size());
+    nodes_.emplace_back();
+    nodes_.emplace_back();
+    nodes_[index].left = left;
+    nodes_[left].parent = index;
+    nodes_[left + 1].parent = index;
+    BuildNode(left, first, half);
+    BuildNode(left + 1, first + half, count - half);
+}
+
+void SceneBvh::SetSlot(uint32_t slot, const Aabb &box)
+{
+    boxes_[slot] = box;
+    const glm::vec3 c = box.Center();
+    const glm::vec3 e = box.Extents();
+    cx_[slot] = c.x;
+    cy_[slot] = c.y;
+    cz_[slot] = c.z;
+    ex_[slot] = e.x;
+    ey_[slot] = e.y;
+    ez_[slot] = e.z;
+}
+
+void SceneBvh::Update(uint32_t proxy, const Aabb &box)
+{
+    SetSlot(slot_of_proxy_[proxy], box);
+    Node &leaf = nodes_[leaf_of_proxy_[proxy]];
+    if (!leaf.dirty)
+    {
+        leaf.dirty = true;
+        dirty_leaves_.push_back(leaf_of_proxy_[proxy]);
+    }
+}
+
+void SceneBvh::RecomputeLeaf(Node &node)
+{
+    Aabb box;
+    for (uint32_t slot = node.first; slot < node.first + node.count; ++slot)
+    {
+        box.Expand(boxes_[slot]);
+    }
+    node.box = box;
+}
+
+size_t SceneBvh::Refit()
+{
+    size_t changed = 0;
+    for (uint32_t leaf : dirty_leaves_)
+    {
+        Node &node = nodes_[leaf];
+        node.dirty = false;
+        const Aabb old_box = node.box;
+        RecomputeLeaf(node);
+        if (SameBox(old_box, node.box))
+            continue;
+        ++changed;
+
+        // Walk towards the root until a parent's box comes out unchanged
+        uint32_t index = leaf;
+        while (index != 0)
+        {
+            Node &parent = nodes_[nodes_[index].parent];
+            Aabb box = nodes_[parent.left].box;
+            box.Expand(nodes_[parent.left + 1].box);
+            if (SameBox(box, parent.box))
+                break;
+            parent.box = box;
+            ++changed;
+            index = nodes_[index].parent;
+        }
+    }
+    dirty_leaves_.clear();
+    return changed;
+}
+
+size_t SceneBvh::Cull(const Frustum &frustum, std::vector<uint32_t> &visible) const
+{
+    if (nodes_.empty())
+        return 0;
+
+    uint32_t stack[kMaxCullStack];
+    size_t stack_size = 0;
+    size_t tested = 0;
+    stack[stack_size++] = 0;
+    while (stack_size > 0)
+    {
+        const Node &node = nodes_[stack[--stack_size]];
+        ++tested;
+        const Frustum::Result result = frustum.Classify(node.box);
+        if (result == Frustum::Result::Outside)
+            continue;
+        if (result == Frustum::Result::Inside)
+        {
+            visible.insert(visible.end(), order_.begin() + node.first, order_.begin() + node.first + node.count);
+            continue;
+        }
+        if (node.left != 0)
+        {
+            stack[stack_size++] = node.left + 1;
+            stack[stack_size++] = node.left;
+            continue;
+        }
+
+        const AabbSoA boxes{cx_.data() + node.first, cy_.data() + node.first, cz_.data() + node.first,
+                            ex_.data() + node.first, ey_.data() + node.first, ez_.data() + node.first};
+        uint8_t leaf_visible[kLeafSize];
+        frustum.CullBoxes(boxes, node.count, leaf_visible);
+        for (uint32_t i = 0; i < node.count; ++i)
+        {
+            if (leaf_visible[i])
+            {
+                visible.push_back(order_[node.first + i]);
+            }
+        }
+    }
+    return tested;
+}
+
+const Aabb &SceneBvh::Bounds() const
+{
+    static const Aabb kEmpty{};
+    return nodes_.empty() ? kEmpty : nodes_[0].box;
+}
+
+float SceneBvh::Cost() const
+{
+    if (nodes_.empty())
+        return 0.0f;
+    const float root_area = nodes_[0].box.HalfArea();
+    if (root_area <= 0.0f)
+        return 0.0f;
+    // Expected node visits plus leaf-box tests for a random query, relative to the root
+    float cost = 0.0f;
+    for (const Node &node : nodes_)
+    {
+        cost += node.box.HalfArea() * (node.left != 0 ? 1.0f : static_cast<float>(node.count));
+    }
+    return cost / root_area;
+}
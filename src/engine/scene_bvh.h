@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "bounds.h"
+#include "frustum.h"
+
+// Bounding volume hierarchy over world-space boxes ("proxies"), used by Scene for
+// frustum culling. Build splits at the centroid median of the longest axis; after
+// that, moved proxies are handled by refitting the boxes on their path to the
+// root, which is far cheaper than rebuilding but slowly loosens the tree. Callers
+// compare Cost() against BuildCost() to decide when a rebuild pays off.
+class SceneBvh
+{
+public:
+    static constexpr uint32_t kLeafSize = 4;
+
+    // Rebuilds from scratch; proxy ids are indices into `boxes`
+    void Build(const Aabb *boxes, size_t count);
+    void Clear() { Build(nullptr, 0); }
+
+    // Replaces a proxy's box. Ancestors are fixed up by the next Refit.
+    void Update(uint32_t proxy, const Aabb &box);
+    // Propagates every Update since the last call up the tree; returns the number of nodes changed
+    size_t Refit();
+
+    // Appends the ids of proxies whose boxes intersect `frustum`. Subtrees fully
+    // inside are accepted without testing their leaves. Returns the number of
+    // nodes tested.
+    size_t Cull(const Frustum &frustum, std::vector<uint32_t> &visible) const;
+
+    size_t ProxyCount() const { return order_.size(); }
+    size_t NodeCount() const { return nodes_.size(); }
+    const Aabb &Bounds() const;
+
+    // Surface-area cost of the current tree and of the tree as last built
+    float Cost() const;
+    float BuildCost() const { return build_cost_; }
+
+private:
+    struct Node
+    {
+        Aabb box;
+        uint32_t first = 0;  // proxies order_[first, first + count) lie under this node
+        uint32_t count = 0;
+        uint32_t left = 0;   // right child is left + 1; 0 marks a leaf (the root is never a child)
+        uint32_t parent = 0;
+        bool dirty = false;
+    };
+
+    // Fills nodes_[index] for order_[first, first + count) and splits it recursively
+    void BuildNode(uint32_t index, uint32_t first, uint32_t count);
+    void RecomputeLeaf(Node &node);
+    void SetSlot(uint32_t slot, const Aabb &box);
+
+    std::vector<Node> nodes_;
+    // Proxy ids in tree order, so every subtree is one contiguous range
+    std::vector<uint32_t> order_;
+    std::vector<uint32_t> slot_of_proxy_;
+    std::vector<uint32_t> leaf_of_proxy_;
+    // Proxy boxes indexed by tree position; the SoA copies feed Frustum::CullBoxes
+    std::vector<Aabb> boxes_;
+    std::vector<float> cx_, cy_, cz_, ex_, ey_, ez_;
+    std::vector<glm::vec3> centroids_;
+    std::vector<uint32_t> dirty_leaves_;
+    float build_cost_ = 0.0f;
+};
@@ -1,6 +1,10 @@
 #include "shader.h"
 
+#include "gl_state_cache.h"
+#include "uniform_blocks.h"
+
 #include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
 #include <stdexcept>
 #include <vector>
 #include <fstream>
@@ -43,7 +47,9 @@ Shader::Shader(const char *vertex_source, const char *fragment_source)
     glDeleteShader(fs);
 }
 
-Shader::Shader(Shader &&other) noexcept : program_id_(other.program_id_)
+Shader::Shader(Shader &&other) noexcept
+    : program_id_(other.program_id_), uniforms_(std::move(other.uniforms_)),
+      uniform_blocks_(std::move(other.uniform_blocks_))
 {
     other.program_id_ = 0;
 }
@@ -54,9 +60,12 @@ Shader &Shader::operator=(Shader &&other) noexcept
     {
         if (program_id_)
         {
+            GLStateCache::GetInstance().ForgetProgram(program_id_);
             glDeleteProgram(program_id_);
         }
         program_id_ = other.program_id_;
+        uniforms_ = std::move(other.uniforms_);
+        uniform_blocks_ = std::move(other.uniform_blocks_);
         other.program_id_ = 0;
     }
     return *this;
@@ -66,6 +75,7 @@ Shader::~Shader()
 {
     if (program_id_)
     {
+        GLStateCache::GetInstance().ForgetProgram(program_id_);
         glDeleteProgram(program_id_);
         program_id_ = 0;
     }
@@ -87,6 +97,70 @@ void Shader::link(GLuint vertex_shader, GLuint fragment_shader)
     glAttachShader(program_id_, fragment_shader);
     glLinkProgram(program_id_);
     ThrowIfLinkError(program_id_);
+    reflect();
+    UniformBlocks::BindProgram(program_id_);
+}
+
+void Shader::reflect()
+{
+    std::vector<UniformInfo> uniforms;
+    GLint count = 0;
+    GLint max_length = 0;
+    glGetProgramiv(program_id_, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(program_id_, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+    std::vector<GLchar> buffer(static_cast<size_t>(std::max(max_length, 1)));
+    for (GLint i = 0; i < count; ++i)
+    {
+        UniformInfo info;
+        GLsizei length = 0;
+        glGetActiveUniform(program_id_, static_cast<GLuint>(i), static_cast<GLsizei>(buffer.size()), &length,
+                           &info.array_size, &info.type, buffer.data());
+        info.name.assign(buffer.data(), static_cast<size_t>(length));
+        info.location = glGetUniformLocation(program_id_, info.name.c_str());
+        // Block members have no location; they are set through their buffer
+        if (info.location < 0)
+            continue;
+
+        // Arrays are reported as "name[0]"; any other name, struct members such
+        // as "lights[1].color" included, is registered exactly as reflected
+        const size_t size = info.name.size();
+        if (size <= 3 || info.name.compare(size - 3, 3, "[0]") != 0)
+        {
+            info.hash = HashUniformName(info.name.c_str());
+            uniforms.push_back(std::move(info));
+            continue;
+        }
+        const std::string base = info.name.substr(0, size - 3);
+        for (GLint element = 0; element < info.array_size; ++element)
+        {
+            UniformInfo entry = info;
+            entry.name = base + "[" + std::to_string(element) + "]";
+            entry.hash = HashUniformName(entry.name.c_str());
+            entry.array_size = 1;
+            if (element > 0)
+                entry.location = glGetUniformLocation(program_id_, entry.name.c_str());
+            uniforms.push_back(std::move(entry));
+        }
+        info.name = base;
+        info.hash = HashUniformName(base.c_str());
+        uniforms.push_back(std::move(info));
+    }
+    uniforms_.Build(std::move(uniforms));
+
+    uniform_blocks_.clear();
+    glGetProgramiv(program_id_, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+    glGetProgramiv(program_id_, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &max_length);
+    buffer.assign(static_cast<size_t>(std::max(max_length, 1)), '\0');
+    for (GLint i = 0; i < count; ++i)
+    {
+        UniformBlockInfo block;
+        GLsizei length = 0;
+        block.index = static_cast<GLuint>(i);
+        glGetActiveUniformBlockName(program_id_, block.index, static_cast<GLsizei>(buffer.size()), &length, buffer.data());
+        block.name.assign(buffer.data(), static_cast<size_t>(length));
+        glGetActiveUniformBlockiv(program_id_, block.index, GL_UNIFORM_BLOCK_DATA_SIZE, &block.data_size);
+        uniform_blocks_.push_back(std::move(block));
+    }
 }
 
 Shader Shader::FromFiles(const std::string &vertex_path, const std::string &fragment_path)
@@ -110,12 +184,7 @@ Shader Shader::FromFiles(const std::string &vertex_path, const std::string &frag
 
 void Shader::use() const
 {
-    static thread_local GLuint last_program = 0;
-    if (last_program != program_id_)
-    {
-        glUseProgram(program_id_);
-        last_program = program_id_;
-    }
+    GLStateCache::GetInstance().UseProgram(program_id_);
 }
 
 void Shader::set_mat4(const char *name, const glm::mat4 &value) const
@@ -144,14 +213,14 @@ void Shader::set_int(const char *name, int value) const
 
 GLint Shader::get_uniform_location_cached(const char *name) const
 {
-    auto it = uniform_location_cache_.find(name);
-    if (it != uniform_location_cache_.end())
-    {
-        return it->second;
-    }
-    GLint loc = glGetUniformLocation(program_id_, name);
-    uniform_location_cache_.emplace(name, loc);
-    return loc;
+    const UniformInfo *info = uniforms_.Find(name);
+    return info ? info->location : -1;
+}
+
+GLint Shader::location(UniformName name) const
+{
+    const UniformInfo *info = uniforms_.Find(name);
+    return info ? info->location : -1;
 }
 
 void Shader::set_mat4(GLint location, const glm::mat4 &value) const
@@ -1,9 +1,11 @@
 #pragma once
 
+#include <stdexcept>
 #include <string>
-#include <unordered_map>
+#include <vector>
 #include <glad/glad.h>
 #include <glm/glm.hpp>
+#include "uniform_table.h"
 
 class Shader
 {
@@ -28,8 +30,36 @@ public:
     void set_float(const char *name, float value) const;
     void set_int(const char *name, int value) const;
 
-    // Fast setters using cached uniform locations (call once you know the name)
+    // Location from the table of active uniforms read at link time (-1 if the
+    // program has no such uniform). No GL query and no allocation.
     GLint get_uniform_location_cached(const char *name) const;
+    GLint location(UniformName name) const;
+
+    // Typed handle for hot paths: resolve once (per renderer, material, ...)
+    // and set with no lookup. Throws std::runtime_error if the uniform exists
+    // with a GLSL type other than T.
+    template <typename T>
+    Uniform<T> uniform(UniformName name) const
+    {
+        Uniform<T> handle;
+        if (const UniformInfo *info = uniforms_.Find(name))
+        {
+            if (!UniformTypeTraits<T>::Matches(info->type))
+                throw std::runtime_error(std::string("Uniform type mismatch: ") + name.text);
+            handle.location = info->location;
+        }
+        return handle;
+    }
+    void set(Uniform<glm::mat4> uniform, const glm::mat4 &value) const { set_mat4(uniform.location, value); }
+    void set(Uniform<glm::vec3> uniform, const glm::vec3 &value) const { set_vec3(uniform.location, value); }
+    void set(Uniform<float> uniform, float value) const { set_float(uniform.location, value); }
+    void set(Uniform<int> uniform, int value) const { set_int(uniform.location, value); }
+
+    // What the program declares, as reported at link time
+    const std::vector<UniformInfo> &active_uniforms() const { return uniforms_.Entries(); }
+    const std::vector<UniformBlockInfo> &active_uniform_blocks() const { return uniform_blocks_; }
+
+    // Setters taking a location from get_uniform_location_cached or location()
     void set_mat4(GLint location, const glm::mat4 &value) const;
     void set_vec3(GLint location, const glm::vec3 &value) const;
     void set_vec3_array(GLint location, const glm::vec3 *values, int count) const;
@@ -39,9 +69,11 @@ public:
 private:
     GLuint compile(GLenum type, const char *source);
     void link(GLuint vertex_shader, GLuint fragment_shader);
+    // Fills the uniform and block tables from the linked program
+    void reflect();
 
 private:
     GLuint program_id_ = 0;
-    // Cache uniform name -> location
-    mutable std::unordered_map<std::string, GLint> uniform_location_cache_{};
+    UniformTable uniforms_;
+    std::vector<UniformBlockInfo> uniform_blocks_;
 };
@@ -1,16 +1,46 @@
 #version 410 core
 
+const int MAX_LIGHTS = 4;
+
 layout(location = 0) in vec3 aPos;
 layout(location = 1) in vec3 aNormal;
 layout(location = 2) in vec2 aUV;
 
 layout(location = 3) in mat4 aInstanceMatrix;
+layout(location = 7) in vec2 aPackedNormal;   // octahedral, as shorts (VertexFormat::Packed only)
 
-uniform mat4 uProjection; 
-uniform mat4 uView;
-uniform mat4 uModel;
-uniform bool u_isInstanced;
-uniform mat4 uLightSpaceMatrix;
+// Per-frame values, uploaded once per frame (mirrors UniformBlocks::Frame)
+layout(std140) uniform FrameBlock
+{
+    mat4 uView;
+    mat4 uProjection;
+    mat4 uLightSpaceMatrix;
+    vec3 uCamPos;                  // world-space cam position
+    int uLightCount;
+    vec3 uLightDirs[MAX_LIGHTS];   // world-space incoming light directions
+    vec3 uLightColors[MAX_LIGHTS];
+    float uShadowBias;
+    int uPCFSamples;
+};
+
+// Per-draw values (mirrors UniformBlocks::Draw)
+layout(std140) uniform DrawBlock
+{
+    mat4 uModel;
+    vec4 uPositionDecode;   // object position = xyz + aPos * w
+    bool u_isInstanced;
+    bool uPackedNormals;
+};
+
+vec3 DecodeOctahedral(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0)
+    {
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return normalize(n);
+}
 
 out vec3 vPosition; // world-space position
 out vec3 vNormal;   // world-space normal
@@ -29,10 +59,13 @@ void main()
         finalModelMatrix = uModel;
     }
 
-    gl_Position = uProjection * uView * finalModelMatrix * vec4(aPos, 1.0);
+    vec3 position = uPositionDecode.xyz + aPos * uPositionDecode.w;
+    vec3 normal = uPackedNormals ? DecodeOctahedral(max(aPackedNormal / 32767.0, -1.0)) : aNormal;
+
+    gl_Position = uProjection * uView * finalModelMatrix * vec4(position, 1.0);
 
-    vPosition = vec3(finalModelMatrix * vec4(aPos, 1.0));
-    vNormal = transpose(inverse(mat3(finalModelMatrix))) * aNormal;
+    vPosition = vec3(finalModelMatrix * vec4(position, 1.0));
+    vNormal = transpose(inverse(mat3(finalModelMatrix))) * normal;
     vLightSpacePosition = uLightSpaceMatrix * vec4(vPosition, 1.0);
 
     vUV = aUV;
@@ -9,23 +9,30 @@ in vec4 vLightSpacePosition;
 
 out vec4 FragColor;
 
-// Light uniforms (world-space incoming light directions)
-uniform sampler2D uShadowMap;
-uniform int uLightCount;
-uniform vec3 uLightDirs[MAX_LIGHTS];
-uniform vec3 uLightColors[MAX_LIGHTS];
-uniform vec3 uAmbient;
+// Per-frame values, uploaded once per frame (mirrors UniformBlocks::Frame)
+layout(std140) uniform FrameBlock
+{
+    mat4 uView;
+    mat4 uProjection;
+    mat4 uLightSpaceMatrix;
+    vec3 uCamPos;                  // world-space cam position
+    int uLightCount;
+    vec3 uLightDirs[MAX_LIGHTS];   // world-space incoming light directions
+    vec3 uLightColors[MAX_LIGHTS];
+    float uShadowBias;
+    int uPCFSamples;
+};
 
-// Material
+// Material (mirrors UniformBlocks::Material)
+layout(std140) uniform MaterialBlock
+{
+    vec3 uColor;       // tint
+    float uSmoothness; // [0..1]
+    vec3 uAmbient;
+    int uUseTexture;
+};
 uniform sampler2D uAlbedo;
-uniform int uUseTexture;
-uniform vec3 uColor;       // tint
-uniform float uSmoothness; // [0..1]
-uniform vec3 uCamPos;     // world-space cam position
-
-// Shadow quality settings
-uniform float uShadowBias;
-uniform int uPCFSamples;
+uniform sampler2D uShadowMap;
 
 // Enhanced shadow calculation with aggressive self-shadowing for neck areas
 float calculateEnhancedShadow(vec4 fragPosLightSpace, vec3 normal, vec3 lightDir) {
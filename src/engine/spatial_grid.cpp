@@ -0,0 +1,228 @@
+#include "spatial_grid.h"
+#include "game_object.h"
+#include "transform_system.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+// Cell coordinates are packed into 21 bits per axis for the hash key
+static constexpr int kCoordLimit = (1 << 20) - 1;
+
+SpatialGrid::SpatialGrid(float cell_size, float looseness)
+{
+    if (!(cell_size > 0.0f) || looseness < 0.0f)
+    {
+        throw std::runtime_error("SpatialGrid needs a positive cell size and non-negative looseness");
+    }
+    cell_size_ = cell_size;
+    inv_cell_size_ = 1.0f / cell_size;
+    loose_margin_ = looseness * cell_size;
+}
+
+void SpatialGrid::Rebuild(ComponentStorage<Transform> &transforms)
+{
+    entries_.assign(transforms.SlotCount(), Entry());
+    cells_.clear();
+    cell_lookup_.clear();
+    object_count_ = 0;
+    last_migrations_ = 0;
+    for (size_t i = 0; i < entries_.size(); ++i)
+    {
+        Refresh(transforms, static_cast<uint32_t>(i));
+    }
+}
+
+void SpatialGrid::Update(ComponentStorage<Transform> &transforms, const TransformSystem &system)
+{
+    last_migrations_ = 0;
+    if (entries_.size() < transforms.SlotCount())
+    {
+        entries_.resize(transforms.SlotCount());
+    }
+
+    // Removals first: a slot taken over by a new transform is also in the moved list
+    for (uint32_t slot : system.LastRemovedSlots())
+    {
+        if (slot < entries_.size() && entries_[slot].cell != kNoCell)
+            Remove(slot);
+    }
+    for (uint32_t slot : system.LastMovedSlots())
+    {
+        Refresh(transforms, slot);
+    }
+}
+
+void SpatialGrid::Refresh(ComponentStorage<Transform> &transforms, uint32_t slot)
+{
+    Entry &entry = entries_[slot];
+    if (!transforms.IsAlive(slot))
+    {
+        if (entry.cell != kNoCell)
+            Remove(slot);
+        return;
+    }
+
+    // A slot reused by a new transform since the last Update starts over
+    const uint32_t generation = transforms.Generation(slot);
+    if (entry.cell != kNoCell && entry.generation != generation)
+    {
+        Remove(slot);
+    }
+
+    const Transform &transform = transforms.At(slot);
+    const glm::mat4 &world = transform.LocalToWorld();
+    if (entry.cell != kNoCell && entry.world_version == transform.WorldVersion())
+        return;
+
+    entry.position = glm::vec3(world[3]);
+    entry.world_version = transform.WorldVersion();
+    entry.generation = generation;
+    entry.object = transform.Owner();
+    if (entry.cell == kNoCell)
+    {
+        Insert(slot);
+    }
+    else if (!InsideLooseCell(cells_[entry.cell], entry.position))
+    {
+        Remove(slot);
+        Insert(slot);
+        ++last_migrations_;
+    }
+}
+
+size_t SpatialGrid::QueryRadius(const glm::vec3 &center, float radius, GameObject **out, size_t capacity) const
+{
+    Aabb box;
+    box.min = center - glm::vec3(radius);
+    box.max = center + glm::vec3(radius);
+    const float radius_sq = radius * radius;
+    size_t found = 0;
+    auto test = [&](const Entry &entry)
+    {
+        const glm::vec3 d = entry.position - center;
+        if (d.x * d.x + d.y * d.y + d.z * d.z <= radius_sq)
+        {
+            if (found < capacity)
+                out[found] = entry.object;
+            ++found;
+        }
+    };
+    ForEachCandidate(box, test);
+    return found;
+}
+
+size_t SpatialGrid::QueryBox(const Aabb &box, GameObject **out, size_t capacity) const
+{
+    size_t found = 0;
+    auto test = [&](const Entry &entry)
+    {
+        const glm::vec3 &p = entry.position;
+        if (p.x >= box.min.x && p.y >= box.min.y && p.z >= box.min.z &&
+            p.x <= box.max.x && p.y <= box.max.y && p.z <= box.max.z)
+        {
+            if (found < capacity)
+                out[found] = entry.object;
+            ++found;
+        }
+    };
+    ForEachCandidate(box, test);
+    return found;
+}
+
+size_t SpatialGrid::QueryRadiusBatch(const glm::vec3 *centers, size_t count, float radius, GameObject **out,
+                                     size_t capacity, size_t *offsets) const
+{
+    size_t total = 0;
+    size_t written = 0;
+    offsets[0] = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        const size_t room = capacity - written;
+        const size_t found = QueryRadius(centers[i], radius, out + written, room);
+        written += std::min(found, room);
+        total += found;
+        offsets[i + 1] = written;
+    }
+    return total;
+}
+
+glm::ivec3 SpatialGrid::CellCoord(const glm::vec3 &position) const
+{
+    auto axis = [this](float v)
+    {
+        const float c = std::floor(v * inv_cell_size_);
+        return static_cast<int>(std::max(-float(kCoordLimit), std::min(float(kCoordLimit), c)));
+    };
+    return glm::ivec3(axis(position.x), axis(position.y), axis(position.z));
+}
+
+uint64_t SpatialGrid::CellKey(const glm::ivec3 &coord)
+{
+    const uint64_t mask = (uint64_t(1) << 21) - 1;
+    return ((uint64_t(uint32_t(coord.x)) & mask) << 42) | ((uint64_t(uint32_t(coord.y)) & mask) << 21) |
+           (uint64_t(uint32_t(coord.z)) & mask);
+}
+
+uint32_t SpatialGrid::FindOrAddCell(const glm::ivec3 &coord)
+{
+    const auto inserted = cell_lookup_.emplace(CellKey(coord), static_cast<uint32_t>(cells_.size()));
+    if (inserted.second)
+    {
+        cells_.emplace_back();
+        cells_.back().coord = coord;
+    }
+    return inserted.first->second;
+}
+
+void SpatialGrid::EraseCell(uint32_t cell)
+{
+    cell_lookup_.erase(CellKey(cells_[cell].coord));
+    const uint32_t last = static_cast<uint32_t>(cells_.size() - 1);
+    if (cell != last)
+    {
+        // The last cell fills the hole; its objects and lookup entry follow it
+        cells_[cell] = std::move(cells_[last]);
+        cell_lookup_[CellKey(cells_[cell].coord)] = cell;
+        for (uint32_t slot : cells_[cell].slots)
+        {
+            entries_[slot].cell = cell;
+        }
+    }
+    cells_.pop_back();
+}
+
+bool SpatialGrid::InsideLooseCell(const Cell &cell, const glm::vec3 &position) const
+{
+    const glm::vec3 min = glm::vec3(float(cell.coord.x), float(cell.coord.y), float(cell.coord.z)) * cell_size_ - glm::vec3(loose_margin_);
+    const glm::vec3 max = min + glm::vec3(cell_size_ + 2.0f * loose_margin_);
+    return position.x >= min.x && position.y >= min.y && position.z >= min.z &&
+           position.x < max.x && position.y < max.y && position.z < max.z;
+}
+
+void SpatialGrid::Insert(uint32_t slot)
+{
+    Entry &entry = entries_[slot];
+    entry.cell = FindOrAddCell(CellCoord(entry.position));
+    std::vector<uint32_t> &slots = cells_[entry.cell].slots;
+    entry.index_in_cell = static_cast<uint32_t>(slots.size());
+    slots.push_back(slot);
+    ++object_count_;
+}
+
+void SpatialGrid::Remove(uint32_t slot)
+{
+    Entry &entry = entries_[slot];
+    std::vector<uint32_t> &slots = cells_[entry.cell].slots;
+    const uint32_t moved = slots.back();
+    slots[entry.index_in_cell] = moved;
+    entries_[moved].index_in_cell = entry.index_in_cell;
+    slots.pop_back();
+    if (slots.empty())
+    {
+        EraseCell(entry.cell);
+    }
+    entry.cell = kNoCell;
+    --object_count_;
+}
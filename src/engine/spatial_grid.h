@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+#include "bounds.h"
+#include "component_storage.h"
+#include "transform.h"
+
+class GameObject;
+class TransformSystem;
+
+// Loose uniform hash grid over the world positions of every Transform, for
+// proximity queries. Objects are filed under the cell containing their position
+// and only migrate once they leave that cell grown by `looseness` * cell_size on
+// each side, so objects jittering across a boundary never churn the cell lists.
+// Queries widen their search by the same margin and then test exact positions.
+//
+// Query functions write into caller-provided buffers and never allocate. They
+// return the total number of matches; if that exceeds `capacity`, only the
+// first `capacity` were written.
+class SpatialGrid
+{
+public:
+    explicit SpatialGrid(float cell_size = 4.0f, float looseness = 0.25f);
+
+    SpatialGrid(const SpatialGrid &) = delete;
+    SpatialGrid &operator=(const SpatialGrid &) = delete;
+
+    // Files every live transform, dropping whatever the grid held before
+    void Rebuild(ComponentStorage<Transform> &transforms);
+    // Picks up added, destroyed and moved transforms from the slots `system`
+    // reported in its last Update; unmoved transforms are never visited. Call it
+    // after every TransformSystem::Update, or Rebuild instead.
+    void Update(ComponentStorage<Transform> &transforms, const TransformSystem &system);
+
+    size_t QueryRadius(const glm::vec3 &center, float radius, GameObject **out, size_t capacity) const;
+    size_t QueryBox(const Aabb &box, GameObject **out, size_t capacity) const;
+
+    // Runs `count` radius queries. Results of query i land in
+    // out[offsets[i], offsets[i + 1]), so `offsets` needs count + 1 entries.
+    // The query that runs past `capacity` keeps only the matches that fit, and
+    // every query after it gets an empty range.
+    size_t QueryRadiusBatch(const glm::vec3 *centers, size_t count, float radius, GameObject **out, size_t capacity,
+                            size_t *offsets) const;
+
+    float CellSize() const { return cell_size_; }
+    size_t ObjectCount() const { return object_count_; }
+    // Occupied cells; a cell is dropped as soon as its last object leaves
+    size_t CellCount() const { return cells_.size(); }
+    // Objects that changed cell during the last Update
+    size_t LastMigrationCount() const { return last_migrations_; }
+
+private:
+    static constexpr uint32_t kNoCell = ~uint32_t(0);
+
+    // One per Transform storage slot
+    struct Entry
+    {
+        glm::vec3 position{0.0f};
+        GameObject *object = nullptr;
+        uint32_t cell = kNoCell;
+        uint32_t index_in_cell = 0;
+        uint32_t generation = 0;
+        uint32_t world_version = 0;
+    };
+
+    struct Cell
+    {
+        glm::ivec3 coord{0, 0, 0};
+        std::vector<uint32_t> slots;
+    };
+
+    glm::ivec3 CellCoord(const glm::vec3 &position) const;
+    static uint64_t CellKey(const glm::ivec3 &coord);
+    uint32_t FindOrAddCell(const glm::ivec3 &coord);
+    void EraseCell(uint32_t cell);
+    bool InsideLooseCell(const Cell &cell, const glm::vec3 &position) const;
+    // Refreshes one slot from its transform, filing, migrating or dropping it
+    void Refresh(ComponentStorage<Transform> &transforms, uint32_t slot);
+    void Insert(uint32_t slot);
+    void Remove(uint32_t slot);
+
+    // Visits the entries filed in every cell that may hold a position inside `box`
+    template <typename Fn>
+    void ForEachCandidate(const Aabb &box, Fn &&fn) const
+    {
+        const glm::vec3 margin(loose_margin_);
+        const glm::ivec3 lo = CellCoord(box.min - margin);
+        const glm::ivec3 hi = CellCoord(box.max + margin);
+        const int64_t range_cells = int64_t(hi.x - lo.x + 1) * int64_t(hi.y - lo.y + 1) * int64_t(hi.z - lo.z + 1);
+        if (range_cells > static_cast<int64_t>(cells_.size()))
+        {
+            // Huge query: walking the occupied cells is cheaper than probing the range
+            for (const Cell &cell : cells_)
+            {
+                const glm::ivec3 &c = cell.coord;
+                if (c.x < lo.x || c.y < lo.y || c.z < lo.z || c.x > hi.x || c.y > hi.y || c.z > hi.z)
+                    continue;
+                for (uint32_t slot : cell.slots)
+                {
+                    fn(entries_[slot]);
+                }
+            }
+            return;
+        }
+        for (int z = lo.z; z <= hi.z; ++z)
+        {
+            for (int y = lo.y; y <= hi.y; ++y)
+            {
+                for (int x = lo.x; x <= hi.x; ++x)
+                {
+                    const auto it = cell_lookup_.find(CellKey(glm::ivec3(x, y, z)));
+                    if (it == cell_lookup_.end())
+                        continue;
+                    for (uint32_t slot : cells_[it->second].slots)
+                    {
+                        fn(entries_[slot]);
+                    }
+                }
+            }
+        }
+    }
+
+    float cell_size_;
+    float inv_cell_size_;
+    float loose_margin_;
+    std::vector<Entry> entries_;
+    std::vector<Cell> cells_;
+    std::unordered_map<uint64_t, uint32_t> cell_lookup_;
+    size_t object_count_ = 0;
+    size_t last_migrations_ = 0;
+};
@@ -0,0 +1,332 @@
+#include "static_batch_system.h"
+#include "frustum.h"
+#include "game_object.h"
+#include "job_system.h"
+#include "transform.h"
+
+#include <algorithm>
+#include <cmath>
+
+void StaticBatchSystem::SetCellSize(float cell_size)
+{
+    if (cell_size != cell_size_)
+    {
+        cell_size_ = cell_size;
+        regroup_ = true;
+    }
+}
+
+bool StaticBatchSystem::Eligible(const MeshRenderer &renderer)
+{
+    return renderer.is_static && !renderer.occluder && renderer.render_mode == MeshRenderer::RenderMode::Lit &&
+           renderer.mesh_ && renderer.mesh_->instance_id == 0 && !renderer.lod_group_ &&
+           (renderer.material_ || renderer.shader_);
+}
+
+StaticBatchSystem::DrawKey StaticBatchSystem::KeyOf(const MeshRenderer &renderer)
+{
+    DrawKey key;
+    if (renderer.material_)
+    {
+        key.material = renderer.material_.get();
+    }
+    else
+    {
+        key.shader = renderer.shader_.get();
+        key.texture = renderer.diffuse_texture.get();
+        key.color = renderer.color;
+        key.smoothness = renderer.smoothness;
+    }
+    key.ambient_multiplier = renderer.material_ambient_multiplier;
+    return key;
+}
+
+const Transform *StaticBatchSystem::TransformOf(const MeshRenderer &renderer)
+{
+    return renderer.Owner() ? renderer.Owner()->GetComponent<Transform>() : nullptr;
+}
+
+bool StaticBatchSystem::Unchanged(const MeshRenderer &renderer, const Member &member) const
+{
+    if (!Eligible(renderer) || renderer.mesh_.get() != member.mesh || TransformOf(renderer) != member.transform)
+        return false;
+    if (member.transform)
+    {
+        // Resolves a pending world matrix, which bumps the version if it moved
+        member.transform->LocalToWorld();
+        if (member.transform->WorldVersion() != member.world_version)
+            return false;
+    }
+    return KeyOf(renderer).Tie() == member.key.Tie();
+}
+
+void StaticBatchSystem::MarkDirty(uint32_t batch)
+{
+    if (!batches_[batch].dirty)
+    {
+        batches_[batch].dirty = true;
+        dirty_batches_.push_back(batch);
+    }
+}
+
+void StaticBatchSystem::Add(MeshRenderer &renderer, uint32_t slot, uint32_t generation)
+{
+    Member &member = members_[slot];
+    member.generation = generation;
+    member.mesh = renderer.mesh_.get();
+    member.transform = TransformOf(renderer);
+    member.key = KeyOf(renderer);
+    glm::mat4 model(1.0f);
+    if (member.transform)
+    {
+        model = member.transform->LocalToWorld();
+        member.world_version = member.transform->WorldVersion();
+    }
+
+    const glm::vec3 center = member.mesh->Bounds().Transformed(model).Center() / cell_size_;
+    const BatchKey key{member.key, glm::ivec3(static_cast<int>(std::floor(center.x)), static_cast<int>(std::floor(center.y)),
+                                              static_cast<int>(std::floor(center.z)))};
+    auto found = batch_lookup_.find(key);
+    if (found == batch_lookup_.end())
+    {
+        found = batch_lookup_.emplace(key, static_cast<uint32_t>(batches_.size())).first;
+        batches_.emplace_back();
+        batches_.back().key = key;
+    }
+    member.batch = found->second;
+    batches_[member.batch].slots.push_back(slot);
+    MarkDirty(member.batch);
+}
+
+void StaticBatchSystem::Update(ComponentStorage<MeshRenderer> &renderers, JobSystem *jobs)
+{
+    stats_.rebuilt = 0;
+    if (regroup_)
+    {
+        // Every member is re-added under its new cell below
+        for (Member &member : members_)
+        {
+            member.batch = kNoBatch;
+        }
+        batches_.clear();
+        batch_lookup_.clear();
+        dirty_batches_.clear();
+        regroup_ = false;
+    }
+    if (members_.size() < renderers.SlotCount())
+    {
+        members_.resize(renderers.SlotCount());
+    }
+
+    for (size_t i = 0; i < members_.size(); ++i)
+    {
+        Member &member = members_[i];
+        MeshRenderer *renderer = i < renderers.SlotCount() && renderers.IsAlive(i) ? &renderers.At(i) : nullptr;
+        const uint32_t generation = renderer ? renderers.Generation(i) : 0;
+        if (member.batch != kNoBatch)
+        {
+            if (renderer && generation == member.generation && Unchanged(*renderer, member))
+                continue;
+            // Left its batch; re-added below (possibly to the same one) if still eligible
+            MarkDirty(member.batch);
+            member.batch = kNoBatch;
+        }
+        if (!renderer)
+            continue;
+        if (Eligible(*renderer))
+        {
+            Add(*renderer, static_cast<uint32_t>(i), generation);
+        }
+        renderer->static_batched_ = member.batch != kNoBatch;
+    }
+
+    if (!dirty_batches_.empty())
+    {
+        Rebuild(renderers, jobs);
+    }
+}
+
+void StaticBatchSystem::Rebuild(ComponentStorage<MeshRenderer> &renderers, JobSystem *jobs)
+{
+    // One task per member of a dirty batch, each writing its own slice of the
+    // batch's vertex and index arrays
+    struct Task
+    {
+        const Mesh *mesh;
+        const Transform *transform;
+        uint32_t first_vertex;
+        uint32_t first_index;
+        std::vector<MeshVertex> *vertices;
+        std::vector<unsigned int> *indices;
+        Range *range;
+    };
+    std::vector<Task> tasks;
+    std::vector<std::vector<MeshVertex>> vertices(dirty_batches_.size());
+    std::vector<std::vector<unsigned int>> indices(dirty_batches_.size());
+    // A batch is packed only if every mesh in it is
+    std::vector<char> packed(dirty_batches_.size(), 1);
+
+    for (size_t d = 0; d < dirty_batches_.size(); ++d)
+    {
+        const uint32_t index = dirty_batches_[d];
+        Batch &batch = batches_[index];
+        // Keep the slots still assigned here; a slot that left and came back is listed twice
+        std::sort(batch.slots.begin(), batch.slots.end());
+        batch.slots.erase(std::unique(batch.slots.begin(), batch.slots.end()), batch.slots.end());
+        batch.slots.erase(std::remove_if(batch.slots.begin(), batch.slots.end(),
+                                         [&](uint32_t slot)
+                                         { return members_[slot].batch != index; }),
+                          batch.slots.end());
+
+        batch.ranges.resize(batch.slots.size());
+        size_t vertex_count = 0;
+        size_t index_count = 0;
+        for (size_t m = 0; m < batch.slots.size(); ++m)
+        {
+            const Member &member = members_[batch.slots[m]];
+            tasks.push_back(Task{member.mesh, member.transform, static_cast<uint32_t>(vertex_count),
+                                 static_cast<uint32_t>(index_count), &vertices[d], &indices[d], &batch.ranges[m]});
+            packed[d] = packed[d] && member.mesh->Format() == VertexFormat::Packed;
+            vertex_count += member.mesh->vertices.size();
+            index_count += member.mesh->indices.size();
+        }
+        vertices[d].resize(vertex_count);
+        indices[d].resize(index_count);
+    }
+
+    auto transform_range = [&tasks](size_t begin, size_t end)
+    {
+        for (size_t t = begin; t < end; ++t)
+        {
+            const Task &task = tasks[t];
+            const glm::mat4 model = task.transform ? task.transform->LocalToWorld() : glm::mat4(1.0f);
+            // Once per object rather than per vertex
+            const glm::mat3 normal_matrix = glm::transpose(glm::inverse(glm::mat3(model)));
+            MeshVertex *out = task.vertices->data() + task.first_vertex;
+            for (const MeshVertex &v : task.mesh->vertices)
+            {
+                out->position = glm::vec3(model * glm::vec4(v.position, 1.0f));
+                out->normal = normal_matrix * v.normal;
+                out->uv = v.uv;
+                ++out;
+            }
+            unsigned int *out_index = task.indices->data() + task.first_index;
+            for (unsigned int i : task.mesh->indices)
+            {
+                *out_index++ = i + task.first_vertex;
+            }
+            task.range->first_index = task.first_index;
+            task.range->index_count = static_cast<uint32_t>(task.mesh->indices.size());
+            task.range->bounds = task.mesh->Bounds().Transformed(model);
+        }
+    };
+    if (jobs)
+    {
+        jobs->ParallelFor(tasks.size(), 16, transform_range);
+    }
+    else
+    {
+        transform_range(0, tasks.size());
+    }
+
+    for (size_t d = 0; d < dirty_batches_.size(); ++d)
+    {
+        Batch &batch = batches_[dirty_batches_[d]];
+        batch.dirty = false;
+        batch.mesh.reset();
+        batch.source = nullptr;
+        batch.bounds = Aabb{};
+        if (batch.slots.empty())
+            continue;
+        for (const Range &range : batch.ranges)
+        {
+            batch.bounds.Expand(range.bounds);
+        }
+        batch.mesh = std::make_unique<Mesh>(vertices[d], indices[d], batch.bounds,
+                                            packed[d] ? VertexFormat::Packed : VertexFormat::Float);
+        batch.source = &renderers.At(batch.slots.front());
+    }
+    stats_.rebuilt = dirty_batches_.size();
+    dirty_batches_.clear();
+
+    stats_.batches = 0;
+    stats_.objects = 0;
+    for (const Batch &batch : batches_)
+    {
+        stats_.batches += batch.mesh ? 1 : 0;
+        stats_.objects += batch.slots.size();
+    }
+}
+
+void StaticBatchSystem::Gather(const glm::mat4 &projection, const glm::mat4 &view, bool cull, RenderQueue &queue)
+{
+    stats_.cells_culled = 0;
+    stats_.objects_culled = 0;
+    stats_.ranges = 0;
+    const Frustum frustum = Frustum::FromMatrix(projection * view);
+    for (const Batch &batch : batches_)
+    {
+        if (!batch.mesh)
+            continue;
+        const Frustum::Result result = cull ? frustum.Classify(batch.bounds) : Frustum::Result::Inside;
+        if (result == Frustum::Result::Outside)
+        {
+            ++stats_.cells_culled;
+            continue;
+        }
+
+        DrawPacket packet;
+        float view_depth = 0.0f;
+        if (!batch.source->BuildDrawPacket(projection, view, packet, view_depth))
+            continue;
+        packet.mesh = batch.mesh.get();
+        packet.model = glm::mat4(1.0f);
+        view_depth = -(view * glm::vec4(batch.bounds.Center(), 1.0f)).z;
+        if (result == Frustum::Result::Inside)
+        {
+            queue.Push(packet, view_depth);
+            ++stats_.ranges;
+            continue;
+        }
+
+        // Partly in view: one range per run of consecutive visible members
+        const size_t count = batch.ranges.size();
+        for (size_t i = 0; i < count;)
+        {
+            if (!frustum.Intersects(batch.ranges[i].bounds))
+            {
+                ++stats_.objects_culled;
+                ++i;
+                continue;
+            }
+            size_t end = i + 1;
+            while (end < count && frustum.Intersects(batch.ranges[end].bounds))
+            {
+                ++end;
+            }
+            const Range &last = batch.ranges[end - 1];
+            packet.first_index = batch.ranges[i].first_index;
+            packet.index_count = last.first_index + last.index_count - packet.first_index;
+            queue.Push(packet, view_depth);
+            ++stats_.ranges;
+            i = end;
+        }
+    }
+}
+
+void StaticBatchSystem::Clear(ComponentStorage<MeshRenderer> &renderers)
+{
+    for (size_t i = 0; i < members_.size(); ++i)
+    {
+        if (members_[i].batch != kNoBatch && i < renderers.SlotCount() && renderers.IsAlive(i) &&
+            renderers.Generation(i) == members_[i].generation)
+        {
+            renderers.At(i).static_batched_ = false;
+        }
+    }
+    members_.clear();
+    batches_.clear();
+    batch_lookup_.clear();
+    dirty_batches_.clear();
+    stats_ = StaticBatchStats{};
+}
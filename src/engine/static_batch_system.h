@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <tuple>
+#include <vector>
+#include <glm/glm.hpp>
+#include "bounds.h"
+#include "component_storage.h"
+#include "mesh_renderer.h"
+#include "render_queue.h"
+
+class JobSystem;
+class Transform;
+
+// What the last StaticBatchSystem::Update and Gather did
+struct StaticBatchStats
+{
+    size_t batches = 0;          // batches holding at least one renderer
+    size_t objects = 0;          // renderers drawn through them
+    size_t rebuilt = 0;          // batches re-merged by the last Update
+    size_t cells_culled = 0;     // batches skipped whole by the frustum
+    size_t objects_culled = 0;   // members of partly visible batches outside the frustum
+    size_t ranges = 0;           // index ranges queued for drawing
+};
+
+// Merges Lit MeshRenderers flagged is_static into one world-space mesh per
+// material and spatial cell. Each batch remembers the index range and world
+// bounds of its members, so a cell the frustum cuts through draws only the
+// runs of members in view. Members are checked every Update; one that moves,
+// switches mesh or material, loses the flag or is destroyed rebuilds just the
+// batch it was in. Renderers with a LOD group or flagged as occluders are
+// left to the per-object path.
+class StaticBatchSystem
+{
+public:
+    explicit StaticBatchSystem(float cell_size = 32.0f) : cell_size_(cell_size) {}
+
+    // Regroups every batch on the next Update
+    void SetCellSize(float cell_size);
+    float GetCellSize() const { return cell_size_; }
+
+    // Takes in newly flagged renderers and rebuilds dirty batches. Vertices are
+    // transformed on `jobs` (optional); meshes are uploaded on the calling thread.
+    void Update(ComponentStorage<MeshRenderer> &renderers, JobSystem *jobs = nullptr);
+    // Queues the batches in view; with `cull` off every batch is queued whole
+    void Gather(const glm::mat4 &projection, const glm::mat4 &view, bool cull, RenderQueue &queue);
+    // Drops every batch; the members go back to being drawn one by one
+    void Clear(ComponentStorage<MeshRenderer> &renderers);
+
+    const StaticBatchStats &LastStats() const { return stats_; }
+
+private:
+    static constexpr uint32_t kNoBatch = ~uint32_t(0);
+
+    // Everything a draw depends on apart from mesh and matrix. Renderers with a
+    // Material are keyed by it alone, the rest by their inline values.
+    struct DrawKey
+    {
+        const void *material = nullptr;
+        const void *shader = nullptr;
+        const void *texture = nullptr;
+        glm::vec3 color{0.0f};
+        float smoothness = 0.0f;
+        glm::vec3 ambient_multiplier{0.0f};
+
+        auto Tie() const
+        {
+            return std::tie(material, shader, texture, color.x, color.y, color.z, smoothness,
+                            ambient_multiplier.x, ambient_multiplier.y, ambient_multiplier.z);
+        }
+    };
+
+    struct BatchKey
+    {
+        DrawKey draw;
+        glm::ivec3 cell;
+
+        bool operator<(const BatchKey &other) const
+        {
+            return std::tuple_cat(draw.Tie(), std::tie(cell.x, cell.y, cell.z)) <
+                   std::tuple_cat(other.draw.Tie(), std::tie(other.cell.x, other.cell.y, other.cell.z));
+        }
+    };
+
+    // Per renderer storage slot
+    struct Member
+    {
+        uint32_t batch = kNoBatch;
+        uint32_t generation = 0;
+        const Mesh *mesh = nullptr;
+        const Transform *transform = nullptr;
+        uint32_t world_version = 0;
+        DrawKey key;
+    };
+
+    struct Range
+    {
+        uint32_t first_index;
+        uint32_t index_count;
+        Aabb bounds;
+    };
+
+    struct Batch
+    {
+        BatchKey key;
+        // Slots assigned since the last rebuild; ones that have left are dropped by it
+        std::vector<uint32_t> slots;
+        std::vector<Range> ranges;   // parallel to slots after a rebuild
+        std::unique_ptr<Mesh> mesh;
+        // Member whose material state the batch draws with
+        MeshRenderer *source = nullptr;
+        Aabb bounds;
+        bool dirty = false;
+    };
+
+    static bool Eligible(const MeshRenderer &renderer);
+    static DrawKey KeyOf(const MeshRenderer &renderer);
+    static const Transform *TransformOf(const MeshRenderer &renderer);
+    bool Unchanged(const MeshRenderer &renderer, const Member &member) const;
+    void Add(MeshRenderer &renderer, uint32_t slot, uint32_t generation);
+    void MarkDirty(uint32_t batch);
+    void Rebuild(ComponentStorage<MeshRenderer> &renderers, JobSystem *jobs);
+
+    float cell_size_;
+    bool regroup_ = false;
+    std::vector<Member> members_;
+    std::vector<Batch> batches_;
+    std::map<BatchKey, uint32_t> batch_lookup_;
+    std::vector<uint32_t> dirty_batches_;
+    StaticBatchStats stats_;
+};
@@ -0,0 +1,257 @@
+#include "stream_buffer.h"
+
+#include "gl_capabilities.h"
+
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+// GL 4.4 / ARB_buffer_storage, not in the 4.1 loader
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+typedef void(APIENTRYP PFNGLBUFFERSTORAGEPROC_)(GLenum target, GLsizeiptr size, const void *data, GLbitfield flags);
+static PFNGLBUFFERSTORAGEPROC_ s_bufferStorage = nullptr;
+
+bool StreamBuffer::PersistentMappingSupported()
+{
+    static const bool supported = []()
+    {
+        const bool available =
+            GLCapabilities::VersionAtLeast(4, 4) || GLCapabilities::HasExtension("GL_ARB_buffer_storage");
+        if (available)
+        {
+            s_bufferStorage = reinterpret_cast<PFNGLBUFFERSTORAGEPROC_>(glfwGetProcAddress("glBufferStorage"));
+        }
+        return s_bufferStorage != nullptr;
+    }();
+    return supported;
+}
+
+StreamBuffer::StreamBuffer(StreamBuffer &&other) noexcept
+    : target_(other.target_), alignment_(other.alignment_), buffer_(other.buffer_), mapped_(other.mapped_),
+      persistent_(other.persistent_), region_(other.region_), head_(other.head_), retired_(std::move(other.retired_)),
+      staging_(std::move(other.staging_)), pending_offset_(other.pending_offset_), pending_bytes_(other.pending_bytes_),
+      stats_(other.stats_)
+{
+    std::copy(std::begin(other.fences_), std::end(other.fences_), std::begin(fences_));
+    std::fill(std::begin(other.fences_), std::end(other.fences_), nullptr);
+    other.buffer_ = 0;
+    other.mapped_ = nullptr;
+    other.retired_.clear();
+}
+
+StreamBuffer &StreamBuffer::operator=(StreamBuffer &&other) noexcept
+{
+    if (this != &other)
+    {
+        Release();
+        target_ = other.target_;
+        alignment_ = other.alignment_;
+        buffer_ = other.buffer_;
+        mapped_ = other.mapped_;
+        persistent_ = other.persistent_;
+        region_ = other.region_;
+        head_ = other.head_;
+        std::copy(std::begin(other.fences_), std::end(other.fences_), std::begin(fences_));
+        retired_ = std::move(other.retired_);
+        staging_ = std::move(other.staging_);
+        pending_offset_ = other.pending_offset_;
+        pending_bytes_ = other.pending_bytes_;
+        stats_ = other.stats_;
+        std::fill(std::begin(other.fences_), std::end(other.fences_), nullptr);
+        other.buffer_ = 0;
+        other.mapped_ = nullptr;
+        other.retired_.clear();
+    }
+    return *this;
+}
+
+StreamBuffer::~StreamBuffer()
+{
+    Release();
+}
+
+void StreamBuffer::Release()
+{
+    for (GLsync &fence : fences_)
+    {
+        if (fence)
+            glDeleteSync(fence);
+        fence = nullptr;
+    }
+    for (const Retired &retired : retired_)
+    {
+        if (retired.fence)
+            glDeleteSync(retired.fence);
+        glDeleteBuffers(1, &retired.buffer);
+    }
+    retired_.clear();
+    if (buffer_)
+    {
+        // Deleting a mapped buffer unmaps it
+        glDeleteBuffers(1, &buffer_);
+        buffer_ = 0;
+    }
+    mapped_ = nullptr;
+}
+
+void StreamBuffer::Grow(size_t bytes)
+{
+    size_t capacity = std::max<size_t>(stats_.capacity * 2, 64 * 1024);
+    while (capacity < bytes)
+        capacity *= 2;
+    // Keeps every region start, and so every offset handed out, aligned
+    capacity = (capacity + alignment_ - 1) / alignment_ * alignment_;
+
+    // Draws issued this frame may still read the old buffer; NextFrame fences it
+    if (buffer_)
+    {
+        retired_.push_back(Retired{buffer_, nullptr});
+        buffer_ = 0;
+        mapped_ = nullptr;
+    }
+    for (GLsync &fence : fences_)
+    {
+        if (fence)
+            glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    persistent_ = PersistentMappingSupported();
+    stats_.persistent = persistent_;
+    stats_.capacity = capacity;
+    region_ = 0;
+    head_ = 0;
+    glGenBuffers(1, &buffer_);
+    glBindBuffer(target_, buffer_);
+    if (persistent_)
+    {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        const GLsizeiptr size = static_cast<GLsizeiptr>(capacity * kFrames);
+        s_bufferStorage(target_, size, nullptr, flags);
+        mapped_ = static_cast<char *>(glMapBufferRange(target_, 0, size, flags));
+        if (!mapped_)
+        {
+            // Immutable storage cannot be respecified; start over with a plain buffer
+            glDeleteBuffers(1, &buffer_);
+            glGenBuffers(1, &buffer_);
+            glBindBuffer(target_, buffer_);
+            persistent_ = false;
+            stats_.persistent = false;
+        }
+    }
+    if (!persistent_)
+    {
+        glBufferData(target_, static_cast<GLsizeiptr>(capacity), nullptr, GL_STREAM_DRAW);
+    }
+}
+
+void StreamBuffer::WaitForRegion()
+{
+    GLsync &fence = fences_[region_];
+    if (!fence)
+        return;
+    GLenum status = glClientWaitSync(fence, 0, 0);
+    if (status == GL_TIMEOUT_EXPIRED)
+    {
+        ++stats_.waits;
+        do
+        {
+            status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        } while (status == GL_TIMEOUT_EXPIRED);
+    }
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+void *StreamBuffer::Map(size_t bytes, size_t &offset)
+{
+    size_t start = (head_ + alignment_ - 1) / alignment_ * alignment_;
+    if (!buffer_ || start + bytes > stats_.capacity)
+    {
+        Grow(bytes);
+        start = 0;
+    }
+    else if (head_ == 0)
+    {
+        if (persistent_)
+        {
+            WaitForRegion();
+        }
+        else
+        {
+            // Orphan: draws still reading last frame's data keep the old storage
+            glBindBuffer(target_, buffer_);
+            glBufferData(target_, static_cast<GLsizeiptr>(stats_.capacity), nullptr, GL_STREAM_DRAW);
+        }
+    }
+    head_ = start + bytes;
+    stats_.used = head_;
+
+    if (persistent_)
+    {
+        offset = static_cast<size_t>(region_) * stats_.capacity + start;
+        return mapped_ + offset;
+    }
+    offset = start;
+    pending_offset_ = start;
+    pending_bytes_ = bytes;
+    if (staging_.size() < bytes)
+        staging_.resize(bytes);
+    return staging_.data();
+}
+
+void StreamBuffer::Unmap()
+{
+    // Persistent writes are coherent; only the fallback has anything to send
+    if (persistent_ || pending_bytes_ == 0)
+        return;
+    glBindBuffer(target_, buffer_);
+    glBufferSubData(target_, static_cast<GLintptr>(pending_offset_), static_cast<GLsizeiptr>(pending_bytes_), staging_.data());
+    pending_bytes_ = 0;
+}
+
+size_t StreamBuffer::Upload(const void *data, size_t bytes)
+{
+    size_t offset = 0;
+    std::memcpy(Map(bytes, offset), data, bytes);
+    Unmap();
+    glBindBuffer(target_, buffer_);
+    return offset;
+}
+
+void StreamBuffer::NextFrame()
+{
+    if (persistent_ && head_ > 0)
+    {
+        fences_[region_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        region_ = (region_ + 1) % kFrames;
+    }
+    head_ = 0;
+    stats_.used = 0;
+
+    // A retired buffer goes once the GPU has passed every draw of the frame it was retired in
+    for (size_t i = 0; i < retired_.size();)
+    {
+        Retired &retired = retired_[i];
+        if (!retired.fence)
+        {
+            retired.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            ++i;
+            continue;
+        }
+        const GLenum status = glClientWaitSync(retired.fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+        {
+            ++i;
+            continue;
+        }
+        glDeleteSync(retired.fence);
+        glDeleteBuffers(1, &retired.buffer);
+        retired = retired_.back();
+        retired_.pop_back();
+    }
+}
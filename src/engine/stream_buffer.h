@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include <glad/glad.h>
+
+// A GL buffer for data rewritten every frame (instance matrices and the like),
+// used as a ring of kFrames regions: frame N writes region N % kFrames while
+// the GPU may still be reading the two before it.
+//
+// With GL 4.4 or ARB_buffer_storage the buffer is persistently mapped and
+// written in place; a fence placed at NextFrame guards each region, and Map
+// only waits on it if the GPU is a full ring behind. Without it, the first
+// write of a frame orphans the buffer and data goes up with glBufferSubData.
+//
+// Offsets returned this frame belong to the buffer Id() returned right after
+// the call: running out of room moves to a larger buffer, and the old one is
+// fenced at the next NextFrame and deleted once that fence has signaled.
+class StreamBuffer
+{
+public:
+    static constexpr int kFrames = 3;
+
+    struct Stats
+    {
+        bool persistent = false;
+        size_t capacity = 0;   // bytes per frame region
+        size_t used = 0;       // bytes written into the current region
+        size_t waits = 0;      // Maps that had to block on a fence
+    };
+
+    // `alignment` applies to every offset handed out (e.g.
+    // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT for uniform ranges)
+    explicit StreamBuffer(GLenum target = GL_ARRAY_BUFFER, size_t alignment = 16)
+        : target_(target), alignment_(alignment) {}
+    StreamBuffer(const StreamBuffer &) = delete;
+    StreamBuffer &operator=(const StreamBuffer &) = delete;
+    StreamBuffer(StreamBuffer &&other) noexcept;
+    StreamBuffer &operator=(StreamBuffer &&other) noexcept;
+    ~StreamBuffer();
+
+    // Space for `bytes` in this frame's region: returns where to write them and
+    // sets `offset` to their byte offset in Id(). Finish with Unmap before
+    // drawing from them or mapping again.
+    void *Map(size_t bytes, size_t &offset);
+    void Unmap();
+    // Map + copy + Unmap; returns the byte offset. Leaves the buffer bound to the target.
+    size_t Upload(const void *data, size_t bytes);
+    // Closes the current frame's writes (fencing them on the persistent path)
+    // and moves on to the next region. Call once per frame, e.g. at its start.
+    void NextFrame();
+
+    GLuint Id() const { return buffer_; }
+    const Stats &GetStats() const { return stats_; }
+
+    // GL 4.4 or ARB_buffer_storage with a loadable glBufferStorage; checked once
+    // per process, with the context current
+    static bool PersistentMappingSupported();
+
+private:
+    struct Retired
+    {
+        GLuint buffer;
+        GLsync fence;   // placed at the first NextFrame after retiring; null until then
+    };
+
+    void Release();
+    // Replaces the buffer with one holding at least `bytes` per region
+    void Grow(size_t bytes);
+    void WaitForRegion();
+
+    GLenum target_;
+    size_t alignment_;
+    GLuint buffer_ = 0;
+    char *mapped_ = nullptr;   // whole ring, persistent path only
+    bool persistent_ = false;
+    int region_ = 0;
+    size_t head_ = 0;          // next free byte in the region
+    GLsync fences_[kFrames] = {};
+    std::vector<Retired> retired_;
+    // Fallback path: writes are staged here until Unmap
+    std::vector<char> staging_;
+    size_t pending_offset_ = 0;
+    size_t pending_bytes_ = 0;
+    Stats stats_;
+};
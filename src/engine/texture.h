@@ -4,6 +4,8 @@
 #include <glm/glm.hpp>
 #include <string>
 
+#include "gl_state_cache.h"
+
 // Lightweight RAII wrapper around an OpenGL texture object name.
 // Non-copyable, moveable. Automatically deletes the GL texture on destruction.
 class Texture
@@ -54,6 +56,7 @@ public:
     {
         if (id_ != 0)
         {
+            GLStateCache::GetInstance().ForgetTexture(id_);
             glDeleteTextures(1, &id_);
             id_ = 0;
         }
@@ -63,8 +66,7 @@ public:
     void bind(GLenum target = GL_TEXTURE_2D, GLuint unit = 0) const
     {
         if (id_ == 0) return;
-        glActiveTexture(GL_TEXTURE0 + unit);
-        glBindTexture(target, id_);
+        GLStateCache::GetInstance().BindTexture(unit, target, id_);
     }
 
     // Loads image from disk and computes its average color in linear [0..1].
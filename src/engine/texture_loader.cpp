@@ -2,6 +2,7 @@
 
 #include <SOIL2.h>
 #include <stdexcept>
+#include "engine/gl_state_cache.h"
 #include "engine/texture.h"
 
 void TextureLoader::LoadTexture2DFromFile(const std::string& path, bool generate_mipmaps, GLuint& tex_id)
@@ -19,7 +20,7 @@ void TextureLoader::LoadTexture2DFromFile(const std::string& path, bool generate
     } else {
         tex = tex_id;
     }
-    glBindTexture(GL_TEXTURE_2D, tex);
+    GLStateCache::GetInstance().BindTexture(0, GL_TEXTURE_2D, tex);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
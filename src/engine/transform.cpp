@@ -1,16 +1,174 @@
 #include "transform.h"
+#include "game_object.h"
+#include "scene.h"
+#include "transform_system.h"
 
-#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
 
-glm::mat4 Transform::LocalToWorld() const
+void Transform::SetPosition(const glm::vec3 &position)
 {
-    glm::mat4 m(1.0f);
-    m = glm::translate(m, position);
-    m = glm::rotate(m, glm::radians(rotation_euler.y), glm::vec3(0, 1, 0));
-    m = glm::rotate(m, glm::radians(rotation_euler.x), glm::vec3(1, 0, 0));
-    m = glm::rotate(m, glm::radians(rotation_euler.z), glm::vec3(0, 0, 1));
-    m = glm::scale(m, scale);
-    return m;
+    if (position_ == position)
+        return;
+    position_ = position;
+    MarkLocalDirty();
 }
 
+void Transform::SetRotation(const glm::quat &rotation)
+{
+    if (rotation_ == rotation)
+        return;
+    rotation_ = rotation;
+    MarkLocalDirty();
+}
+
+void Transform::SetScale(const glm::vec3 &scale)
+{
+    if (scale_ == scale)
+        return;
+    scale_ = scale;
+    MarkLocalDirty();
+}
+
+void Transform::SetEulerAngles(const glm::vec3 &degrees)
+{
+    const glm::vec3 r = glm::radians(degrees);
+    SetRotation(glm::angleAxis(r.y, glm::vec3(0, 1, 0)) *
+                glm::angleAxis(r.x, glm::vec3(1, 0, 0)) *
+                glm::angleAxis(r.z, glm::vec3(0, 0, 1)));
+}
+
+glm::vec3 Transform::GetEulerAngles() const
+{
+    // Inverse of R = Ry * Rx * Rz (glm matrices are indexed [column][row])
+    const glm::mat3 m = glm::mat3_cast(rotation_);
+    const float x = std::asin(glm::clamp(-m[2][1], -1.0f, 1.0f));
+    const float y = std::atan2(m[2][0], m[2][2]);
+    const float z = std::atan2(m[0][1], m[1][1]);
+    return glm::degrees(glm::vec3(x, y, z));
+}
+
+void Transform::SetParent(Transform *parent, bool keep_world_transform)
+{
+    if (parent == parent_)
+        return;
+    // A cycle would make LocalToWorld and MarkWorldDirty recurse forever
+    for (const Transform *ancestor = parent; ancestor; ancestor = ancestor->parent_)
+    {
+        if (ancestor == this)
+            return;
+    }
+
+    const glm::mat4 world = LocalToWorld();
+
+    if (parent_)
+    {
+        auto &siblings = parent_->children_;
+        siblings.erase(std::remove(siblings.begin(), siblings.end(), this), siblings.end());
+    }
+    parent_ = parent;
+    if (parent_)
+    {
+        parent_->children_.push_back(this);
+    }
+
+    if (keep_world_transform)
+    {
+        // Decompose the new local matrix (shear is discarded)
+        const glm::mat4 local = parent_ ? glm::inverse(parent_->LocalToWorld()) * world : world;
+        glm::vec3 axes[3] = {glm::vec3(local[0]), glm::vec3(local[1]), glm::vec3(local[2])};
+        const glm::vec3 scale(glm::length(axes[0]), glm::length(axes[1]), glm::length(axes[2]));
+        for (int i = 0; i < 3; ++i)
+        {
+            axes[i] = scale[i] > 0.0f ? axes[i] / scale[i] : axes[i];
+        }
+        position_ = glm::vec3(local[3]);
+        rotation_ = glm::normalize(glm::quat_cast(glm::mat3(axes[0], axes[1], axes[2])));
+        scale_ = scale;
+        MarkLocalDirty();
+    }
+    MarkWorldDirty();
+}
 
+const glm::mat4 &Transform::LocalMatrix() const
+{
+    if (local_dirty_)
+    {
+        // T * R * S without going through generic matrix products
+        const glm::mat3 r = glm::mat3_cast(rotation_);
+        local_matrix_[0] = glm::vec4(r[0] * scale_.x, 0.0f);
+        local_matrix_[1] = glm::vec4(r[1] * scale_.y, 0.0f);
+        local_matrix_[2] = glm::vec4(r[2] * scale_.z, 0.0f);
+        local_matrix_[3] = glm::vec4(position_, 1.0f);
+        local_dirty_ = false;
+    }
+    return local_matrix_;
+}
+
+const glm::mat4 &Transform::LocalToWorld() const
+{
+    if (world_dirty_)
+    {
+        world_matrix_ = parent_ ? parent_->LocalToWorld() * LocalMatrix() : LocalMatrix();
+        world_dirty_ = false;
+        ++world_version_;
+    }
+    return world_matrix_;
+}
+
+void Transform::OnAttach()
+{
+    // Clones carry their source's parent; register now that our address is final
+    if (parent_)
+    {
+        parent_->children_.push_back(this);
+    }
+    if (owner_)
+    {
+        system_ = &owner_->GetScene()->GetTransformSystem();
+        system_->Track(*this);
+    }
+    MarkLocalDirty();
+}
+
+void Transform::OnDetach()
+{
+    SetParent(nullptr);
+    for (Transform *child : children_)
+    {
+        child->parent_ = nullptr;
+        child->MarkWorldDirty();
+    }
+    children_.clear();
+    if (system_)
+    {
+        system_->Untrack(StorageIndex());
+        system_ = nullptr;
+    }
+}
+
+void Transform::MarkLocalDirty()
+{
+    local_dirty_ = true;
+    if (system_)
+    {
+        system_->WriteLocal(*this);
+    }
+    MarkWorldDirty();
+}
+
+void Transform::MarkWorldDirty()
+{
+    // A dirty node always has dirty descendants, so propagation can stop here
+    if (world_dirty_)
+        return;
+    world_dirty_ = true;
+    if (system_)
+    {
+        system_->FlagWorldDirty(StorageIndex());
+    }
+    for (Transform *child : children_)
+    {
+        child->MarkWorldDirty();
+    }
+}
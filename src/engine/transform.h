@@ -2,24 +2,81 @@
 
 #include "component.h"
 #include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <vector>
 
+class TransformSystem;
+
+// Position/rotation/scale relative to an optional parent Transform.
+// Local and world matrices are cached and only rebuilt after a write to this
+// transform or one of its ancestors, so unchanged objects cost no matrix math.
+// Inside a scene, changes are also written through to the scene's
+// TransformSystem, which rebuilds them in bulk once per frame.
 class Transform : public Component
 {
 public:
-    glm::vec3 position{0.0f, 0.0f, 0.0f};
-    glm::vec3 rotation_euler{0.0f, 0.0f, 0.0f};
-    glm::vec3 scale{1.0f, 1.0f, 1.0f};
+    Transform() = default;
+
+    // Local-space TRS (relative to the parent, or world if there is none)
+    const glm::vec3 &GetPosition() const { return position_; }
+    const glm::quat &GetRotation() const { return rotation_; }
+    const glm::vec3 &GetScale() const { return scale_; }
+
+    void SetPosition(const glm::vec3 &position);
+    void SetRotation(const glm::quat &rotation);
+    void SetScale(const glm::vec3 &scale);
+    void Translate(const glm::vec3 &delta) { SetPosition(position_ + delta); }
+
+    // Euler helpers in degrees, applied in Y (yaw), X (pitch), Z (roll) order
+    void SetEulerAngles(const glm::vec3 &degrees);
+    glm::vec3 GetEulerAngles() const;
+
+    // Hierarchy. With keep_world_transform the local TRS is recomputed so the
+    // object stays where it is; otherwise the local TRS is kept as-is.
+    // Parenting a transform under itself or one of its descendants is ignored.
+    void SetParent(Transform *parent, bool keep_world_transform = false);
+    Transform *GetParent() const { return parent_; }
+    const std::vector<Transform *> &GetChildren() const { return children_; }
+
+    const glm::mat4 &LocalMatrix() const;
+    const glm::mat4 &LocalToWorld() const;
+    glm::vec3 GetWorldPosition() const { return glm::vec3(LocalToWorld()[3]); }
+    // Changes every time the world matrix is recomputed; lets caches of derived
+    // world-space data (bounds, spatial structures) detect movement cheaply
+    uint32_t WorldVersion() const { return world_version_; }
 
-    glm::mat4 LocalToWorld() const;
+    void OnAttach() override;
+    void OnDetach() override;
 
     std::unique_ptr<Component> Clone() const override
     {
         auto copy = std::make_unique<Transform>();
-        copy->position = position;
-        copy->rotation_euler = rotation_euler;
-        copy->scale = scale;
+        copy->position_ = position_;
+        copy->rotation_ = rotation_;
+        copy->scale_ = scale_;
+        // Linked to the parent (and the scene's TransformSystem) in OnAttach,
+        // once the clone has its final address
+        copy->parent_ = parent_;
         return copy;
     }
-};
 
+private:
+    friend class TransformSystem;
+
+    void MarkLocalDirty();
+    void MarkWorldDirty();
+
+    glm::vec3 position_{0.0f, 0.0f, 0.0f};
+    glm::quat rotation_{1.0f, 0.0f, 0.0f, 0.0f};
+    glm::vec3 scale_{1.0f, 1.0f, 1.0f};
 
+    Transform *parent_ = nullptr;
+    std::vector<Transform *> children_;
+    TransformSystem *system_ = nullptr;  // set while attached to a scene object
+
+    mutable glm::mat4 local_matrix_{1.0f};
+    mutable glm::mat4 world_matrix_{1.0f};
+    mutable bool local_dirty_ = true;
+    mutable bool world_dirty_ = true;
+    mutable uint32_t world_version_ = 0;
+};
@@ -0,0 +1,216 @@
+#include "transform_kernel.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define COOLGL_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(COOLGL_X86) && (defined(__GNUC__) || defined(__clang__))
+#define COOLGL_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define COOLGL_TARGET_AVX2
+#endif
+
+static void ComposeScalar(const TransformSoA &in, glm::mat4 *out, size_t begin, size_t end)
+{
+    for (size_t i = begin; i < end; ++i)
+    {
+        const float x = in.qx[i], y = in.qy[i], z = in.qz[i], w = in.qw[i];
+        const float x2 = x + x, y2 = y + y, z2 = z + z;
+        const float xx = x * x2, yy = y * y2, zz = z * z2;
+        const float xy = x * y2, xz = x * z2, yz = y * z2;
+        const float wx = w * x2, wy = w * y2, wz = w * z2;
+
+        glm::mat4 &m = out[i];
+        m[0] = glm::vec4((1.0f - (yy + zz)) * in.sx[i], (xy + wz) * in.sx[i], (xz - wy) * in.sx[i], 0.0f);
+        m[1] = glm::vec4((xy - wz) * in.sy[i], (1.0f - (xx + zz)) * in.sy[i], (yz + wx) * in.sy[i], 0.0f);
+        m[2] = glm::vec4((xz + wy) * in.sz[i], (yz - wx) * in.sz[i], (1.0f - (xx + yy)) * in.sz[i], 0.0f);
+        m[3] = glm::vec4(in.px[i], in.py[i], in.pz[i], 1.0f);
+    }
+}
+
+#if defined(COOLGL_X86)
+
+// Transposes four element-vectors (one lane per transform) into one matrix column
+// per transform and stores column `column` of out[0..3].
+static inline void StoreColumn4(glm::mat4 *out, int column, __m128 a, __m128 b, __m128 c, __m128 d)
+{
+    _MM_TRANSPOSE4_PS(a, b, c, d);
+    _mm_storeu_ps(&out[0][column][0], a);
+    _mm_storeu_ps(&out[1][column][0], b);
+    _mm_storeu_ps(&out[2][column][0], c);
+    _mm_storeu_ps(&out[3][column][0], d);
+}
+
+static void ComposeSSE2(const TransformSoA &in, glm::mat4 *out, size_t count)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 zero = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128 x = _mm_loadu_ps(in.qx + i);
+        const __m128 y = _mm_loadu_ps(in.qy + i);
+        const __m128 z = _mm_loadu_ps(in.qz + i);
+        const __m128 w = _mm_loadu_ps(in.qw + i);
+        const __m128 x2 = _mm_add_ps(x, x), y2 = _mm_add_ps(y, y), z2 = _mm_add_ps(z, z);
+        const __m128 xx = _mm_mul_ps(x, x2), yy = _mm_mul_ps(y, y2), zz = _mm_mul_ps(z, z2);
+        const __m128 xy = _mm_mul_ps(x, y2), xz = _mm_mul_ps(x, z2), yz = _mm_mul_ps(y, z2);
+        const __m128 wx = _mm_mul_ps(w, x2), wy = _mm_mul_ps(w, y2), wz = _mm_mul_ps(w, z2);
+
+        const __m128 sx = _mm_loadu_ps(in.sx + i);
+        const __m128 sy = _mm_loadu_ps(in.sy + i);
+        const __m128 sz = _mm_loadu_ps(in.sz + i);
+
+        StoreColumn4(out + i, 0,
+                     _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(yy, zz)), sx),
+                     _mm_mul_ps(_mm_add_ps(xy, wz), sx),
+                     _mm_mul_ps(_mm_sub_ps(xz, wy), sx),
+                     zero);
+        StoreColumn4(out + i, 1,
+                     _mm_mul_ps(_mm_sub_ps(xy, wz), sy),
+                     _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, zz)), sy),
+                     _mm_mul_ps(_mm_add_ps(yz, wx), sy),
+                     zero);
+        StoreColumn4(out + i, 2,
+                     _mm_mul_ps(_mm_add_ps(xz, wy), sz),
+                     _mm_mul_ps(_mm_sub_ps(yz, wx), sz),
+                     _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, yy)), sz),
+                     zero);
+        StoreColumn4(out + i, 3,
+                     _mm_loadu_ps(in.px + i),
+                     _mm_loadu_ps(in.py + i),
+                     _mm_loadu_ps(in.pz + i),
+                     one);
+    }
+    ComposeScalar(in, out, i, count);
+}
+
+COOLGL_TARGET_AVX2 static inline void StoreColumn8(glm::mat4 *out, int column, __m256 a, __m256 b, __m256 c, __m256 d)
+{
+    StoreColumn4(out, column, _mm256_castps256_ps128(a), _mm256_castps256_ps128(b),
+                 _mm256_castps256_ps128(c), _mm256_castps256_ps128(d));
+    StoreColumn4(out + 4, column, _mm256_extractf128_ps(a, 1), _mm256_extractf128_ps(b, 1),
+                 _mm256_extractf128_ps(c, 1), _mm256_extractf128_ps(d, 1));
+}
+
+COOLGL_TARGET_AVX2 static void ComposeAVX2(const TransformSoA &in, glm::mat4 *out, size_t count)
+{
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 zero = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256 x = _mm256_loadu_ps(in.qx + i);
+        const __m256 y = _mm256_loadu_ps(in.qy + i);
+        const __m256 z = _mm256_loadu_ps(in.qz + i);
+        const __m256 w = _mm256_loadu_ps(in.qw + i);
+        const __m256 x2 = _mm256_add_ps(x, x), y2 = _mm256_add_ps(y, y), z2 = _mm256_add_ps(z, z);
+        const __m256 xx = _mm256_mul_ps(x, x2), yy = _mm256_mul_ps(y, y2), zz = _mm256_mul_ps(z, z2);
+        const __m256 wx = _mm256_mul_ps(w, x2), wy = _mm256_mul_ps(w, y2), wz = _mm256_mul_ps(w, z2);
+
+        const __m256 sx = _mm256_loadu_ps(in.sx + i);
+        const __m256 sy = _mm256_loadu_ps(in.sy + i);
+        const __m256 sz = _mm256_loadu_ps(in.sz + i);
+
+        StoreColumn8(out + i, 0,
+                     _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(yy, zz)), sx),
+                     _mm256_mul_ps(_mm256_fmadd_ps(x, y2, wz), sx),
+                     _mm256_mul_ps(_mm256_fmsub_ps(x, z2, wy), sx),
+                     zero);
+        StoreColumn8(out + i, 1,
+                     _mm256_mul_ps(_mm256_fmsub_ps(x, y2, wz), sy),
+                     _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(xx, zz)), sy),
+                     _mm256_mul_ps(_mm256_fmadd_ps(y, z2, wx), sy),
+                     zero);
+        StoreColumn8(out + i, 2,
+                     _mm256_mul_ps(_mm256_fmadd_ps(x, z2, wy), sz),
+                     _mm256_mul_ps(_mm256_fmsub_ps(y, z2, wx), sz),
+                     _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(xx, yy)), sz),
+                     zero);
+        StoreColumn8(out + i, 3,
+                     _mm256_loadu_ps(in.px + i),
+                     _mm256_loadu_ps(in.py + i),
+                     _mm256_loadu_ps(in.pz + i),
+                     one);
+    }
+    ComposeSSE2(TransformSoA{in.px + i, in.py + i, in.pz + i, in.qx + i, in.qy + i, in.qz + i, in.qw + i,
+                             in.sx + i, in.sy + i, in.sz + i, count - i},
+                out + i, count - i);
+}
+
+static bool CpuSupportsAVX2()
+{
+#if defined(_MSC_VER)
+    int regs[4] = {0, 0, 0, 0};
+    __cpuid(regs, 1);
+    const bool osxsave = (regs[2] & (1 << 27)) != 0;
+    const bool fma = (regs[2] & (1 << 12)) != 0;
+    if (!osxsave || !fma)
+        return false;
+    // The OS must save YMM state for AVX to be usable
+    if ((_xgetbv(0) & 0x6) != 0x6)
+        return false;
+    __cpuidex(regs, 7, 0);
+    return (regs[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+}
+
+#endif // COOLGL_X86
+
+TransformKernel::Path TransformKernel::BestSupportedPath()
+{
+#if defined(COOLGL_X86)
+    static const Path best = CpuSupportsAVX2() ? Path::AVX2 : Path::SSE2;
+    return best;
+#else
+    return Path::Scalar;
+#endif
+}
+
+const char *TransformKernel::PathName(Path path)
+{
+    switch (path)
+    {
+    case Path::AVX2:
+        return "AVX2";
+    case Path::SSE2:
+        return "SSE2";
+    default:
+        return "Scalar";
+    }
+}
+
+void TransformKernel::ComposeMatrices(const TransformSoA &in, glm::mat4 *out)
+{
+    ComposeMatrices(in, out, BestSupportedPath());
+}
+
+void TransformKernel::ComposeMatrices(const TransformSoA &in, glm::mat4 *out, Path path)
+{
+    const Path best = BestSupportedPath();
+    if (path > best)
+    {
+        path = best;
+    }
+    switch (path)
+    {
+#if defined(COOLGL_X86)
+    case Path::AVX2:
+        ComposeAVX2(in, out, in.count);
+        break;
+    case Path::SSE2:
+        ComposeSSE2(in, out, in.count);
+        break;
+#endif
+    default:
+        ComposeScalar(in, out, 0, in.count);
+        break;
+    }
+}
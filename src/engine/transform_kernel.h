@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <glm/glm.hpp>
+
+// Structure-of-arrays view of translation/rotation/scale for a batch of transforms.
+// Rotation is a unit quaternion split into its x/y/z/w components.
+struct TransformSoA
+{
+    const float *px = nullptr;
+    const float *py = nullptr;
+    const float *pz = nullptr;
+    const float *qx = nullptr;
+    const float *qy = nullptr;
+    const float *qz = nullptr;
+    const float *qw = nullptr;
+    const float *sx = nullptr;
+    const float *sy = nullptr;
+    const float *sz = nullptr;
+    size_t count = 0;
+};
+
+// Bulk T * R * S matrix composition. The best available instruction set is
+// picked once at runtime (AVX2+FMA, then SSE2) with a portable scalar fallback.
+class TransformKernel
+{
+public:
+    enum class Path
+    {
+        Scalar,
+        SSE2,
+        AVX2
+    };
+
+    // Writes in.count matrices to `out`, using the best supported path
+    static void ComposeMatrices(const TransformSoA &in, glm::mat4 *out);
+
+    // Explicit paths (for benchmarking/validation). Requesting an unsupported
+    // path falls back to the best supported one.
+    static void ComposeMatrices(const TransformSoA &in, glm::mat4 *out, Path path);
+
+    static Path BestSupportedPath();
+    static const char *PathName(Path path);
+};
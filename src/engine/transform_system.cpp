@@ -0,0 +1,166 @@
+#include "transform_system.h"
+#include "transform_kernel.h"
+#include "job_system.h"
+
+#include <algorithm>
+#include <cstring>
+
+// Below this many dirty transforms per batch, threading costs more than it saves
+static constexpr size_t kParallelMinGrain = 1024;
+// Clean slots between two dirty ones that are composed anyway to keep one kernel run
+static constexpr uint32_t kMaxRunGap = 8;
+
+void TransformSystem::Track(const Transform &transform)
+{
+    const size_t slot = transform.StorageIndex();
+    if (slot >= flags_.size())
+    {
+        // Grown in steps so attaching many transforms does not resize every time
+        const size_t capacity = std::max(slot + 1, flags_.size() * 2);
+        for (auto &channel : channels_)
+        {
+            channel.resize(capacity, 0.0f);
+        }
+        matrices_.resize(capacity);
+        flags_.resize(capacity, 0);
+    }
+    WriteLocal(transform);
+    flags_[slot] |= kWorldDirty;
+}
+
+void TransformSystem::Untrack(uint32_t slot)
+{
+    flags_[slot] = 0;
+    removed_.push_back(slot);
+}
+
+void TransformSystem::WriteLocal(const Transform &transform)
+{
+    const size_t slot = transform.StorageIndex();
+    channels_[kPosX][slot] = transform.position_.x;
+    channels_[kPosY][slot] = transform.position_.y;
+    channels_[kPosZ][slot] = transform.position_.z;
+    channels_[kRotX][slot] = transform.rotation_.x;
+    channels_[kRotY][slot] = transform.rotation_.y;
+    channels_[kRotZ][slot] = transform.rotation_.z;
+    channels_[kRotW][slot] = transform.rotation_.w;
+    channels_[kScaleX][slot] = transform.scale_.x;
+    channels_[kScaleY][slot] = transform.scale_.y;
+    channels_[kScaleZ][slot] = transform.scale_.z;
+    flags_[slot] |= kLocalDirty;
+}
+
+void TransformSystem::Update(ComponentStorage<Transform> &transforms, JobSystem *jobs)
+{
+    last_removed_.swap(removed_);
+    removed_.clear();
+
+    // Flagged slots, eight flags at a time since most are usually clear
+    dirty_.clear();
+    const size_t slot_count = flags_.size();
+    size_t i = 0;
+    for (; i + 8 <= slot_count; i += 8)
+    {
+        uint64_t word;
+        std::memcpy(&word, flags_.data() + i, sizeof(word));
+        if (word == 0)
+            continue;
+        for (size_t k = i; k < i + 8; ++k)
+        {
+            if (flags_[k])
+                dirty_.push_back(static_cast<uint32_t>(k));
+        }
+    }
+    for (; i < slot_count; ++i)
+    {
+        if (flags_[i])
+            dirty_.push_back(static_cast<uint32_t>(i));
+    }
+
+    last_composed_count_ = 0;
+    for (uint32_t slot : dirty_)
+    {
+        last_composed_count_ += (flags_[slot] & kLocalDirty) != 0;
+    }
+    if (last_composed_count_ > 0)
+    {
+        if (jobs)
+        {
+            auto compose_range = [this, &transforms](size_t begin, size_t end)
+            {
+                ComposeRange(transforms, begin, end);
+            };
+            jobs->ParallelFor(dirty_.size(), kParallelMinGrain, compose_range);
+        }
+        else
+        {
+            ComposeRange(transforms, 0, dirty_.size());
+        }
+    }
+
+    // Children (and descendants of moved parents) resolve from cached locals;
+    // LocalToWorld pulls in dirty parents first
+    for (uint32_t slot : dirty_)
+    {
+        const Transform &t = transforms.At(slot);
+        if (t.world_dirty_)
+            t.LocalToWorld();
+        flags_[slot] = 0;
+    }
+}
+
+void TransformSystem::ComposeRange(ComponentStorage<Transform> &transforms, size_t begin, size_t end)
+{
+    size_t i = begin;
+    while (i < end)
+    {
+        if (!(flags_[dirty_[i]] & kLocalDirty))
+        {
+            ++i;
+            continue;
+        }
+        // One kernel run over [first, last], bridging short gaps of clean slots
+        const uint32_t first = dirty_[i];
+        uint32_t last = first;
+        size_t run_end = i + 1;
+        for (; run_end < end; ++run_end)
+        {
+            const uint32_t slot = dirty_[run_end];
+            if (slot - last > kMaxRunGap)
+                break;
+            if (flags_[slot] & kLocalDirty)
+                last = slot;
+        }
+
+        TransformSoA soa;
+        soa.px = channels_[kPosX].data() + first;
+        soa.py = channels_[kPosY].data() + first;
+        soa.pz = channels_[kPosZ].data() + first;
+        soa.qx = channels_[kRotX].data() + first;
+        soa.qy = channels_[kRotY].data() + first;
+        soa.qz = channels_[kRotZ].data() + first;
+        soa.qw = channels_[kRotW].data() + first;
+        soa.sx = channels_[kScaleX].data() + first;
+        soa.sy = channels_[kScaleY].data() + first;
+        soa.sz = channels_[kScaleZ].data() + first;
+        soa.count = last - first + 1;
+        TransformKernel::ComposeMatrices(soa, matrices_.data() + first);
+
+        // Scatter: roots need no parent product, so their world matrix is final too
+        for (; i < run_end; ++i)
+        {
+            const uint32_t slot = dirty_[i];
+            if (!(flags_[slot] & kLocalDirty))
+                continue;
+            Transform &t = transforms.At(slot);
+            t.local_matrix_ = matrices_[slot];
+            t.local_dirty_ = false;
+            if (!t.parent_ && t.world_dirty_)
+            {
+                t.world_matrix_ = matrices_[slot];
+                t.world_dirty_ = false;
+                ++t.world_version_;
+            }
+        }
+    }
+}
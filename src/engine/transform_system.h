@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "component_storage.h"
+#include "transform.h"
+
+class JobSystem;
+
+// Per-frame bulk refresh of Transform matrices. The system keeps the local TRS
+// of every scene transform in persistent SoA channels indexed by storage slot;
+// a transform writes through to them whenever it changes and flags its slot.
+// Update composes runs of flagged slots straight from the channels, one
+// TransformKernel call per run, then resolves world matrices parents-first for
+// the flagged slots only. Clean transforms are never visited.
+class TransformSystem
+{
+public:
+    // With `jobs`, composition and scatter of large batches are split across workers
+    void Update(ComponentStorage<Transform> &transforms, JobSystem *jobs = nullptr);
+
+    // Number of local matrices rebuilt by the last Update
+    size_t LastComposedCount() const { return last_composed_count_; }
+    // Slots whose world matrix changed in the last Update, in ascending order.
+    // Includes every transform attached since the Update before.
+    const std::vector<uint32_t> &LastMovedSlots() const { return dirty_; }
+    // Slots whose transform was detached between the last two Updates. A slot
+    // can be in both lists when a new transform took it over.
+    const std::vector<uint32_t> &LastRemovedSlots() const { return last_removed_; }
+
+private:
+    friend class Transform;
+
+    enum Flag : uint8_t
+    {
+        kLocalDirty = 1,
+        kWorldDirty = 2
+    };
+
+    // Called by Transform. Track and Untrack run when a transform is attached
+    // or detached; the others may run from parallel updates, each thread
+    // touching only its own transforms' slots.
+    void Track(const Transform &transform);
+    void Untrack(uint32_t slot);
+    void WriteLocal(const Transform &transform);
+    void FlagWorldDirty(uint32_t slot) { flags_[slot] |= kWorldDirty; }
+
+    // Composes the locally dirty slots among dirty_[begin, end) and writes the results back
+    void ComposeRange(ComponentStorage<Transform> &transforms, size_t begin, size_t end);
+
+    enum Channel
+    {
+        kPosX,
+        kPosY,
+        kPosZ,
+        kRotX,
+        kRotY,
+        kRotZ,
+        kRotW,
+        kScaleX,
+        kScaleY,
+        kScaleZ,
+        kChannelCount
+    };
+
+    std::vector<float> channels_[kChannelCount];
+    std::vector<glm::mat4> matrices_;
+    std::vector<uint8_t> flags_;
+    std::vector<uint32_t> dirty_;
+    std::vector<uint32_t> removed_;
+    std::vector<uint32_t> last_removed_;
+    size_t last_composed_count_ = 0;
+};
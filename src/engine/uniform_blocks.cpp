@@ -0,0 +1,28 @@
+#include "uniform_blocks.h"
+
+void UniformBlocks::BindProgram(GLuint program)
+{
+    const struct
+    {
+        const char *name;
+        GLuint binding;
+    } blocks[] = {{"FrameBlock", kFrameBinding}, {"MaterialBlock", kMaterialBinding}, {"DrawBlock", kDrawBinding}};
+    for (const auto &block : blocks)
+    {
+        const GLuint index = glGetUniformBlockIndex(program, block.name);
+        if (index != GL_INVALID_INDEX)
+            glUniformBlockBinding(program, index, block.binding);
+    }
+
+    const struct
+    {
+        const char *name;
+        GLint unit;
+    } samplers[] = {{"uAlbedo", kAlbedoUnit}, {"uShadowMap", kShadowMapUnit}};
+    for (const auto &sampler : samplers)
+    {
+        const GLint location = glGetUniformLocation(program, sampler.name);
+        if (location >= 0)
+            glProgramUniform1i(program, location, sampler.unit);
+    }
+}
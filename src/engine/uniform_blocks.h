@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include "light.h"
+
+// The interface lit shaders share with the renderer: three std140 uniform
+// blocks and the texture units of their samplers. Shader assigns the block
+// bindings and sampler units once at link time for any program declaring
+// them, so nothing is set per program at draw time.
+//
+// The structs mirror the GLSL blocks byte for byte (see shaders/lit.vert and
+// shaders/lit.frag); any change has to be made on both sides.
+class UniformBlocks
+{
+public:
+    static constexpr GLuint kFrameBinding = 0;
+    static constexpr GLuint kMaterialBinding = 1;
+    static constexpr GLuint kDrawBinding = 2;
+
+    static constexpr GLint kAlbedoUnit = 0;
+    static constexpr GLint kShadowMapUnit = 1;
+
+    // FrameBlock: camera, lights and shadow settings, uploaded once per frame
+    struct Frame
+    {
+        glm::mat4 view{1.0f};
+        glm::mat4 projection{1.0f};
+        glm::mat4 light_space{0.0f};
+        glm::vec3 camera_position{0.0f};
+        int32_t light_count = 0;
+        glm::vec4 light_dirs[Light::kMaxLights] = {};   // xyz; a vec3 array has a 16-byte stride
+        glm::vec4 light_colors[Light::kMaxLights] = {};
+        float shadow_bias = 0.0f;
+        int32_t pcf_samples = 0;
+        float padding_[2] = {};
+    };
+
+    // MaterialBlock: surface values, one per material change in a queue
+    struct Material
+    {
+        glm::vec3 color{1.0f};
+        float smoothness = 0.5f;
+        glm::vec3 ambient{0.0f};
+        int32_t use_texture = 0;
+    };
+
+    // DrawBlock: one per draw
+    struct Draw
+    {
+        glm::mat4 model{1.0f};
+        glm::vec4 position_decode{0.0f, 0.0f, 0.0f, 1.0f};   // Mesh::PositionDecode
+        int32_t instanced = 0;
+        int32_t packed_normals = 0;   // VertexFormat::Packed: normals come octahedral in aPackedNormal
+        int32_t padding_[2] = {};
+    };
+
+    // Assigns the blocks and samplers above in a freshly linked program; names
+    // the program does not declare are skipped
+    static void BindProgram(GLuint program);
+};
+
+static_assert(sizeof(UniformBlocks::Frame) == 352, "Frame must match FrameBlock's std140 layout");
+static_assert(sizeof(UniformBlocks::Material) == 32, "Material must match MaterialBlock's std140 layout");
+static_assert(sizeof(UniformBlocks::Draw) == 96, "Draw must match DrawBlock's std140 layout");
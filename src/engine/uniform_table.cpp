@@ -0,0 +1,41 @@
+#include "uniform_table.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+void UniformTable::Build(std::vector<UniformInfo> uniforms)
+{
+    // Stable, so names that hash alike stay next to each other in reflection order
+    std::stable_sort(uniforms.begin(), uniforms.end(),
+                     [](const UniformInfo &a, const UniformInfo &b) { return a.hash < b.hash; });
+    hashes_.clear();
+    for (const UniformInfo &info : uniforms)
+    {
+        hashes_.push_back(info.hash);
+    }
+    entries_ = std::move(uniforms);
+}
+
+const UniformInfo *UniformTable::Find(uint32_t hash, const char *name) const
+{
+    // Almost always a single entry; more only on a genuine hash collision
+    auto it = std::lower_bound(hashes_.begin(), hashes_.end(), hash);
+    for (; it != hashes_.end() && *it == hash; ++it)
+    {
+        const UniformInfo &info = entries_[static_cast<size_t>(it - hashes_.begin())];
+        if (std::strcmp(info.name.c_str(), name) == 0)
+            return &info;
+    }
+    return nullptr;
+}
+
+const UniformInfo *UniformTable::Find(UniformName name) const
+{
+    return Find(name.hash, name.text);
+}
+
+const UniformInfo *UniformTable::Find(const char *name) const
+{
+    return Find(HashUniformName(name), name);
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+// 32-bit FNV-1a of a uniform name
+constexpr uint32_t HashUniformName(const char *name)
+{
+    uint32_t hash = 2166136261u;
+    while (*name)
+    {
+        hash ^= static_cast<uint8_t>(*name++);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// A uniform name and its hash. Declared constexpr (e.g.
+// `static constexpr UniformName kTime{"u_time"};`) the hash is computed by the
+// compiler, and a lookup only has to confirm the one name it lands on.
+struct UniformName
+{
+    constexpr UniformName(const char *name) : text(name), hash(HashUniformName(name)) {}
+
+    const char *text;
+    uint32_t hash;
+};
+
+// Location of a uniform whose GLSL type matches T, resolved once through
+// Shader::uniform and then set with no lookup. Left at -1 when the program has
+// no such uniform, which GL ignores like any other -1 location.
+template <typename T>
+struct Uniform
+{
+    GLint location = -1;
+
+    bool valid() const { return location >= 0; }
+};
+
+// Which GLSL types a Uniform<T> may refer to
+template <typename T>
+struct UniformTypeTraits;
+
+template <>
+struct UniformTypeTraits<glm::mat4>
+{
+    static bool Matches(GLenum type) { return type == GL_FLOAT_MAT4; }
+};
+
+template <>
+struct UniformTypeTraits<glm::vec3>
+{
+    static bool Matches(GLenum type) { return type == GL_FLOAT_VEC3; }
+};
+
+template <>
+struct UniformTypeTraits<float>
+{
+    static bool Matches(GLenum type) { return type == GL_FLOAT; }
+};
+
+template <>
+struct UniformTypeTraits<int>
+{
+    // Booleans and samplers are set as ints too
+    static bool Matches(GLenum type)
+    {
+        return type == GL_INT || type == GL_BOOL || type == GL_SAMPLER_2D || type == GL_SAMPLER_CUBE ||
+               type == GL_SAMPLER_2D_SHADOW || type == GL_SAMPLER_3D;
+    }
+};
+
+// One active default-block uniform, as reported at link time. An array is
+// listed under its bare name and under each element ("a", "a[0]", "a[1]", ...);
+// other names, such as struct members ("s[0].x"), are listed as reported.
+struct UniformInfo
+{
+    uint32_t hash = 0;
+    GLint location = -1;
+    GLenum type = 0;
+    GLint array_size = 1;
+    std::string name;
+};
+
+struct UniformBlockInfo
+{
+    GLuint index = 0;
+    GLint data_size = 0;   // bytes the block needs bound
+    std::string name;
+};
+
+// A program's active uniforms in one flat array ordered by name hash, so a
+// lookup is a binary search over a few contiguous integers rather than a
+// string hash and a node walk. Names that hash alike sit next to each other
+// and are told apart by comparing the text.
+class UniformTable
+{
+public:
+    void Build(std::vector<UniformInfo> uniforms);
+
+    // Both confirm the match by comparing the name; UniformName skips the hashing
+    const UniformInfo *Find(UniformName name) const;
+    const UniformInfo *Find(const char *name) const;
+
+    const std::vector<UniformInfo> &Entries() const { return entries_; }
+
+private:
+    const UniformInfo *Find(uint32_t hash, const char *name) const;
+
+    std::vector<uint32_t> hashes_;   // sorted; parallel to entries_
+    std::vector<UniformInfo> entries_;
+};
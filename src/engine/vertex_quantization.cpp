@@ -0,0 +1,214 @@
+#include "vertex_quantization.h"
+
+#include "mesh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <glad/glad.h>
+
+static float SignNotZero(float value)
+{
+    return value >= 0.0f ? 1.0f : -1.0f;
+}
+
+glm::vec4 VertexQuantization::PositionDecode(const Aabb &bounds)
+{
+    if (bounds.IsEmpty())
+        return glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    const glm::vec3 size = bounds.max - bounds.min;
+    const float scale = std::max({size.x, size.y, size.z});
+    return glm::vec4(bounds.min, scale > 0.0f ? scale : 1.0f);
+}
+
+glm::vec2 VertexQuantization::OctahedralEncode(const glm::vec3 &normal)
+{
+    const float l1 = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+    if (l1 == 0.0f)
+        return glm::vec2(0.0f);
+    glm::vec2 encoded(normal.x / l1, normal.y / l1);
+    if (normal.z < 0.0f)
+    {
+        // Fold the lower hemisphere over the diagonals
+        encoded = glm::vec2((1.0f - std::abs(encoded.y)) * SignNotZero(encoded.x),
+                            (1.0f - std::abs(encoded.x)) * SignNotZero(encoded.y));
+    }
+    return encoded;
+}
+
+glm::vec3 VertexQuantization::OctahedralDecode(const glm::vec2 &encoded)
+{
+    glm::vec3 normal(encoded.x, encoded.y, 1.0f - std::abs(encoded.x) - std::abs(encoded.y));
+    if (normal.z < 0.0f)
+    {
+        const float x = normal.x;
+        normal.x = (1.0f - std::abs(normal.y)) * SignNotZero(x);
+        normal.y = (1.0f - std::abs(x)) * SignNotZero(normal.y);
+    }
+    return glm::normalize(normal);
+}
+
+uint16_t VertexQuantization::FloatToHalf(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const uint32_t sign = (bits >> 16) & 0x8000u;
+    const uint32_t float_exponent = (bits >> 23) & 0xffu;
+    uint32_t mantissa = bits & 0x7fffffu;
+    if (float_exponent == 0xffu)
+        return static_cast<uint16_t>(sign | 0x7c00u | (mantissa ? 0x200u : 0u));   // inf, nan
+
+    const int32_t exponent = static_cast<int32_t>(float_exponent) - 127 + 15;
+    if (exponent >= 31)
+        return static_cast<uint16_t>(sign | 0x7c00u);
+    if (exponent <= 0)
+    {
+        // Subnormal half, or zero
+        if (exponent < -10)
+            return static_cast<uint16_t>(sign);
+        mantissa |= 0x800000u;
+        const uint32_t shift = static_cast<uint32_t>(14 - exponent);
+        uint32_t half = mantissa >> shift;
+        const uint32_t rest = mantissa & ((1u << shift) - 1u);
+        const uint32_t halfway = 1u << (shift - 1u);
+        if (rest > halfway || (rest == halfway && (half & 1u)))
+            ++half;
+        return static_cast<uint16_t>(sign | half);
+    }
+
+    uint32_t half = (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+    const uint32_t rest = mantissa & 0x1fffu;
+    // A carry out of the mantissa bumps the exponent, which is the right result
+    if (rest > 0x1000u || (rest == 0x1000u && (half & 1u)))
+        ++half;
+    return static_cast<uint16_t>(sign | half);
+}
+
+float VertexQuantization::HalfToFloat(uint16_t value)
+{
+    const uint32_t sign = static_cast<uint32_t>(value & 0x8000u) << 16;
+    const uint32_t exponent = (value >> 10) & 0x1fu;
+    const uint32_t mantissa = value & 0x3ffu;
+    if (exponent == 0)
+    {
+        const float magnitude = std::ldexp(static_cast<float>(mantissa), -24);
+        return sign ? -magnitude : magnitude;
+    }
+    uint32_t bits;
+    if (exponent == 31)
+        bits = sign | 0x7f800000u | (mantissa << 13);
+    else
+        bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+    float result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+static uint16_t ToUnorm16(float value)
+{
+    return static_cast<uint16_t>(std::lround(std::min(std::max(value, 0.0f), 1.0f) * 65535.0f));
+}
+
+// The shaders read normals as plain shorts and divide, which decodes the same
+// on every GL version (snorm conversion changed in 4.2)
+static float FromSnorm16(int16_t value)
+{
+    return std::max(static_cast<float>(value) / 32767.0f, -1.0f);
+}
+
+// Of the four snorm16 pairs around the exact encoding, the one decoding closest to `normal`
+static void PackNormal(const glm::vec3 &normal, int16_t out[2])
+{
+    const glm::vec2 exact = VertexQuantization::OctahedralEncode(normal) * 32767.0f;
+    float best = 4.0f;
+    for (int corner = 0; corner < 4; ++corner)
+    {
+        const float x = std::min(std::max(corner & 1 ? std::ceil(exact.x) : std::floor(exact.x), -32767.0f), 32767.0f);
+        const float y = std::min(std::max(corner & 2 ? std::ceil(exact.y) : std::floor(exact.y), -32767.0f), 32767.0f);
+        const glm::vec3 decoded = VertexQuantization::OctahedralDecode(glm::vec2(x, y) / 32767.0f);
+        // Distance rather than the dot product, which rounds to 1 at these angles
+        const glm::vec3 difference = decoded - normal;
+        const float distance = glm::dot(difference, difference);
+        if (distance < best)
+        {
+            best = distance;
+            out[0] = static_cast<int16_t>(x);
+            out[1] = static_cast<int16_t>(y);
+        }
+    }
+}
+
+std::vector<PackedVertex> VertexQuantization::Pack(const MeshVertex *vertices, size_t count, const Aabb &bounds,
+                                                   QuantizationError *error)
+{
+    const glm::vec4 decode = PositionDecode(bounds);
+    const glm::vec3 origin(decode);
+    const float inverse_scale = 1.0f / decode.w;
+
+    std::vector<PackedVertex> packed(count);
+    QuantizationError measured;
+    double squared_sum = 0.0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        const MeshVertex &source = vertices[i];
+        PackedVertex &out = packed[i];
+        const glm::vec3 position = (source.position - origin) * inverse_scale;
+        out.position[0] = ToUnorm16(position.x);
+        out.position[1] = ToUnorm16(position.y);
+        out.position[2] = ToUnorm16(position.z);
+        out.padding = 0;
+        const float length = glm::length(source.normal);
+        const glm::vec3 normal = length > 0.0f ? source.normal / length : glm::vec3(0.0f);
+        PackNormal(normal, out.normal);
+        out.uv[0] = FloatToHalf(source.uv.x);
+        out.uv[1] = FloatToHalf(source.uv.y);
+
+        if (!error)
+            continue;
+        const MeshVertex decoded = Unpack(out, decode);
+        const float position_error = glm::length(decoded.position - source.position);
+        measured.max_position = std::max(measured.max_position, position_error);
+        squared_sum += static_cast<double>(position_error) * position_error;
+        if (length > 0.0f)
+        {
+            // atan2 keeps its precision for tiny angles, where acos of the dot does not
+            const float angle =
+                std::atan2(glm::length(glm::cross(normal, decoded.normal)), glm::dot(normal, decoded.normal));
+            measured.max_normal_degrees = std::max(measured.max_normal_degrees, glm::degrees(angle));
+        }
+        measured.max_uv = std::max({measured.max_uv, std::abs(decoded.uv.x - source.uv.x),
+                                    std::abs(decoded.uv.y - source.uv.y)});
+    }
+    if (error)
+    {
+        measured.rms_position = count ? static_cast<float>(std::sqrt(squared_sum / static_cast<double>(count))) : 0.0f;
+        *error = measured;
+    }
+    return packed;
+}
+
+MeshVertex VertexQuantization::Unpack(const PackedVertex &packed, const glm::vec4 &position_decode)
+{
+    MeshVertex vertex;
+    const glm::vec3 stored(packed.position[0] / 65535.0f, packed.position[1] / 65535.0f, packed.position[2] / 65535.0f);
+    vertex.position = glm::vec3(position_decode) + stored * position_decode.w;
+    vertex.normal = OctahedralDecode(glm::vec2(FromSnorm16(packed.normal[0]), FromSnorm16(packed.normal[1])));
+    vertex.uv = glm::vec2(HalfToFloat(packed.uv[0]), HalfToFloat(packed.uv[1]));
+    return vertex;
+}
+
+void VertexQuantization::SetAttributes()
+{
+    glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex), (void *)offsetof(PackedVertex, position));
+    glEnableVertexAttribArray(0);
+
+    // Float normals are not read; the shaders take aPackedNormal instead
+    glDisableVertexAttribArray(1);
+
+    glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(PackedVertex), (void *)offsetof(PackedVertex, uv));
+    glEnableVertexAttribArray(2);
+
+    glVertexAttribPointer(7, 2, GL_SHORT, GL_FALSE, sizeof(PackedVertex), (void *)offsetof(PackedVertex, normal));
+    glEnableVertexAttribArray(7);
+}
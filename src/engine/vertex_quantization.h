@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "bounds.h"
+
+struct MeshVertex;
+
+// How a mesh's vertices are stored on the GPU
+enum class VertexFormat : uint8_t
+{
+    Float,    // MeshVertex, 32 bytes
+    Packed,   // PackedVertex, 16 bytes
+};
+
+// 16-byte vertex: position as 16-bit unorm relative to the mesh bounds,
+// normal octahedral-encoded in two 16-bit snorms, uv as two half floats.
+// The shaders decode positions with DrawBlock's uPositionDecode.
+struct PackedVertex
+{
+    uint16_t position[3];
+    uint16_t padding;
+    int16_t normal[2];
+    uint16_t uv[2];
+};
+
+static_assert(sizeof(PackedVertex) == 16, "PackedVertex must stay 16 bytes");
+
+// Worst-case (and RMS, for positions) difference between the source vertices
+// and what the GPU decodes from their packed form
+struct QuantizationError
+{
+    float max_position = 0.0f;       // object-space units
+    float rms_position = 0.0f;
+    float max_normal_degrees = 0.0f;
+    float max_uv = 0.0f;             // per component
+};
+
+class VertexQuantization
+{
+public:
+    // Positions are stored relative to bounds.min over its largest extent, so
+    // one scale decodes all three axes: object = xyz + stored * w
+    static glm::vec4 PositionDecode(const Aabb &bounds);
+
+    // Packs `count` vertices for a mesh with these bounds; fills `error` if given
+    static std::vector<PackedVertex> Pack(const MeshVertex *vertices, size_t count, const Aabb &bounds,
+                                          QuantizationError *error = nullptr);
+    // What the GPU reads back from `packed`
+    static MeshVertex Unpack(const PackedVertex &packed, const glm::vec4 &position_decode);
+
+    // Attributes 0, 2 and 7 (the octahedral normal) read PackedVertex from
+    // GL_ARRAY_BUFFER into the bound VAO; attribute 1 is left disabled
+    static void SetAttributes();
+
+    // Octahedral mapping of a unit vector to [-1, 1]^2 and back
+    static glm::vec2 OctahedralEncode(const glm::vec3 &normal);
+    static glm::vec3 OctahedralDecode(const glm::vec2 &encoded);
+
+    // IEEE 754 binary16, rounded to nearest even
+    static uint16_t FloatToHalf(float value);
+    static float HalfToFloat(uint16_t value);
+};
@@ -1,5 +1,7 @@
 #include "window.h"
 
+#include "gl_state_cache.h"
+
 #include <glad/glad.h>
 #include <stdexcept>
 
@@ -41,7 +43,7 @@ Window::Window(int width, int height, const char *title)
         throw std::runtime_error("Failed to initialize GLAD");
     }
 
-    glViewport(0, 0, width_, height_);
+    GLStateCache::GetInstance().SetViewport(0, 0, width_, height_);
 }
 
 Window::~Window()
@@ -80,5 +82,5 @@ void Window::FramebufferSizeCallback(GLFWwindow *window, int width, int height)
             self->height_ = height;
         }
     }
-    glViewport(0, 0, width, height);
+    GLStateCache::GetInstance().SetViewport(0, 0, width, height);
 }